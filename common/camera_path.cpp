@@ -0,0 +1,60 @@
+#include "camera_path.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static const char orbit_prefix[] = "orbit:";
+
+bool read_camera_path(const char *spec, const affine_transform<double>& start,
+        camera_placer place, vector<affine_transform<double> >& cameras) {
+    cameras.clear();
+    size_t prefix_length = strlen(orbit_prefix);
+    if (strncmp(spec, orbit_prefix, prefix_length) == 0) {
+        int frame_count = atoi(spec + prefix_length);
+        if (frame_count <= 0) {
+            fprintf(stderr, "read_camera_path ERROR an orbit needs at least "
+                    "one frame, not %s\n", spec + prefix_length);
+            return false;
+        }
+        for (int frame = 0; frame < frame_count; frame++) {
+            double angle = 2 * M_PI * frame / frame_count;
+            cameras.push_back(rotation_transform(0.0, 1.0, 0.0, angle)
+                    * start);
+        }
+        return true;
+    }
+
+    ifstream infile(spec);
+    if (!infile) {
+        fprintf(stderr, "read_camera_path ERROR couldn't open file %s\n", spec);
+        return false;
+    }
+    string line;
+    int line_number = 0;
+    while (getline(infile, line)) {
+        line_number++;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#')
+            continue;
+        istringstream iss(line);
+        camera_pose pose;
+        if (!(iss >> pose.x >> pose.y >> pose.z >> pose.axis_x >> pose.axis_y
+                    >> pose.axis_z >> pose.angle)) {
+            fprintf(stderr, "read_camera_path ERROR line %d of %s isn't a "
+                    "camera\n", line_number, spec);
+            return false;
+        }
+        cameras.push_back(place(pose));
+    }
+    if (cameras.empty()) {
+        fprintf(stderr, "read_camera_path ERROR %s has no cameras\n", spec);
+        return false;
+    }
+    return true;
+}
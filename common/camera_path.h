@@ -0,0 +1,46 @@
+#ifndef CAMERA_PATH_H
+#define CAMERA_PATH_H
+
+#include <vector>
+#include "transform.h"
+
+using namespace std;
+
+/*******************************************************************************
+ * Defines the camera paths animations are rendered along. A path is given
+ * either as
+ *
+ *     orbit:N     N frames taking the scene file's camera once around the
+ *                 world's y axis, so the scene seems to spin on a turntable
+ *     a file      one camera per frame, one per line, as
+ *                 "x y z axis_x axis_y axis_z angle": a position, and a
+ *                 rotation by angle radians about an axis, just like a scene
+ *                 file's camera. Blank lines and lines starting with # are
+ *                 skipped
+ *
+ * Each frame's camera comes out as a camera transform, the one taking camera
+ * space to world space, so a renderer only has to invert it for each frame.
+ ******************************************************************************/
+
+// A camera as a scene file places it
+struct camera_pose {
+    double x;
+    double y;
+    double z;
+    double axis_x;
+    double axis_y;
+    double axis_z;
+    double angle;
+};
+
+// Builds the camera transform of a pose the way a renderer reads its scene
+// files' cameras
+typedef affine_transform<double> (*camera_placer)(const camera_pose& pose);
+
+// Reads the camera transform of every frame of the path spec names. start is
+// the scene file's camera, which an orbit starts from. Prints an error and
+// returns false if spec can't be read
+bool read_camera_path(const char *spec, const affine_transform<double>& start,
+        camera_placer place, vector<affine_transform<double> >& cameras);
+
+#endif
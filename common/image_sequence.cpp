@@ -0,0 +1,49 @@
+#include "image_sequence.h"
+#include <stdio.h>
+
+using namespace std;
+
+image_sequence_writer::image_sequence_writer(const string& prefix, int xres,
+        int yres, image_format format) : prefix(prefix), xres(xres),
+        yres(yres), format(format), frame(0), succeeded(true) {}
+
+image_sequence_writer::~image_sequence_writer() {
+    wait();
+}
+
+/*
+ * Waits for the frame being written, if there is one.
+ */
+void image_sequence_writer::wait() {
+    if (worker.joinable())
+        worker.join();
+}
+
+bool image_sequence_writer::write_frame(vector<unsigned char>& rgb) {
+    wait();
+    if (!succeeded)
+        return false;
+    pending.swap(rgb);
+
+    char number[16];
+    sprintf(number, "%04d", frame++);
+    string filename = prefix + number
+        + ((format == PNG_IMAGE) ? ".png" : ".ppm");
+    worker = thread([this, filename]() {
+        FILE *file = fopen(filename.c_str(), "wb");
+        if (file == NULL) {
+            fprintf(stderr, "image_sequence_writer ERROR couldn't open file "
+                    "%s\n", filename.c_str());
+            succeeded = false;
+            return;
+        }
+        succeeded = write_image(file, pending.data(), xres, yres, format);
+        succeeded = (fclose(file) == 0) && succeeded;
+    });
+    return true;
+}
+
+bool image_sequence_writer::finish() {
+    wait();
+    return succeeded;
+}
@@ -0,0 +1,48 @@
+#ifndef IMAGE_SEQUENCE_H
+#define IMAGE_SEQUENCE_H
+
+#include <string>
+#include <thread>
+#include <vector>
+#include "image_writer.h"
+
+using namespace std;
+
+/*******************************************************************************
+ * Defines the writer animations are output with, as a numbered image per
+ * frame: prefix0000.ppm, prefix0001.ppm and so on (or .png).
+ *
+ * Each frame is encoded and written on a background thread while the next
+ * one is rendered. The frame's pixels are swapped into the writer rather than
+ * copied, and the caller gets back the buffer of the frame before, whose
+ * writing is done by then, so the two buffers take turns and nothing is
+ * allocated once both exist.
+ ******************************************************************************/
+
+struct image_sequence_writer {
+    string prefix;
+    int xres;
+    int yres;
+    image_format format;
+
+    image_sequence_writer(const string& prefix, int xres, int yres,
+            image_format format);
+    ~image_sequence_writer();
+    // Starts writing the next frame, 3 * xres * yres bytes, top row first.
+    // rgb is left holding a buffer to render the frame after into. Returns
+    // false if an earlier frame couldn't be written
+    bool write_frame(vector<unsigned char>& rgb);
+    // Waits for the last frame to be written. Returns false if any frame
+    // couldn't be
+    bool finish();
+
+    // The frame being written, and its number
+    vector<unsigned char> pending;
+    int frame;
+    thread worker;
+    bool succeeded;
+
+    void wait();
+};
+
+#endif
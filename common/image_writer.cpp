@@ -0,0 +1,276 @@
+#include "image_writer.h"
+#include <string.h>
+#include <algorithm>
+
+using namespace std;
+
+static const unsigned char png_signature[8] = {0x89, 'P', 'N', 'G', '\r',
+    '\n', 0x1a, '\n'};
+// The most a stored deflate block holds
+static const size_t png_stored_block_size = 65535;
+// Adler-32 sums stay below 2^32 for this many bytes between reductions
+static const size_t adler_run_size = 5552;
+static const uint32_t adler_modulus = 65521;
+
+// The text of a channel value in a P3 image
+struct decimal_text {
+    char text[4];
+    int length;
+};
+
+// The text of each value from 0 to 255
+struct decimal_texts {
+    decimal_text values[256];
+    decimal_texts() {
+        for (int value = 0; value < 256; value++)
+            values[value].length = sprintf(values[value].text, "%d", value);
+    }
+};
+
+/*
+ * Returns the text of each value from 0 to 255, worked out the first time
+ * it's needed. The table is a function-local static, so it is built exactly
+ * once even if several threads write images at the same time.
+ */
+static const decimal_text *decimal_table() {
+    static const decimal_texts table;
+    return table.values;
+}
+
+// The CRC-32 of each byte
+struct crc_values {
+    uint32_t values[256];
+    crc_values() {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+            values[n] = c;
+        }
+    }
+};
+
+/*
+ * Returns the CRC-32 of each byte, the table PNG chunk checksums are worked
+ * out with. It's built the same way as decimal_table's.
+ */
+static const uint32_t *crc_table() {
+    static const crc_values table;
+    return table.values;
+}
+
+static uint32_t update_crc(uint32_t crc, const unsigned char *data,
+        size_t size) {
+    const uint32_t *table = crc_table();
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+static uint32_t update_adler(uint32_t adler, const unsigned char *data,
+        size_t size) {
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    while (size > 0) {
+        size_t run = min(size, adler_run_size);
+        for (size_t i = 0; i < run; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= adler_modulus;
+        b %= adler_modulus;
+        data += run;
+        size -= run;
+    }
+    return (b << 16) | a;
+}
+
+static void append(vector<unsigned char>& to, const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char *) data;
+    to.insert(to.end(), bytes, bytes + size);
+}
+
+// PNG stores its numbers most significant byte first
+static void append_big_endian(vector<unsigned char>& to, uint32_t value) {
+    unsigned char bytes[4] = {(unsigned char) (value >> 24),
+        (unsigned char) (value >> 16), (unsigned char) (value >> 8),
+        (unsigned char) value};
+    append(to, bytes, 4);
+}
+
+bool parse_image_format(const char *name, image_format& format) {
+    if (strcmp(name, "p3") == 0)
+        format = P3_IMAGE;
+    else if (strcmp(name, "p6") == 0)
+        format = P6_IMAGE;
+    else if (strcmp(name, "png") == 0)
+        format = PNG_IMAGE;
+    else
+        return false;
+    return true;
+}
+
+image_writer::image_writer(FILE *file, int xres, int yres,
+        image_format format) : file(file), xres(xres), yres(yres),
+        format(format), png_adler(1), png_started(false), rows_written(0) {
+    buffer.reserve(image_write_size + png_stored_block_size);
+    write_header();
+}
+
+void image_writer::write_header() {
+    if (format == PNG_IMAGE) {
+        append(buffer, png_signature, sizeof(png_signature));
+        vector<unsigned char> header;
+        append_big_endian(header, xres);
+        append_big_endian(header, yres);
+        // 8 bits per channel, RGB, and the only compression, filtering and
+        // (no) interlacing there are
+        unsigned char layout[5] = {8, 2, 0, 0, 0};
+        append(header, layout, sizeof(layout));
+        write_png_chunk("IHDR", header.data(), header.size());
+    } else {
+        char header[64];
+        int length = sprintf(header, "%s\n%d %d\n255\n",
+                (format == P3_IMAGE) ? "P3" : "P6", xres, yres);
+        append(buffer, header, length);
+    }
+}
+
+void image_writer::write_buffer() {
+    fwrite(buffer.data(), 1, buffer.size(), file);
+    buffer.clear();
+}
+
+/*
+ * Adds a PNG chunk to the buffer: its size, type and data, followed by a
+ * checksum of the type and data.
+ */
+void image_writer::write_png_chunk(const char *type, const unsigned char *data,
+        size_t size) {
+    append_big_endian(buffer, size);
+    append(buffer, type, 4);
+    append(buffer, data, size);
+    uint32_t crc = update_crc(0xffffffff, (const unsigned char *) type, 4);
+    crc = update_crc(crc, data, size);
+    append_big_endian(buffer, crc ^ 0xffffffff);
+}
+
+/*
+ * Stores as many full blocks of the waiting PNG rows as there are in an IDAT
+ * chunk, or all of them along with the end of the zlib stream if last is set.
+ */
+void image_writer::write_png_data(bool last) {
+    size_t stored = last ? png_data.size()
+        : png_data.size() / png_stored_block_size * png_stored_block_size;
+    if (stored == 0 && !last)
+        return;
+
+    vector<unsigned char> chunk;
+    chunk.reserve(stored + stored / png_stored_block_size * 5 + 16);
+    if (!png_started) {
+        // A zlib stream with a 32K window and no preset dictionary
+        unsigned char zlib_header[2] = {0x78, 0x01};
+        append(chunk, zlib_header, 2);
+        png_started = true;
+    }
+    size_t offset = 0;
+    do {
+        size_t size = min(png_stored_block_size, stored - offset);
+        bool final = last && offset + size == stored;
+        unsigned char block_header[5] = {(unsigned char) final,
+            (unsigned char) size, (unsigned char) (size >> 8),
+            (unsigned char) ~size, (unsigned char) (~size >> 8)};
+        append(chunk, block_header, sizeof(block_header));
+        append(chunk, png_data.data() + offset, size);
+        offset += size;
+    } while (offset < stored);
+    if (last)
+        append_big_endian(chunk, png_adler);
+
+    write_png_chunk("IDAT", chunk.data(), chunk.size());
+    png_data.erase(png_data.begin(), png_data.begin() + stored);
+}
+
+void image_writer::write_rows(const unsigned char *rgb, int rows) {
+    size_t row_size = 3 * (size_t) xres;
+    rows_written += rows;
+
+    if (format == P6_IMAGE) {
+        // The pixels are already laid out the way the file wants them, so a
+        // few rows are gathered up, and many go straight out
+        size_t size = row_size * rows;
+        if (buffer.size() + size <= image_write_size) {
+            append(buffer, rgb, size);
+        } else {
+            write_buffer();
+            fwrite(rgb, 1, size, file);
+        }
+        return;
+    }
+
+    if (format == P3_IMAGE) {
+        const decimal_text *table = decimal_table();
+        for (int y = 0; y < rows; y++) {
+            const unsigned char *row = rgb + y * row_size;
+            for (size_t i = 0; i < row_size; i += 3) {
+                const decimal_text& r = table[row[i]];
+                const decimal_text& g = table[row[i + 1]];
+                const decimal_text& b = table[row[i + 2]];
+                char line[16];
+                char *p = line;
+                memcpy(p, r.text, 4);
+                p += r.length;
+                *p++ = ' ';
+                memcpy(p, g.text, 4);
+                p += g.length;
+                *p++ = ' ';
+                memcpy(p, b.text, 4);
+                p += b.length;
+                *p++ = '\n';
+                append(buffer, line, p - line);
+            }
+            if (buffer.size() >= image_write_size)
+                write_buffer();
+        }
+        return;
+    }
+
+    for (int y = 0; y < rows; y++) {
+        // Each row starts with its filter type, which is 0 for none
+        const unsigned char *row = rgb + y * row_size;
+        png_data.push_back(0);
+        append(png_data, row, row_size);
+        png_adler = update_adler(png_adler, png_data.data() + png_data.size()
+                - row_size - 1, row_size + 1);
+        if (png_data.size() >= image_write_size) {
+            write_png_data(false);
+            write_buffer();
+        }
+    }
+}
+
+bool image_writer::finish() {
+    if (format == PNG_IMAGE) {
+        write_png_data(true);
+        write_png_chunk("IEND", NULL, 0);
+    }
+    write_buffer();
+    fflush(file);
+    if (ferror(file)) {
+        fprintf(stderr, "image_writer ERROR couldn't write the image\n");
+        return false;
+    }
+    if (rows_written != yres) {
+        fprintf(stderr, "image_writer ERROR wrote %d of the image's %d rows\n",
+                rows_written, yres);
+        return false;
+    }
+    return true;
+}
+
+bool write_image(FILE *file, const unsigned char *rgb, int xres, int yres,
+        image_format format) {
+    image_writer writer(file, xres, yres, format);
+    writer.write_rows(rgb, yres);
+    return writer.finish();
+}
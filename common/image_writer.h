@@ -0,0 +1,76 @@
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************
+ * Defines the image writer every renderer outputs its pictures with. Images
+ * are 8 bit RGB, and can be written as
+ *
+ *     p3      an ASCII PPM, one pixel per line
+ *     p6      a binary PPM, the default
+ *     png     a PNG
+ *
+ * Rows are handed to the writer top row first, either all at once or a few at
+ * a time as they're finished, and are encoded straight into a buffer that
+ * goes out in large writes. Nothing is formatted through streams, and nothing
+ * is flushed per pixel.
+ *
+ * PNGs use deflate's stored blocks, which copy the pixels through rather than
+ * compressing them, so writing one costs about as much as writing a binary
+ * PPM and the writer needs no compression library. The files are the size of
+ * the raw pixels.
+ ******************************************************************************/
+
+enum image_format {
+    P3_IMAGE,
+    P6_IMAGE,
+    PNG_IMAGE
+};
+
+// The buffered output is written out whenever it grows past this many bytes
+static const size_t image_write_size = 1 << 20;
+
+// Sets format to the one called name (p3, p6 or png). Returns false for any
+// other name
+bool parse_image_format(const char *name, image_format& format);
+
+// Writes an image to a file a few rows at a time
+struct image_writer {
+    FILE *file;
+    int xres;
+    int yres;
+    image_format format;
+
+    image_writer(FILE *file, int xres, int yres, image_format format);
+    // Writes the next rows of the image, 3 * xres bytes per row
+    void write_rows(const unsigned char *rgb, int rows);
+    // Writes whatever's left after the last row. Prints an error and returns
+    // false if any of the image couldn't be written
+    bool finish();
+
+    // Encoded bytes waiting to be written
+    vector<unsigned char> buffer;
+    // The rows not yet stored in a PNG, each behind its filter byte
+    vector<unsigned char> png_data;
+    uint32_t png_adler;
+    // Whether the zlib stream the rows are stored in has been started
+    bool png_started;
+    int rows_written;
+
+    void write_header();
+    void write_buffer();
+    void write_png_chunk(const char *type, const unsigned char *data,
+            size_t size);
+    void write_png_data(bool last);
+};
+
+// Writes a whole image, 3 * xres * yres bytes, top row first
+bool write_image(FILE *file, const unsigned char *rgb, int xres, int yres,
+        image_format format);
+
+#endif
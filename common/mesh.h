@@ -0,0 +1,124 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+/*******************************************************************************
+ * Defines the mesh container the OBJ loader reads into and every renderer
+ * keeps its meshes in. Rather than a vector of separately allocated vertex and
+ * face structs, a mesh is a few contiguous arrays: one per coordinate of the
+ * vertices and normals, and the corners of the triangles as 32 bit index
+ * triplets. A loop over every vertex then streams through memory instead of
+ * following a pointer per vertex.
+ *
+ * Everything is numbered the way OBJ files number it. The first vertex and
+ * normal are number 1, and element 0 of each coordinate array is an unused
+ * zero, so the indices a triangle holds index the arrays directly. A normal
+ * index of 0 means the corner has no normal.
+ ******************************************************************************/
+
+// The integers from first up to but not including last. Ranging over one
+// visits the 1-based indices of a mesh's vertices or normals:
+//
+//     for (int i : m.positions.indices())
+//         transform(m.positions.x[i], m.positions.y[i], m.positions.z[i]);
+struct index_range {
+    struct iterator {
+        int i;
+        int operator*() const {
+            return i;
+        }
+        iterator& operator++() {
+            i++;
+            return *this;
+        }
+        bool operator!=(const iterator& other) const {
+            return i != other.i;
+        }
+    };
+    int first;
+    int last;
+    index_range(int first, int last) : first(first), last(last) {}
+    iterator begin() const {
+        iterator it = {first};
+        return it;
+    }
+    iterator end() const {
+        iterator it = {last};
+        return it;
+    }
+};
+
+// The coordinates of a list of points or vectors, each axis in an array of
+// its own. Element 0 of each array is unused
+struct coordinate_arrays {
+    vector<float> x;
+    vector<float> y;
+    vector<float> z;
+    coordinate_arrays() : x(1, 0.0f), y(1, 0.0f), z(1, 0.0f) {}
+    // The number of points, not counting element 0
+    int count() const {
+        return x.size() - 1;
+    }
+    // Sets the number of points, not counting element 0
+    void resize(int count) {
+        x.resize(count + 1, 0.0f);
+        y.resize(count + 1, 0.0f);
+        z.resize(count + 1, 0.0f);
+    }
+    void reserve(int count) {
+        x.reserve(count + 1);
+        y.reserve(count + 1);
+        z.reserve(count + 1);
+    }
+    void push_back(float px, float py, float pz) {
+        x.push_back(px);
+        y.push_back(py);
+        z.push_back(pz);
+    }
+    // The 1-based indices of the points
+    index_range indices() const {
+        return index_range(1, count() + 1);
+    }
+};
+
+// The indices of the three corners of a triangle
+struct index_triplet {
+    uint32_t corners[3];
+    uint32_t operator[](int k) const {
+        return corners[k];
+    }
+    uint32_t& operator[](int k) {
+        return corners[k];
+    }
+};
+
+struct tri_mesh {
+    coordinate_arrays positions;
+    coordinate_arrays normals;
+    // The vertex and normal indices of the corners of each triangle
+    vector<index_triplet> position_indices;
+    vector<index_triplet> normal_indices;
+
+    int vertex_count() const {
+        return positions.count();
+    }
+    int normal_count() const {
+        return normals.count();
+    }
+    int face_count() const {
+        return position_indices.size();
+    }
+    void add_triangle(uint32_t v1, uint32_t v2, uint32_t v3, uint32_t vn1,
+            uint32_t vn2, uint32_t vn3) {
+        index_triplet v = {{v1, v2, v3}};
+        index_triplet vn = {{vn1, vn2, vn3}};
+        position_indices.push_back(v);
+        normal_indices.push_back(vn);
+    }
+};
+
+#endif
@@ -0,0 +1,253 @@
+#include "mesh_cache.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// A read-only memory mapping of a whole file
+struct mapped_file {
+    const char *data;
+    size_t size;
+    mapped_file() : data(NULL), size(0) {}
+    ~mapped_file() {
+        if (data != NULL)
+            munmap((void *) data, size);
+    }
+};
+
+/*
+ * Maps the file with the given descriptor, which has the given size, and
+ * closes the descriptor. Returns false if it can't be mapped.
+ */
+static bool map_file(int fd, size_t size, mapped_file& file) {
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+        return false;
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    file.data = (const char *) mapping;
+    file.size = size;
+    return true;
+}
+
+static uint64_t mtime_ns(const struct stat& info) {
+    return (uint64_t) info.st_mtim.tv_sec * 1000000000
+        + info.st_mtim.tv_nsec;
+}
+
+/*
+ * FNV-1a, taken a 64 bit word at a time rather than a byte at a time, so
+ * hashing a file takes a fraction of the time parsing it would.
+ */
+uint64_t hash_obj_contents(const char *data, size_t size) {
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ (unsigned char) data[i]) * prime;
+    }
+    return (hash ^ size) * prime;
+}
+
+/*
+ * Checks that a mapped cache has the right magic number and version, and that
+ * every array named in its header lies inside it.
+ */
+static bool validate_cache(const mapped_file& cache) {
+    if (cache.size < sizeof(mesh_cache_header))
+        return false;
+    const mesh_cache_header *header = (const mesh_cache_header *) cache.data;
+    if (memcmp(header->magic, mesh_cache_magic, sizeof(mesh_cache_magic)) != 0
+            || header->version != mesh_cache_version)
+        return false;
+
+    uint64_t offsets[] = {header->positions_offset, header->normals_offset,
+        header->position_indices_offset, header->normal_indices_offset};
+    uint64_t sizes[] = {3ULL * header->vertex_count * sizeof(float),
+        3ULL * header->normal_count * sizeof(float),
+        3ULL * header->triangle_count * sizeof(uint32_t),
+        3ULL * header->triangle_count * sizeof(uint32_t)};
+    for (int i = 0; i < 4; i++) {
+        if (offsets[i] % 4 != 0 || offsets[i] > cache.size
+                || sizes[i] > cache.size - offsets[i])
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Copies count points from a cache into a coordinate array, after its element
+ * 0.
+ */
+static void read_coordinates(const float *data, uint32_t count,
+        coordinate_arrays& to) {
+    to.resize(count);
+    copy(data, data + count, to.x.begin() + 1);
+    copy(data + count, data + 2 * count, to.y.begin() + 1);
+    copy(data + 2 * count, data + 3 * count, to.z.begin() + 1);
+}
+
+/*
+ * Copies the arrays of a valid cache into mesh. Returns false if any of its
+ * faces refer to a vertex or normal it doesn't have, which a stale or
+ * corrupted cache can, in which case the OBJ file has to be parsed instead.
+ */
+static bool read_cache(const mapped_file& cache, tri_mesh& mesh) {
+    const mesh_cache_header *header = (const mesh_cache_header *) cache.data;
+    read_coordinates((const float *) (cache.data + header->positions_offset),
+            header->vertex_count, mesh.positions);
+    read_coordinates((const float *) (cache.data + header->normals_offset),
+            header->normal_count, mesh.normals);
+    const index_triplet *position_indices = (const index_triplet *)
+        (cache.data + header->position_indices_offset);
+    const index_triplet *normal_indices = (const index_triplet *)
+        (cache.data + header->normal_indices_offset);
+    mesh.position_indices.assign(position_indices,
+            position_indices + header->triangle_count);
+    mesh.normal_indices.assign(normal_indices,
+            normal_indices + header->triangle_count);
+    return find_bad_face(mesh) < 0;
+}
+
+/*
+ * Writes the points of a coordinate array to a file, leaving out element 0.
+ */
+static void write_coordinates(const coordinate_arrays& from, FILE *file) {
+    size_t count = from.count();
+    fwrite(from.x.data() + 1, sizeof(float), count, file);
+    fwrite(from.y.data() + 1, sizeof(float), count, file);
+    fwrite(from.z.data() + 1, sizeof(float), count, file);
+}
+
+/*
+ * Writes mesh to a cache file. It's written to a temporary file first and
+ * then renamed, so a render running at the same time never sees half of it.
+ */
+static bool write_cache(const string& cache_name, mesh_cache_header header,
+        const tri_mesh& mesh) {
+    memcpy(header.magic, mesh_cache_magic, sizeof(mesh_cache_magic));
+    header.version = mesh_cache_version;
+    header.vertex_count = mesh.vertex_count();
+    header.normal_count = mesh.normal_count();
+    header.triangle_count = mesh.face_count();
+    header.reserved = 0;
+    header.positions_offset = sizeof(mesh_cache_header);
+    header.normals_offset = header.positions_offset
+        + 3ULL * header.vertex_count * sizeof(float);
+    header.position_indices_offset = header.normals_offset
+        + 3ULL * header.normal_count * sizeof(float);
+    header.normal_indices_offset = header.position_indices_offset
+        + mesh.position_indices.size() * sizeof(index_triplet);
+
+    string temp_name = cache_name + "." + to_string(getpid());
+    FILE *file = fopen(temp_name.c_str(), "wb");
+    if (file == NULL)
+        return false;
+    fwrite(&header, sizeof(mesh_cache_header), 1, file);
+    write_coordinates(mesh.positions, file);
+    write_coordinates(mesh.normals, file);
+    fwrite(mesh.position_indices.data(), sizeof(index_triplet),
+            mesh.position_indices.size(), file);
+    fwrite(mesh.normal_indices.data(), sizeof(index_triplet),
+            mesh.normal_indices.size(), file);
+    bool success = !ferror(file);
+    success = (fclose(file) == 0) && success;
+    if (success)
+        success = rename(temp_name.c_str(), cache_name.c_str()) == 0;
+    if (!success)
+        remove(temp_name.c_str());
+    return success;
+}
+
+/*
+ * Records a new modification time for the source of a cache whose contents
+ * turned out to be unchanged, so the next load can skip hashing it.
+ */
+static void refresh_cache_mtime(const string& cache_name, uint64_t mtime) {
+    int fd = open(cache_name.c_str(), O_WRONLY);
+    if (fd < 0)
+        return;
+    pwrite(fd, &mtime, sizeof(mtime),
+            offsetof(mesh_cache_header, source_mtime_ns));
+    close(fd);
+}
+
+bool load_obj_cached(const char *filename, tri_mesh& mesh,
+        unsigned int thread_count) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "load_obj_cached ERROR couldn't open file %s\n",
+                filename);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        fprintf(stderr, "load_obj_cached ERROR couldn't read file %s\n",
+                filename);
+        close(fd);
+        return false;
+    }
+
+    // Map the cache if there is a valid one for a file of this size
+    string cache_name = filename;
+    cache_name += "b";
+    mapped_file cache;
+    const mesh_cache_header *header = NULL;
+    int cache_fd = open(cache_name.c_str(), O_RDONLY);
+    struct stat cache_info;
+    if (cache_fd >= 0 && (fstat(cache_fd, &cache_info) != 0
+                || cache_info.st_size == 0)) {
+        close(cache_fd);
+    } else if (cache_fd >= 0 && map_file(cache_fd, cache_info.st_size, cache)
+            && validate_cache(cache)) {
+        header = (const mesh_cache_header *) cache.data;
+    }
+    if (header != NULL && header->source_size != (uint64_t) info.st_size)
+        header = NULL;
+
+    // An unchanged modification time means the file is unchanged, so it
+    // doesn't even need reading
+    if (header != NULL && header->source_mtime_ns == mtime_ns(info)) {
+        if (read_cache(cache, mesh)) {
+            close(fd);
+            return true;
+        }
+        header = NULL;
+    }
+
+    mapped_file source;
+    if (info.st_size == 0) {
+        close(fd);
+    } else if (!map_file(fd, info.st_size, source)) {
+        fprintf(stderr, "load_obj_cached ERROR couldn't map file %s\n",
+                filename);
+        return false;
+    }
+    uint64_t hash = hash_obj_contents(source.data, source.size);
+    if (header != NULL && header->source_hash == hash
+            && read_cache(cache, mesh)) {
+        refresh_cache_mtime(cache_name, mtime_ns(info));
+        return true;
+    }
+
+    if (!parse_obj(filename, source.data, source.size, mesh, thread_count))
+        return false;
+    mesh_cache_header new_header;
+    new_header.source_size = info.st_size;
+    new_header.source_mtime_ns = mtime_ns(info);
+    new_header.source_hash = hash;
+    write_cache(cache_name, new_header, mesh);
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <stdint.h>
+#include "obj_loader.h"
+
+using namespace std;
+
+/*******************************************************************************
+ * Defines the binary mesh cache. The first time an OBJ file is loaded through
+ * load_obj_cached, the mesh is also written next to it in a binary file, named
+ * after it with a trailing "b" (kitten.obj becomes kitten.objb). Later loads
+ * memory map the binary file and copy its arrays out, without parsing
+ * anything.
+ *
+ * The cache records the size, modification time and a hash of the contents of
+ * the OBJ file it was made from. It is used if the size matches and either
+ * the modification time or the hash does, so an edited OBJ file is parsed
+ * again and its cache rewritten, while one that was only touched or checked
+ * out again keeps its cache.
+ *
+ * file layout (all offsets are in bytes from the start of the file and are
+ * 4 byte aligned):
+ *
+ *     mesh_cache_header
+ *     float    positions[3 * vertex_count]     all the x coordinates, then all
+ *                                              the y and then all the z
+ *     float    normals[3 * normal_count]       the same
+ *     uint32_t position_indices[3 * triangle_count]
+ *     uint32_t normal_indices[3 * triangle_count]
+ *
+ * which is the layout of a tri_mesh without its unused element 0.
+ ******************************************************************************/
+
+static const char mesh_cache_magic[4] = {'O', 'B', 'J', 'B'};
+static const uint32_t mesh_cache_version = 2;
+
+struct mesh_cache_header {
+    char magic[4];
+    uint32_t version;
+
+    // The OBJ file the cache was made from
+    uint64_t source_size;
+    uint64_t source_mtime_ns;
+    uint64_t source_hash;
+
+    uint32_t vertex_count;
+    uint32_t normal_count;
+    uint32_t triangle_count;
+    uint32_t reserved;
+
+    uint64_t positions_offset;
+    uint64_t normals_offset;
+    uint64_t position_indices_offset;
+    uint64_t normal_indices_offset;
+};
+
+// Loads an OBJ file like load_obj, going through its binary cache. If the
+// cache can't be written, the mesh is still loaded, just without it
+bool load_obj_cached(const char *filename, tri_mesh& mesh,
+        unsigned int thread_count = 0);
+
+// Hashes the contents of an OBJ file, for telling whether it has changed
+uint64_t hash_obj_contents(const char *data, size_t size);
+
+#endif
@@ -0,0 +1,378 @@
+#include "obj_loader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <climits>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// The powers of ten a float holds exactly
+static const float exact_powers_of_ten[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f,
+    1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+static const int max_exact_power_of_ten = 10;
+// The largest mantissa a float holds exactly
+static const unsigned long long max_exact_mantissa = 1 << 24;
+
+// A part of the file parsed on its own, and the mesh read from it. OBJ
+// indices count from the start of the whole file, so the indices read from
+// each part are already correct once the parts are joined
+struct obj_chunk {
+    const char *begin;
+    const char *end;
+    tri_mesh mesh;
+    // Where the first malformed line starts, or NULL if there wasn't one
+    const char *error;
+};
+
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/*
+ * Advances p past any spaces, stopping at the end of the line.
+ */
+static inline void skip_spaces(const char *&p, const char *end) {
+    while (p < end && is_space(*p))
+        p++;
+}
+
+/*
+ * Advances p to the start of the next line.
+ */
+static inline void skip_line(const char *&p, const char *end) {
+    const char *newline = (const char *) memchr(p, '\n', end - p);
+    p = (newline == NULL) ? end : newline + 1;
+}
+
+static inline bool at_line_end(const char *p, const char *end) {
+    return p == end || *p == '\n';
+}
+
+/*
+ * Reads an optionally signed decimal integer at p into value, advancing p
+ * past it. Returns false if there isn't one, or it doesn't fit in an int.
+ */
+static bool scan_int(const char *&p, const char *end, int& value) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+    const char *digits = p;
+    long long magnitude = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        magnitude = magnitude * 10 + (*p++ - '0');
+        if (magnitude > INT_MAX)
+            return false;
+    }
+    if (p == digits)
+        return false;
+    value = negative ? -magnitude : magnitude;
+    return true;
+}
+
+/*
+ * Reads a decimal floating point number at p into value, advancing p past it.
+ * Returns false if there isn't one. Numbers with at most seven or so
+ * significant digits and small exponents, which is nearly every number in
+ * an OBJ file, are a mantissa and a power of ten that a float holds exactly,
+ * so a single float multiply or divide gives the correctly rounded value.
+ * Anything else is handed to strtof, so every number comes out exactly as
+ * it would from a stream.
+ */
+static bool scan_float(const char *&p, const char *end, float& value) {
+    const char *start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+        negative = *p++ == '-';
+
+    unsigned long long mantissa = 0;
+    int exponent = 0;
+    int digit_count = 0;
+    bool exact = true;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (mantissa <= max_exact_mantissa)
+            mantissa = mantissa * 10 + (*p - '0');
+        else
+            exact = false;
+        p++;
+        digit_count++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (mantissa <= max_exact_mantissa) {
+                mantissa = mantissa * 10 + (*p - '0');
+                exponent--;
+            } else {
+                exact = false;
+            }
+            p++;
+            digit_count++;
+        }
+    }
+    if (digit_count == 0)
+        return false;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        int exponent_value;
+        p++;
+        if (!scan_int(p, end, exponent_value))
+            return false;
+        if (exponent_value > 1000 || exponent_value < -1000)
+            exact = false;
+        else
+            exponent += exponent_value;
+    }
+
+    if (exact && mantissa <= max_exact_mantissa
+            && exponent >= -max_exact_power_of_ten
+            && exponent <= max_exact_power_of_ten) {
+        value = (exponent >= 0)
+            ? (float) mantissa * exact_powers_of_ten[exponent]
+            : (float) mantissa / exact_powers_of_ten[-exponent];
+        if (negative)
+            value = -value;
+        return true;
+    }
+
+    // The mapped file isn't null terminated, so strtof gets a copy
+    char buffer[64];
+    size_t length = p - start;
+    if (length >= sizeof(buffer))
+        return false;
+    memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    value = strtof(buffer, NULL);
+    return true;
+}
+
+/*
+ * Reads one corner of a face, v, v/vt, v//vn or v/vt/vn, into the vertex and
+ * normal indices. The normal index is 0 if there isn't one.
+ */
+static bool scan_corner(const char *&p, const char *end, int& v, int& vn) {
+    vn = 0;
+    if (!scan_int(p, end, v))
+        return false;
+    if (p == end || *p != '/')
+        return true;
+    p++;
+    int vt;
+    if (p < end && *p != '/' && !scan_int(p, end, vt))
+        return false;
+    if (p == end || *p != '/')
+        return true;
+    p++;
+    return scan_int(p, end, vn);
+}
+
+/*
+ * Parses the lines of a chunk into its mesh, stopping at the first malformed
+ * one.
+ */
+static void parse_chunk(obj_chunk& chunk) {
+    const char *p = chunk.begin;
+    const char *end = chunk.end;
+    tri_mesh& mesh = chunk.mesh;
+    chunk.error = NULL;
+    // The corners of the face being read
+    vector<int> face_v;
+    vector<int> face_vn;
+
+    while (p < end) {
+        const char *line = p;
+        skip_spaces(p, end);
+        bool ok = true;
+        if (end - p >= 2 && p[0] == 'v' && is_space(p[1])) {
+            p++;
+            float x, y, z = 0;
+            skip_spaces(p, end);
+            ok = scan_float(p, end, x);
+            skip_spaces(p, end);
+            ok = ok && scan_float(p, end, y);
+            skip_spaces(p, end);
+            if (ok && !at_line_end(p, end))
+                ok = scan_float(p, end, z);
+            mesh.positions.push_back(x, y, z);
+        } else if (end - p >= 3 && p[0] == 'v' && p[1] == 'n'
+                && is_space(p[2])) {
+            p += 2;
+            float x, y, z;
+            skip_spaces(p, end);
+            ok = scan_float(p, end, x);
+            skip_spaces(p, end);
+            ok = ok && scan_float(p, end, y);
+            skip_spaces(p, end);
+            ok = ok && scan_float(p, end, z);
+            mesh.normals.push_back(x, y, z);
+        } else if (end - p >= 2 && p[0] == 'f' && is_space(p[1])) {
+            p++;
+            face_v.clear();
+            face_vn.clear();
+            skip_spaces(p, end);
+            while (ok && !at_line_end(p, end)) {
+                int v, vn;
+                ok = scan_corner(p, end, v, vn);
+                // Indices relative to the end of the list aren't supported
+                ok = ok && v > 0 && vn >= 0;
+                face_v.push_back(v);
+                face_vn.push_back(vn);
+                skip_spaces(p, end);
+            }
+            ok = ok && face_v.size() >= 3;
+            for (size_t k = 1; ok && k + 1 < face_v.size(); k++) {
+                mesh.add_triangle(face_v[0], face_v[k], face_v[k + 1],
+                        face_vn[0], face_vn[k], face_vn[k + 1]);
+            }
+        }
+
+        if (!ok) {
+            chunk.error = line;
+            return;
+        }
+        skip_line(p, end);
+    }
+}
+
+/*
+ * Appends the contents of a vector to another, starting from element first.
+ */
+template <typename T>
+static void append(vector<T>& to, const vector<T>& from, size_t first = 0) {
+    to.insert(to.end(), from.begin() + first, from.end());
+}
+
+/*
+ * Appends the points of a coordinate array to another, skipping the unused
+ * element 0.
+ */
+static void append(coordinate_arrays& to, const coordinate_arrays& from) {
+    append(to.x, from.x, 1);
+    append(to.y, from.y, 1);
+    append(to.z, from.z, 1);
+}
+
+bool parse_obj(const char *filename, const char *data, size_t size,
+        tri_mesh& mesh, unsigned int thread_count) {
+    if (thread_count == 0)
+        thread_count = thread::hardware_concurrency();
+    if (thread_count == 0)
+        thread_count = 1;
+    size_t chunk_count = min((size_t) thread_count,
+            max((size_t) 1, size / obj_parallel_chunk_size));
+
+    // Split the file into chunks of whole lines, roughly the same size
+    vector<obj_chunk> chunks(chunk_count);
+    const char *file_end = data + size;
+    const char *begin = data;
+    for (size_t k = 0; k < chunk_count; k++) {
+        const char *end = file_end;
+        if (k + 1 < chunk_count) {
+            end = max(begin, data + size * (k + 1) / chunk_count);
+            skip_line(end, file_end);
+        }
+        chunks[k].begin = begin;
+        chunks[k].end = end;
+        begin = end;
+    }
+
+    vector<thread> workers;
+    for (size_t k = 1; k < chunk_count; k++) {
+        workers.emplace_back(parse_chunk, ref(chunks[k]));
+    }
+    parse_chunk(chunks[0]);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    for (const obj_chunk& chunk : chunks) {
+        if (chunk.error != NULL) {
+            int line = 1 + count(data, chunk.error, '\n');
+            fprintf(stderr, "load_obj ERROR %s:%d is malformed\n", filename,
+                    line);
+            return false;
+        }
+    }
+
+    if (chunk_count == 1) {
+        swap(mesh, chunks[0].mesh);
+    } else {
+        mesh = tri_mesh();
+        int positions = 0, normals = 0;
+        size_t indices = 0;
+        for (const obj_chunk& chunk : chunks) {
+            positions += chunk.mesh.vertex_count();
+            normals += chunk.mesh.normal_count();
+            indices += chunk.mesh.position_indices.size();
+        }
+        mesh.positions.reserve(positions);
+        mesh.normals.reserve(normals);
+        mesh.position_indices.reserve(indices);
+        mesh.normal_indices.reserve(indices);
+        for (const obj_chunk& chunk : chunks) {
+            append(mesh.positions, chunk.mesh.positions);
+            append(mesh.normals, chunk.mesh.normals);
+            append(mesh.position_indices, chunk.mesh.position_indices);
+            append(mesh.normal_indices, chunk.mesh.normal_indices);
+        }
+    }
+
+    long bad_face = find_bad_face(mesh);
+    if (bad_face >= 0) {
+        fprintf(stderr, "load_obj ERROR face %ld of %s refers to a missing "
+                "vertex or normal\n", bad_face + 1, filename);
+        return false;
+    }
+    return true;
+}
+
+long find_bad_face(const tri_mesh& mesh) {
+    uint32_t vertex_count = mesh.vertex_count();
+    uint32_t normal_count = mesh.normal_count();
+    for (size_t i = 0; i < mesh.position_indices.size(); i++) {
+        const index_triplet& v = mesh.position_indices[i];
+        const index_triplet& vn = mesh.normal_indices[i];
+        for (int k = 0; k < 3; k++) {
+            if (v[k] > vertex_count || vn[k] > normal_count)
+                return i;
+        }
+    }
+    return -1;
+}
+
+bool load_obj(const char *filename, tri_mesh& mesh,
+        unsigned int thread_count) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "load_obj ERROR couldn't open file %s\n", filename);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        fprintf(stderr, "load_obj ERROR couldn't read file %s\n", filename);
+        close(fd);
+        return false;
+    }
+    size_t size = info.st_size;
+    if (size == 0) {
+        close(fd);
+        mesh = tri_mesh();
+        return true;
+    }
+
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "load_obj ERROR couldn't map file %s\n", filename);
+        return false;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    bool ok = parse_obj(filename, (const char *) mapping, size, mesh,
+            thread_count);
+    munmap(mapping, size);
+    return ok;
+}
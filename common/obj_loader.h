@@ -0,0 +1,43 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <vector>
+#include "mesh.h"
+
+using namespace std;
+
+/*******************************************************************************
+ * Defines the OBJ loader every renderer reads its meshes with. The file is
+ * memory mapped and scanned in place by hand rather than through streams, and
+ * large files are split into chunks that are parsed in parallel. Everything
+ * ends up in a tri_mesh (see mesh.h).
+ *
+ * The loader understands the lines the assignments' files use:
+ *
+ *     v x y [z]           a vertex (z defaults to 0)
+ *     vn x y z            a surface normal
+ *     f v1 v2 v3 ...      a face, where each corner is v, v/vt, v//vn or
+ *                         v/vt/vn
+ *
+ * Faces with more than three corners are split into a fan of triangles.
+ * Comments and any other kind of line are skipped.
+ ******************************************************************************/
+
+// Files smaller than this many bytes per thread are parsed on fewer threads,
+// since starting a thread costs more than scanning a small file
+static const size_t obj_parallel_chunk_size = 1 << 20;
+
+// Reads an OBJ file into mesh, replacing its contents. A thread_count of 0
+// uses every core. Prints an error and returns false if the file can't be
+// read or is malformed
+bool load_obj(const char *filename, tri_mesh& mesh,
+        unsigned int thread_count = 0);
+// The same for the contents of an OBJ file already in memory. The filename is
+// only used in error messages
+bool parse_obj(const char *filename, const char *data, size_t size,
+        tri_mesh& mesh, unsigned int thread_count = 0);
+// Returns the index of the first face of mesh that refers to a vertex or
+// normal the mesh doesn't have, or -1 if they all refer to ones it has
+long find_bad_face(const tri_mesh& mesh);
+
+#endif
@@ -0,0 +1,246 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <cmath>
+#include <Eigen/Core>
+
+/*******************************************************************************
+ * Defines the translations, scalings and rotations objects and cameras are
+ * placed with. Everything here lives in this header, so using it only takes
+ * the common folder on the include path.
+ *
+ * Each of these transforms is affine, so the bottom row of its 4x4 matrix is
+ * always 0 0 0 1. An affine_transform only stores the top three rows, in a
+ * fixed-size array, so building, copying and composing transforms never
+ * allocates. Composing two of them skips the bottom row, and composing with a
+ * translation or a scaling is specialized further: a translation only adds to
+ * the last column, and a scaling only multiplies rows or columns.
+ *
+ * A scene file lists the steps of a transformation, the first one applied
+ * first. A transform_chain keeps the product of those steps, and the inverse of
+ * that product, up to date as steps are added. The inverse is put together from
+ * the inverse of each step (a translation by the opposite vector, a scaling by
+ * the reciprocals, and a rotation's transpose), so no matrix ever needs to be
+ * inverted numerically.
+ ******************************************************************************/
+
+// An affine transformation of 3D space, as the top three rows of its matrix
+template <typename T>
+struct affine_transform {
+    T m[3][4];
+
+    // The identity
+    constexpr affine_transform()
+        : m{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}} {}
+    constexpr affine_transform(T m00, T m01, T m02, T m03, T m10, T m11,
+            T m12, T m13, T m20, T m21, T m22, T m23)
+        : m{{m00, m01, m02, m03}, {m10, m11, m12, m13},
+            {m20, m21, m22, m23}} {}
+    // The same transformation with entries of another type
+    template <typename U>
+    explicit affine_transform(const affine_transform<U>& other) {
+        for (int row = 0; row < 3; row++) {
+            for (int col = 0; col < 4; col++)
+                m[row][col] = other.m[row][col];
+        }
+    }
+
+    // Entry (row, col) of the 4x4 matrix, bottom row included
+    constexpr T operator()(int row, int col) const {
+        return (row < 3) ? m[row][col] : ((col == 3) ? 1 : 0);
+    }
+
+    // The whole 4x4 matrix
+    Eigen::Matrix<T, 4, 4> matrix() const {
+        Eigen::Matrix<T, 4, 4> result;
+        result << m[0][0], m[0][1], m[0][2], m[0][3],
+            m[1][0], m[1][1], m[1][2], m[1][3],
+            m[2][0], m[2][1], m[2][2], m[2][3],
+            0, 0, 0, 1;
+        return result;
+    }
+
+    // The top left 3x3 block, which transforms directions
+    Eigen::Matrix<T, 3, 3> linear() const {
+        Eigen::Matrix<T, 3, 3> result;
+        result << m[0][0], m[0][1], m[0][2],
+            m[1][0], m[1][1], m[1][2],
+            m[2][0], m[2][1], m[2][2];
+        return result;
+    }
+
+    // Transforms the point (x, y, z). Its w stays 1, so there's no divide
+    Eigen::Matrix<T, 3, 1> transform_point(T x, T y, T z) const {
+        return Eigen::Matrix<T, 3, 1>(
+            m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3],
+            m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3],
+            m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3]);
+    }
+    Eigen::Matrix<T, 3, 1> transform_point(
+            const Eigen::Matrix<T, 3, 1>& p) const {
+        return transform_point(p(0), p(1), p(2));
+    }
+
+    // Transforms the direction (x, y, z), which translations don't move
+    Eigen::Matrix<T, 3, 1> transform_direction(T x, T y, T z) const {
+        return Eigen::Matrix<T, 3, 1>(
+            m[0][0] * x + m[0][1] * y + m[0][2] * z,
+            m[1][0] * x + m[1][1] * y + m[1][2] * z,
+            m[2][0] * x + m[2][1] * y + m[2][2] * z);
+    }
+    Eigen::Matrix<T, 3, 1> transform_direction(
+            const Eigen::Matrix<T, 3, 1>& d) const {
+        return transform_direction(d(0), d(1), d(2));
+    }
+};
+
+/********************************** Builders **********************************/
+
+template <typename T>
+constexpr affine_transform<T> translation_transform(T x, T y, T z) {
+    return affine_transform<T>(1, 0, 0, x, 0, 1, 0, y, 0, 0, 1, z);
+}
+
+template <typename T>
+constexpr affine_transform<T> scaling_transform(T x, T y, T z) {
+    return affine_transform<T>(x, 0, 0, 0, 0, y, 0, 0, 0, 0, z, 0);
+}
+
+// A rotation about the unit vector (x, y, z), by the angle whose cosine and
+// sine are c and s
+template <typename T>
+constexpr affine_transform<T> rotation_transform(T x, T y, T z, T c, T s) {
+    return affine_transform<T>(
+        x * x + (1 - x * x) * c, x * y * (1 - c) - z * s,
+            x * z * (1 - c) + y * s, 0,
+        y * x * (1 - c) + z * s, y * y + (1 - y * y) * c,
+            y * z * (1 - c) - x * s, 0,
+        z * x * (1 - c) - y * s, z * y * (1 - c) + x * s,
+            z * z + (1 - z * z) * c, 0);
+}
+
+// A rotation by angle radians about the vector (x, y, z), which needn't be a
+// unit vector
+template <typename T>
+affine_transform<T> rotation_transform(T x, T y, T z, T angle) {
+    T magnitude = std::sqrt(x * x + y * y + z * z);
+    return rotation_transform(x / magnitude, y / magnitude, z / magnitude,
+            (T) std::cos(angle), (T) std::sin(angle));
+}
+
+/********************************* Composition ********************************/
+
+// The product a * b, that is b followed by a
+template <typename T>
+affine_transform<T> operator*(const affine_transform<T>& a,
+        const affine_transform<T>& b) {
+    affine_transform<T> result;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 4; col++) {
+            result.m[row][col] = a.m[row][0] * b.m[0][col]
+                + a.m[row][1] * b.m[1][col] + a.m[row][2] * b.m[2][col];
+        }
+        result.m[row][3] += a.m[row][3];
+    }
+    return result;
+}
+
+// translation_transform(x, y, z) * a, that is a followed by a translation
+template <typename T>
+affine_transform<T> pretranslated(affine_transform<T> a, T x, T y, T z) {
+    a.m[0][3] += x;
+    a.m[1][3] += y;
+    a.m[2][3] += z;
+    return a;
+}
+
+// a * translation_transform(x, y, z), that is a translation followed by a
+template <typename T>
+affine_transform<T> translated(affine_transform<T> a, T x, T y, T z) {
+    for (int row = 0; row < 3; row++)
+        a.m[row][3] += a.m[row][0] * x + a.m[row][1] * y + a.m[row][2] * z;
+    return a;
+}
+
+// scaling_transform(x, y, z) * a, that is a followed by a scaling
+template <typename T>
+affine_transform<T> prescaled(affine_transform<T> a, T x, T y, T z) {
+    const T factors[3] = {x, y, z};
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 4; col++)
+            a.m[row][col] *= factors[row];
+    }
+    return a;
+}
+
+// a * scaling_transform(x, y, z), that is a scaling followed by a
+template <typename T>
+affine_transform<T> scaled(affine_transform<T> a, T x, T y, T z) {
+    for (int row = 0; row < 3; row++) {
+        a.m[row][0] *= x;
+        a.m[row][1] *= y;
+        a.m[row][2] *= z;
+    }
+    return a;
+}
+
+/********************************** Inverses **********************************/
+
+// The inverse of a rigid transformation, one made only of rotations and
+// translations: its 3x3 block transposed, and its translation undone
+template <typename T>
+affine_transform<T> rigid_inverse(const affine_transform<T>& a) {
+    affine_transform<T> result;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++)
+            result.m[row][col] = a.m[col][row];
+        result.m[row][3] = -(a.m[0][row] * a.m[0][3]
+            + a.m[1][row] * a.m[1][3] + a.m[2][row] * a.m[2][3]);
+    }
+    return result;
+}
+
+/*
+ * A chain of translations, scalings and rotations, applied in the order they
+ * are added, along with the product of the chain and its inverse.
+ */
+template <typename T>
+struct transform_chain {
+    affine_transform<T> product;
+    affine_transform<T> inverse;
+
+    void translate(T x, T y, T z) {
+        product = pretranslated(product, x, y, z);
+        inverse = translated(inverse, -x, -y, -z);
+    }
+
+    void scale(T x, T y, T z) {
+        product = prescaled(product, x, y, z);
+        inverse = scaled(inverse, 1 / x, 1 / y, 1 / z);
+    }
+
+    // Rotates by angle radians about the vector (x, y, z), which needn't be a
+    // unit vector
+    void rotate(T x, T y, T z, T angle) {
+        affine_transform<T> rotation = rotation_transform(x, y, z, angle);
+        product = rotation * product;
+        inverse = inverse * rigid_inverse(rotation);
+    }
+
+    // Adds the step a scene file names with the letter type: t for a
+    // translation, s for a scaling or r for a rotation by angle. Returns false
+    // for any other letter
+    bool add(char type, T x, T y, T z, T angle = 0) {
+        if (type == 't')
+            translate(x, y, z);
+        else if (type == 's')
+            scale(x, y, z);
+        else if (type == 'r')
+            rotate(x, y, z, angle);
+        else
+            return false;
+        return true;
+    }
+};
+
+#endif
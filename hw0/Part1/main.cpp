@@ -20,12 +20,12 @@ int main(int argc, const char* argv[]) {
         object *o = objects[i];
         cout << argv[i + 1] << ":" << endl;
         cout << "\n";
-        for (vertex *v : o->vertices) {
-            if (v != NULL)
-                cout << "v " << v->x << " " << v->y << " " << v->z << endl;
+        const coordinate_arrays& p = o->geometry.positions;
+        for (int v : p.indices()) {
+            cout << "v " << p.x[v] << " " << p.y[v] << " " << p.z[v] << endl;
         }
-        for (face *f : o->faces) {
-            cout << "f " << f->v1 << " " << f->v2 << " " << f->v3 << endl;
+        for (const index_triplet& f : o->geometry.position_indices) {
+            cout << "f " << f[0] << " " << f[1] << " " << f[2] << endl;
         }
         cout << "\n";
     }
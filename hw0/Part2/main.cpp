@@ -1,32 +1,31 @@
 #include <cassert>
-#include <Eigen/Dense>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
-#include "matrix_math.h"
+#include "transform.h"
 
-using Eigen::MatrixXd;
 using namespace std;
 
 int main(int argc, const char* argv[]) {
-    vector<MatrixXd> matrices;
+    transform_chain<double> transformations;
 
     // Should only be taking as input a single text file
     assert (argc == 2);
     ifstream infile(argv[1]);
     char determ;
-    float x, y, z, angle;
+    float x, y, z, angle = 0;
     while (infile >> determ) {
         // rotation lines have 4 nums, all others have 3
         if (determ != 'r') {
             (infile >> x >> y >> z);
-            matrices.push_back(get_matrix(determ, x, y, z));
         } else {
             (infile >> x >> y >> z >> angle);
-            matrices.push_back(get_matrix(determ, x, y, z, angle));
+        }
+        if (!transformations.add(determ, x, y, z, angle)) {
+            cout << "Invalid argument, exiting" << endl;
+            exit(EXIT_FAILURE);
         }
     }
 
-    MatrixXd product = compute_product(matrices);
-    MatrixXd product_inv = product.inverse();
-    cout << product_inv << endl;
+    cout << transformations.inverse.matrix() << endl;
 }
@@ -3,19 +3,18 @@
 #include <fstream>
 #include <unordered_map>
 #include <string>
+#include <sstream>
+#include <cstdlib>
 #include <cassert>
-#include <Eigen/Dense>
 #include "file_reader.h"
-#include "Part2/matrix_math.h"
 
-using Eigen::MatrixXd;
 using namespace std;
 
 /*
  * Given an input file of the format specified in Part 3, reads through it and
  * returns a vector of pointers to object structs. Each object struct has a
- * vector of pointers to vertices, a vector of pointers to faces, and a vector
- * of transformation matrices. Each object struct also has a label.
+ * mesh of vertices and faces, and a vector of transformation matrices. Each
+ * object struct also has a label.
  */
 vector<object *> get_objects(const char* input_file) {
     unordered_map<string, object *> labels_map;
@@ -40,9 +39,11 @@ vector<object *> get_objects(const char* input_file) {
         if (iss >> determ >> x >> y >> z) {
             if (determ == 'r')
                 (iss >> angle);
-            MatrixXd matrix = get_matrix(determ, x, y, z, angle);
-            // Add transformation matrix to current object copy
-            object_copy->transformations.push_back(matrix);
+            // Add transformation to current object copy
+            if (!object_copy->transformations.add(determ, x, y, z, angle)) {
+                cout << "Invalid argument, exiting" << endl;
+                exit(EXIT_FAILURE);
+            }
             continue;
         }
 
@@ -80,6 +81,29 @@ vector<object *> get_objects(const char* input_file) {
     return object_copies;
 }
 
+/*
+ * Transforms points 1 to count of the coordinate arrays x, y and z in place.
+ * The transform's entries are held in locals and the arrays don't overlap, so
+ * the compiler turns this into SIMD code. The math is done in double
+ * precision, since the results are printed.
+ */
+static void transform_points(const affine_transform<double>& transform,
+        int count, float *__restrict x, float *__restrict y,
+        float *__restrict z) {
+    const double m00 = transform(0, 0), m01 = transform(0, 1),
+        m02 = transform(0, 2), m03 = transform(0, 3);
+    const double m10 = transform(1, 0), m11 = transform(1, 1),
+        m12 = transform(1, 2), m13 = transform(1, 3);
+    const double m20 = transform(2, 0), m21 = transform(2, 1),
+        m22 = transform(2, 2), m23 = transform(2, 3);
+    for (int i = 1; i <= count; i++) {
+        double px = x[i], py = y[i], pz = z[i];
+        x[i] = m00 * px + m01 * py + m02 * pz + m03;
+        y[i] = m10 * px + m11 * py + m12 * pz + m13;
+        z[i] = m20 * px + m21 * py + m22 * pz + m23;
+    }
+}
+
 /*
  * Given a vector of pointers to objects (as returned by the above method),
  * transform the vertices of the objects using the transformation matrices of
@@ -91,21 +115,12 @@ void output_transformed_objects(vector<object *> objects) {
     // object vertices, and then print.
     for (int i = 0; i < objects.size(); i++) {
         object *o = objects[i];
-        MatrixXd m2 = compute_product(o->transformations);
-        MatrixXd m = m2.inverse();
         cout << o->label << " copy" << endl;
-        for (vertex *v : o->vertices) {
-            if (v == NULL)
-                continue;
-            MatrixXd vec(4,1);
-            vec << v->x, v->y, v->z, 1;
-            MatrixXd t_vec = m * vec;
-            // Adjust the vector back to 3 dimensions, and change the vertex
-            float w = t_vec(3, 0);
-            v->x = t_vec(0,0) / w;
-            v->y = t_vec(1,0) / w;
-            v->z = t_vec(2,0) / w;
-            cout << v->x << " " << v->y << " " << v->z << endl;
+        coordinate_arrays& p = o->geometry.positions;
+        transform_points(o->transformations.inverse, p.count(), p.x.data(),
+                p.y.data(), p.z.data());
+        for (int v : p.indices()) {
+            cout << p.x[v] << " " << p.y[v] << " " << p.z[v] << endl;
         }
         cout << "\n";
     }
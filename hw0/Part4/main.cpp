@@ -1,21 +1,23 @@
 #include <cassert>
-#include <iostream>
-#include <string>
+#include <cstdlib>
+#include <stdio.h>
 #include "ppm_gen.h"
 
 using namespace std;
 
 int main(int argc, const char* argv[]) {
-    // Should only be two arguments xres and yres
-    assert (argc == 3);
+    // Should be two arguments xres and yres, optionally followed by the image
+    // format to output (p3, p6 or png)
+    assert (argc == 3 || argc == 4);
 
     int x = atoi(argv[1]);
     int y = atoi(argv[2]);
+    image_format format = P6_IMAGE;
+    if (argc == 4 && !parse_image_format(argv[3], format)) {
+        fprintf(stderr, "main ERROR unknown image format %s\n", argv[3]);
+        return 1;
+    }
 
-    // Get ppm struct
-    ppm p = create_ppm(x, y);
-
-    // Print the lines of the ppm
-    for (string line : p.lines)
-        cout << line << endl;
+    // Write the image to stdout
+    return write_circle_image(stdout, x, y, format) ? 0 : 1;
 }
@@ -1,6 +1,5 @@
 #include <stdio.h>
-#include <vector>
-#include <string>
+#include "image_writer.h"
 
 const int CIRCLE_R = 100;
 const int CIRCLE_G = 23;
@@ -12,13 +11,4 @@ const int BG_B = 10;
 
 using namespace std;
 
-struct ppm {
-    vector<string> lines;
-    int xres;
-    int yres;
-    ppm(int x, int y) : xres(x), yres(y) {}
-};
-
-ppm create_ppm(int x, int y);
-string get_circle_line();
-string get_bg_line();
+bool write_circle_image(FILE *file, int x, int y, image_format format);
@@ -1,5 +1,32 @@
 #include "framework.h"
 #include <iostream>
+#include <algorithm>
+
+/*
+ * Lists every edge of a mesh's faces once. Neighbouring faces share their
+ * edges, so a closed mesh has half as many edges as its faces have sides.
+ */
+void build_mesh_edges(const tri_mesh& mesh, vector<mesh_edge>& edges) {
+    // Each edge as a single 64 bit key, its smaller vertex in the high half,
+    // so sorting the keys brings the copies of an edge together
+    vector<uint64_t> keys;
+    keys.reserve(3 * mesh.position_indices.size());
+    for (const index_triplet& f : mesh.position_indices) {
+        for (int k = 0; k < 3; k++) {
+            uint64_t a = f[k];
+            uint64_t b = f[(k + 1) % 3];
+            keys.push_back((min(a, b) << 32) | max(a, b));
+        }
+    }
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+
+    edges.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        edges[i].a = keys[i] >> 32;
+        edges[i].b = keys[i] & 0xffffffff;
+    }
+}
 
 /*
  * For every object in a vector of objects, prints out its vertices.
@@ -10,14 +37,13 @@ void output_object_vertices(vector<object *> objects) {
 }
 
 /*
- * Prints out all the vertices of an object.
+ * Prints out all the transformed vertices of an object.
  */
 void output_object_vertices(object *o) {
-    for (vertex *v : o->vertices) {
-        if (v != NULL) {
-            cout << "v " << v->x << " " << v->y << " " << v->z <<
-                " " << v->screen_x << " " << v->screen_y << endl;
-        }
+    for (size_t i = 1; i < o->clip_w.size(); i++) {
+        cout << "v " << o->clip_x[i] << " " << o->clip_y[i] << " " <<
+            o->clip_w[i] << " " << o->screen_x[i] << " " << o->screen_y[i] <<
+            endl;
     }
 }
 
@@ -33,9 +59,7 @@ void output_object_faces(vector<object *> objects) {
  * Prints out all the faces of an object.
  */
 void output_object_faces(object *o) {
-    for (face *f : o->faces) {
-        if (f != NULL) {
-            cout << "f " << f->v1 << " " << f->v2 << " " << f->v3 << endl;
-        }
+    for (const index_triplet& f : o->geometry->position_indices) {
+        cout << "f " << f[0] << " " << f[1] << " " << f[2] << endl;
     }
 }
@@ -5,9 +5,9 @@
 #include <vector>
 #include <string>
 #include <iostream>
-#include <Eigen/Dense>
+#include "mesh.h"
+#include "transform.h"
 
-using Eigen::MatrixXd;
 using namespace std;
 
 /*******************************************************************************
@@ -23,18 +23,7 @@ struct vertex {
     int screen_y = -1;
     vertex() {}
     vertex(float x, float y, float z) : x(x), y(y), z(z) {}
-    vertex(vertex& other) : x(other.x), y(other.y), z(other.z) {}
-};
-
-// Face struct contains the numbers of the vertices the face is composed of
-// (1-indexed)
-struct face {
-    int v1;
-    int v2;
-    int v3;
-    face() {}
-    face(int v1, int v2, int v3) : v1(v1), v2(v2), v3(v3) {}
-    face(face& other) : v1(other.v1), v2(other.v2), v3(other.v3) {}
+    vertex(const vertex& other) : x(other.x), y(other.y), z(other.z) {}
 };
 
 // An orientation is just a position as well as an angle
@@ -48,46 +37,38 @@ struct orientation {
     orientation(orientation& other) : x(other.x), y(other.y), z(other.z), angle(other.angle) {}
 };
 
-// Objects contain a list of vertices (1-indexed) and faces
+// An edge of a mesh, by the indices of its two vertices, the smaller first
+struct mesh_edge {
+    uint32_t a;
+    uint32_t b;
+};
+
+// Objects are instances of a mesh (see mesh.h), each with its own
+// transformations. The mesh's vertices are transformed into the object's own
+// buffers, which are refilled every frame, so a scene only holds one copy of
+// each mesh however many objects are made from it
 struct object {
-    vector<vertex *> vertices;
-    vector<face *> faces;
-    vector<MatrixXd> transformations;
+    const tri_mesh *geometry;
+    // Every edge of the mesh's faces once, shared like the mesh itself
+    const vector<mesh_edge> *edges;
+    // The x, y and w of the mesh's vertices in homogeneous clip coordinates
+    // (also 1-indexed), and where they land on the screen, in fractional
+    // pixels. Where a vertex lands only means something if it's in front of
+    // the camera. Filled by apply_all_transformations
+    vector<float> clip_x;
+    vector<float> clip_y;
+    vector<float> clip_w;
+    vector<float> screen_x;
+    vector<float> screen_y;
+    transform_chain<double> transformations;
     string label;
-    object() {}
-    object(vector<vertex *> vertices, vector<face *> faces) : vertices(vertices),
-        faces(faces) {}
-    object(object& other) {
-        vector<vertex *> new_vertices;
-        for (vertex *v : other.vertices) {
-            vertex *v2 = NULL;
-            if (v != NULL) // 0 index is null
-                 v2 = new vertex(*v);
-            new_vertices.push_back(v2);
-        }
-        vertices = new_vertices;
-
-        vector<face *> new_faces;
-        for (face *f : other.faces) {
-            face *f2 = new face(*f);
-            new_faces.push_back(f2);
-        }
-        faces = new_faces;
-
-        label = other.label;
-    }
-    ~object() {
-        for (vertex *v : vertices) {
-            if (v != NULL)
-                delete v;
-        }
-        for (face *f : faces) {
-            if (f != NULL)
-                delete f;
-        }
-    }
+    object() : geometry(NULL), edges(NULL) {}
+    object(const tri_mesh *geometry, const vector<mesh_edge> *edges) :
+            geometry(geometry), edges(edges) {}
 };
 
+void build_mesh_edges(const tri_mesh& mesh, vector<mesh_edge>& edges);
+
 void output_object_vertices(vector<object *> objects);
 void output_object_vertices(object *o);
 void output_object_faces(vector<object *> objects);
@@ -103,12 +84,28 @@ struct scene {
     float top;
     float bottom;
     vector<object *> objects;
-    scene() {}
+    // The meshes the objects are made from, one for each file, and the edges
+    // of each
+    vector<tri_mesh *> meshes;
+    vector<vector<mesh_edge> *> mesh_edges;
+    // Filled by set_camera_matrices, or set_camera_transform to move the
+    // camera somewhere else
+    affine_transform<double> world_to_cam_mat;
+    bool camera_matrices_set;
+    scene() : camera_matrices_set(false) {}
     ~scene() {
         for (object *o : objects) {
             if (o != NULL)
                 delete o;
         }
+        for (tri_mesh *m : meshes) {
+            if (m != NULL)
+                delete m;
+        }
+        for (vector<mesh_edge> *e : mesh_edges) {
+            if (e != NULL)
+                delete e;
+        }
     }
     void print() {
         cout << "position " << position.x << " " << position.y << " " << position.z
@@ -1,187 +1,277 @@
 #include "rasterizer.h"
 #include <cmath>
-#include <sstream>
 #include <algorithm>
 #include <iostream>
 
 using namespace std;
 
 /*
- * Outlines all objects in a scene.
+ * Draws lines into a band's grid, and then colors the band into rgb: the
+ * points that were filled are in the object's color, and the rest in the
+ * background color.
  */
-void draw_objects(scene *s, vector<char>& grid, int xres, int yres) {
-    for (object *o : s->objects) {
-        draw_object(o, grid, xres, yres);
+static void draw_band(const vector<line_segment>& lines, grid_band& grid,
+        vector<unsigned char>& rgb) {
+    for (const line_segment& l : lines) {
+        bresenham(l, grid);
+    }
+    rgb.resize(3 * grid.cells.size());
+    for (size_t i = 0; i < grid.cells.size(); i++) {
+        bool filled = grid.cells[i] == 1;
+        rgb[3 * i] = filled ? OBJECT_R : BG_R;
+        rgb[3 * i + 1] = filled ? OBJECT_G : BG_G;
+        rgb[3 * i + 2] = filled ? OBJECT_B : BG_B;
     }
 }
 
 /*
- * Outlines all the faces of an object onto a grid using bresenham.
+ * Draws a scene's wireframe and writes it out as an image, band_height rows
+ * at a time starting from the top. Each band is written as soon as it's
+ * drawn, and its grid is then reused for the next, so however large the image
+ * is, only one band of it is ever in memory. Every edge of the scene is
+ * clipped to the screen once, up front, and the lines that are left are
+ * bucketed by the bands they touch, so each band only draws the lines that
+ * reach it.
  */
-void draw_object(object *o, vector<char>& grid, int xres, int yres) {
-    for (face *f : o->faces) {
-        // For each face, draw each line (if vertices are valid)
-        float x1 = o->vertices[f->v1]->screen_x;
-        float y1 = o->vertices[f->v1]->screen_y;
-        float x2 = o->vertices[f->v2]->screen_x;
-        float y2 = o->vertices[f->v2]->screen_y;
-        float x3 = o->vertices[f->v3]->screen_x;
-        float y3 = o->vertices[f->v3]->screen_y;
-        // Draw line between v1 and v2
-        if (x1 != -1 && x2 != -1)
-            bresenham(x1, y1, x2, y2, grid, xres, yres);
-        // Draw line between v2 and v3
-        if (x2 != -1 && x3 != -1)
-            bresenham(x2, y2, x3, y3, grid, xres, yres);
-        // Draw line between v3 and v1
-        if (x3 != -1 && x1 != -1)
-            bresenham(x3, y3, x1, y1, grid, xres, yres);
+bool write_scene_image(scene *s, int xres, int yres, int band_height,
+        FILE *file, image_format format) {
+    band_buckets bands;
+    bucket_scene_edges(s, xres, yres, band_height, bands);
+
+    image_writer writer(file, xres, yres, format);
+    vector<unsigned char> rgb;
+    for (size_t band = 0; band < bands.size(); band++) {
+        int first_row = band * band_height;
+        int last_row = min(first_row + band_height, yres);
+        grid_band grid(xres, yres, first_row, last_row);
+        draw_band(bands[band], grid, rgb);
+        // The band's lines aren't needed again
+        vector<line_segment>().swap(bands[band]);
+        writer.write_rows(rgb.data(), last_row - first_row);
     }
+    return writer.finish();
 }
 
 /*
- * This is the generalized Bresenham algorithm. It "draws" a line from
- * x0 to y0 by filling in the points on the line with 1s on the passed-in
- * grid array.
- *
- * We generalize the naive_first_octant_bresenham by making the following changes.
- * First, we determine if the abs(slope) > 1. If it is, then we want to flip
- * the axis we are iterating on. We also want to invert the slope, because since
- * we are iterating on a different axis, we are looking at the slope from a
- * different perspective.
- * That is, if abs(slope) > 1, we want to iterate on y values. Then, if the slope
- * is negative, then instead of incrementing x or y (the variable we are not
- * iterating on) by 1, we want to decrement.
- * Note that depending on the sign of (x1 - x0) and (y1 - y0), we'll either be
- * adding or subtracting values in different places. This is just to account for
- * moving with or against the slope.
- *
- * So basically, for large slopes, we do a "swap" of x and y, and for negative
- * slopes, we modify the sign of certain values.
+ * Draws a scene's whole wireframe into rgb, top row first, for when the
+ * image is wanted in memory rather than written straight out, like the
+ * frames of an animation.
  */
-void bresenham(int x0, int y0, int x1, int y1, vector<char>& grid, int xres, int yres) {
-    float error = 0;
-    int change_val_y = (y0 < y1) ? 1 : -1;
-    int change_val_x = (x0 < x1) ? 1 : -1;
-
-    // Check if line is vertical
-    if (x0 == x1) {
-        int y = y0;
-        int x = x0;
-        while (y != y1) {
-            fill_grid(x, y, xres, yres, grid);
-            y = y + change_val_y;
-        }
-        fill_grid(x, y, xres, yres, grid);
-        return;
-    }
+void draw_scene_image(scene *s, int xres, int yres,
+        vector<unsigned char>& rgb) {
+    band_buckets bands;
+    bucket_scene_edges(s, xres, yres, yres, bands);
+    grid_band grid(xres, yres, 0, yres);
+    draw_band(bands[0], grid, rgb);
+}
 
-    //Check if line is horizontal
-    if (y0 == y1) {
-        int y = y0;
-        int x = x0;
-        while (x != x1) {
-            fill_grid(x, y, xres, yres, grid);
-            x = x + change_val_x;
-        }
-        fill_grid(x, y, xres, yres, grid);
-        return;
+/*
+ * Clips every edge of a scene's objects to the screen, and lists the lines
+ * that are left in the buckets of the bands of band_height rows they touch.
+ * Each mesh lists its edges once, so an edge two faces share is only clipped
+ * and drawn once.
+ */
+void bucket_scene_edges(scene *s, int xres, int yres, int band_height,
+        band_buckets& bands) {
+    bands.assign((yres + band_height - 1) / band_height,
+            vector<line_segment>());
+    if (bands.size() == 1) {
+        size_t edge_count = 0;
+        for (object *o : s->objects)
+            edge_count += o->edges->size();
+        bands[0].reserve(edge_count);
     }
 
-    float m = (float) (y1 - y0) / (x1 - x0);
-    if (abs(m) > 1) { // Iterate on y
-        int x = x0;
-        // We are iterating on y, so invert the slope
-        m = 1.0 / m;
-        int y = y0;
-        while (y != y1) {
-            float sign_m = change_val_y * m;
-            fill_grid(x, y, xres, yres, grid);
-            if (abs(error + sign_m) <= 0.5) {
-                error = error + sign_m;
-            } else {
-                error = error + sign_m - change_val_x;
-                x = x + change_val_x;
-            }
-            y = y + change_val_y;
-        }
-        fill_grid(x, y, xres, yres, grid);
-    } else { // Iterate on x
-        int y = y0;
-        int x = x0;
-        while (x != x1) {
-            float sign_m = change_val_x * m;
-            fill_grid(x, y, xres, yres, grid);
-            if (abs(error + sign_m) <= 0.5) {
-                error = error + sign_m;
-            } else {
-                error = error + sign_m - change_val_y;
-                y = y + change_val_y;
+    for (object *o : s->objects) {
+        for (const mesh_edge& e : *o->edges) {
+            line_segment l;
+            if (!clip_edge(o, e.a, e.b, xres, yres, l))
+                continue;
+            // Rows count down from the top, so the highest point comes first
+            int first_band = (yres - 1 - max(l.y0, l.y1)) / band_height;
+            int last_band = (yres - 1 - min(l.y0, l.y1)) / band_height;
+            for (int band = first_band; band <= last_band; band++) {
+                bands[band].push_back(l);
             }
-            x = x + change_val_x;
         }
-        fill_grid(x, y, xres, yres, grid);
     }
 }
 
 /*
- * Fill a point in the grid.
+ * Returns the pixel a clipped screen coordinate falls in. The far edge of the
+ * screen belongs to the last pixel.
  */
-void fill_grid(int x, int y, int xres, int yres, vector<char>& grid) {
-    //cout << "Drawing point at (" << x << "," << y << ")" << endl;
-    grid[(yres - y - 1) * xres + x] = 1;
+static int to_pixel(float coordinate, int res) {
+    return min(max((int) coordinate, 0), res - 1);
 }
 
 /*
- * Creates a ppm struct with the given resolution, based on the passed-in
- * grid.
+ * Clips the edge between vertices a and b of an object to the part of it
+ * that's on the screen, and sets segment to the pixels at its ends. Returns
+ * false if none of the edge is left.
+ *
+ * The clipping is done with Liang-Barsky, in homogeneous clip coordinates,
+ * before anything is divided by w. A point is on the screen when -w <= x <= w
+ * and -w <= y <= w, so each side of the screen is a plane the edge is on the
+ * inside of where w + x, w - x, w + y or w - y is non-negative. Each plane
+ * the edge crosses bounds how far along it the inside goes, as a fraction t
+ * of the way from a to b, and whatever's inside all four bounds is kept. Those
+ * planes only meet at the camera, so a point inside all of them is in front of
+ * it, and the part of an edge behind the camera, which the perspective divide
+ * would flip around onto the screen, is cut off too. An end that's already on
+ * the screen keeps its screen position exactly.
  */
-ppm create_ppm(int xres, int yres, vector<char> grid) {
-    vector<string> lines;
-    string header("P3");
-    lines.push_back(header);
-
-    ostringstream res_string_stream;
-    res_string_stream << xres << " " << yres;
-    string res_line = res_string_stream.str();
-    lines.push_back(res_line);
-
-    string intensity("255");
-    lines.push_back(intensity);
-
-    // Equation of circle is (x - x_center)^2 + (y - y_center)^2 = r^2
-    for (int y = 0; y < yres; y++) {
-        for (int x = 0; x < xres; x++) {
-            // Check if pixel is inside circle
-            if (grid[y * xres + x] == 1) {
-                lines.push_back(get_object_line());
-            } else {
-                lines.push_back(get_bg_line());
-            }
+bool clip_edge(const object *o, int a, int b, int xres, int yres,
+        line_segment& segment) {
+    const vector<float>& x = o->clip_x;
+    const vector<float>& y = o->clip_y;
+    const vector<float>& w = o->clip_w;
+    float t0 = 0;
+    float t1 = 1;
+    for (int side = 0; side < 4; side++) {
+        const vector<float>& axis = (side < 2) ? x : y;
+        float sign = (side % 2 == 0) ? 1 : -1;
+        float inside_a = w[a] + sign * axis[a];
+        float inside_b = w[b] + sign * axis[b];
+        if (inside_a < 0 && inside_b < 0)
+            return false;
+        // Where the edge crosses the plane
+        if (inside_a < 0)
+            t0 = max(t0, inside_a / (inside_a - inside_b));
+        else if (inside_b < 0)
+            t1 = min(t1, inside_a / (inside_a - inside_b));
+        if (t0 > t1)
+            return false;
+    }
+
+    float end_x[2];
+    float end_y[2];
+    float ts[2] = {t0, t1};
+    for (int end = 0; end < 2; end++) {
+        float t = ts[end];
+        if (t == end) {
+            int v = end ? b : a;
+            end_x[end] = o->screen_x[v];
+            end_y[end] = o->screen_y[v];
+            continue;
         }
+        float inv_w = 1.0f / (w[a] + t * (w[b] - w[a]));
+        end_x[end] = ((x[a] + t * (x[b] - x[a])) * inv_w + 1) * (xres / 2.0f);
+        end_y[end] = ((y[a] + t * (y[b] - y[a])) * inv_w + 1) * (yres / 2.0f);
     }
+    // Only an edge through the camera itself has no screen position left
+    if (!(isfinite(end_x[0]) && isfinite(end_y[0]) && isfinite(end_x[1])
+                && isfinite(end_y[1])))
+        return false;
 
-    ppm p(xres, yres);
-    p.lines = lines;
-    return p;
+    segment.x0 = to_pixel(end_x[0], xres);
+    segment.y0 = to_pixel(end_y[0], yres);
+    segment.x1 = to_pixel(end_x[1], xres);
+    segment.y1 = to_pixel(end_y[1], yres);
+    return true;
 }
 
 /*
- * Returns a string representing a pixel in the circle.
+ * This is the generalized Bresenham algorithm. It "draws" a line between two
+ * pixels by filling in the points on the line with 1s on the passed-in grid,
+ * in whichever rows of it are in the band being drawn.
+ *
+ * The line takes a step of one pixel along its major axis, the one it
+ * changes most along, each time, and a = |change along the major axis| steps
+ * in all. Along the minor axis it changes by b <= a in total, so after k
+ * steps it should be k * b / a of the way over, and that's rounded to the
+ * nearest pixel, ties staying put:
+ *
+ *     m(k) = floor((2 k b + a - 1) / (2 a))
+ *
+ * Rather than dividing every step, the remainder r of that division is kept.
+ * Each step adds 2 b to it, and whenever it reaches 2 a it wraps around and
+ * the line moves over a pixel on the minor axis. Everything is an integer, so
+ * a line comes out the same whichever octant it's in and however long it is.
+ *
+ * Since m(k) can be solved for k, the steps whose pixels are in the band are
+ * worked out directly, and the line starts at the first of them instead of
+ * walking up to the band. Moving a row up or down the screen is a step of
+ * xres through the grid, so the pixels are written through a running row
+ * offset, with no multiply or band check per pixel.
  */
-string get_object_line() {
-    ostringstream color_string_stream;
-    color_string_stream << OBJECT_R << " " << OBJECT_G << " " << OBJECT_B;
-    string color_string = color_string_stream.str();
-    return color_string;
-}
+void bresenham(const line_segment& l, grid_band& grid) {
+    // The band's screen rows, which count up from the bottom
+    int y_low = grid.yres - grid.last_row;
+    int y_high = grid.yres - 1 - grid.first_row;
+    char *cells = grid.cells.data();
+    int x_step = (l.x0 < l.x1) ? 1 : -1;
+    int y_step = (l.y0 < l.y1) ? 1 : -1;
+    ptrdiff_t row_step = -y_step * (ptrdiff_t) grid.xres;
 
-/*
- * Returns a string representing a pixel in the background.
- */
-string get_bg_line() {
-    ostringstream color_string_stream;
-    color_string_stream << BG_R << " " << BG_G << " " << BG_B;
-    string color_string = color_string_stream.str();
-    return color_string;
+    int dx = abs(l.x1 - l.x0);
+    int dy = abs(l.y1 - l.y0);
+    if (dx == 0 && dy == 0) {
+        if (l.y0 >= y_low && l.y0 <= y_high)
+            cells[(ptrdiff_t) (y_high - l.y0) * grid.xres + l.x0] = 1;
+        return;
+    }
+
+    // How far the band's rows are from the first end, in the direction the
+    // line goes
+    int band_low = (y_step > 0) ? y_low - l.y0 : l.y0 - y_high;
+    int band_high = (y_step > 0) ? y_high - l.y0 : l.y0 - y_low;
+    bool y_major = dy > dx;
+    int64_t a = y_major ? dy : dx;
+    int64_t b = y_major ? dx : dy;
+
+    // The steps that land in the band
+    int64_t k_first = 0;
+    int64_t k_last = a;
+    if (y_major) {
+        k_first = max<int64_t>(k_first, band_low);
+        k_last = min<int64_t>(k_last, band_high);
+    } else {
+        if (band_high < 0 || band_low > b)
+            return;
+        if (b > 0) {
+            // The first k with m(k) >= band_low, and the last with
+            // m(k) <= band_high
+            if (band_low > 0)
+                k_first = (2 * a * band_low - (a - 1) + 2 * b - 1) / (2 * b);
+            k_last = min(k_last, (2 * a * (band_high + 1) - a) / (2 * b));
+        }
+    }
+    if (k_first > k_last)
+        return;
+
+    int64_t start = 2 * k_first * b + a - 1;
+    int m = start / (2 * a);
+    int r = start % (2 * a);
+    int two_a = 2 * a;
+    int two_b = 2 * b;
+    int count = k_last - k_first + 1;
+
+    if (y_major) {
+        int x = l.x0 + x_step * m;
+        int y = l.y0 + y_step * k_first;
+        ptrdiff_t row = (ptrdiff_t) (y_high - y) * grid.xres;
+        for (int k = 0; k < count; k++) {
+            cells[row + x] = 1;
+            row += row_step;
+            r += two_b;
+            if (r >= two_a) {
+                r -= two_a;
+                x += x_step;
+            }
+        }
+    } else {
+        int x = l.x0 + x_step * k_first;
+        int y = l.y0 + y_step * m;
+        ptrdiff_t row = (ptrdiff_t) (y_high - y) * grid.xres;
+        for (int k = 0; k < count; k++) {
+            cells[row + x] = 1;
+            x += x_step;
+            r += two_b;
+            if (r >= two_a) {
+                r -= two_a;
+                row += row_step;
+            }
+        }
+    }
 }
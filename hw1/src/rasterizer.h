@@ -2,6 +2,7 @@
 #define RASTERIZER_H
 
 #include "framework.h"
+#include "image_writer.h"
 
 using namespace std;
 
@@ -13,24 +14,45 @@ const int BG_R = 45;
 const int BG_G = 18;
 const int BG_B = 10;
 
-struct ppm {
-    vector<string> lines;
+// The part of the image being drawn: its rows from first_row up to but not
+// including last_row, counted down from the top, with a char per pixel that
+// is 1 where a line was drawn. Drawing the image a band at a time means only
+// a band's worth of it is ever in memory
+struct grid_band {
     int xres;
     int yres;
-    ppm(int x, int y) : xres(x), yres(y) {}
+    int first_row;
+    int last_row;
+    vector<char> cells;
+    grid_band(int xres, int yres, int first_row, int last_row) : xres(xres),
+            yres(yres), first_row(first_row), last_row(last_row),
+            cells((size_t) xres * (last_row - first_row)) {}
 };
 
+// A line to draw, already clipped to the screen, from pixel (x0, y0) to pixel
+// (x1, y1). Screen y counts up from the bottom
+struct line_segment {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+};
+
+// The lines touching each band of the image, top band first
+typedef vector<vector<line_segment> > band_buckets;
+
 /*******************************************************************************
  * Defines methods needed for drawing stuff
  ******************************************************************************/
 
-ppm create_ppm(int xres, int yres, vector<char> grid);
-string get_object_line();
-string get_bg_line();
-void draw_objects(scene *s, vector<char>& grid, int xres, int yres);
-void draw_object(object *o, vector<char>& grid, int xres, int yres);
-void bresenham(int x0, int y0, int x1, int y1, vector<char>& grid,
-        int xres, int yres);
-void fill_grid(int x, int y, int xres, int yres, vector<char>& grid);
+bool write_scene_image(scene *s, int xres, int yres, int band_height,
+        FILE *file, image_format format);
+void draw_scene_image(scene *s, int xres, int yres,
+        vector<unsigned char>& rgb);
+void bucket_scene_edges(scene *s, int xres, int yres, int band_height,
+        band_buckets& bands);
+bool clip_edge(const object *o, int a, int b, int xres, int yres,
+        line_segment& segment);
+void bresenham(const line_segment& l, grid_band& grid);
 
 #endif
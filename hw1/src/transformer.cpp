@@ -4,96 +4,90 @@
 using namespace std;
 
 /*
- * For every object in a scene, initialize the screen coordinate members of all
- * its vertices (using the overloaded method).
+ * Applies all relevant transformations to every object in the scene, and maps
+ * their vertices to screen coordinates in a yres-by-xres pixel grid.
  */
-void map_to_screen_coords(scene *s, int xres, int yres) {
+void apply_all_transformations(scene *s, int xres, int yres) {
     for (object *o : s->objects)
-        map_to_screen_coords(o, xres, yres);
+        apply_all_transformations(o, s, xres, yres);
 }
 
 /*
- * Goees through all vertices of an object and initializes their screen_x and
- * screen_y members. These memebers show how the NDC points map to screen coordinates
- * in a yres-by-xres pixel grid.
+ * Given an object, applies all relevant transformations to it. The geometric,
+ * world -> camera and camera -> NDC transforms are multiplied into one matrix
+ * first, so each vertex is only transformed once.
  */
-void map_to_screen_coords(object *o, int xres, int yres) {
-    for (vertex *v : o->vertices) {
-        if (v == NULL)
-            continue;
-        // Check to see if points fall outside of perspective cube
-        if (abs(v->x) >= 1 || abs(v->y) >= 1)
-            continue;
-        // Add one to make sure everything is non-negative, and then divide by
-        // 2 to scale everything back (because v->x and v->y now range from 0-2)
-        v->screen_x = (v->x + 1) * xres / 2;
-        v->screen_y = (v->y + 1) * yres / 2;
-    }
+void apply_all_transformations(object *o, scene *s, int xres, int yres) {
+    transform_object(o, get_object_ndc_matrix(o, s), xres, yres);
 }
 
 /*
- * Applies all relevant transformations to every object in the scene.
+ * Returns the matrix taking an object's mesh to Cartesian NDC: its geometric
+ * transforms, followed by the world -> camera transform and the perspective
+ * projection. The product is taken in double precision and only then rounded
+ * to float.
  */
-void apply_all_transformations(scene *s) {
-    for (object *o : s->objects)
-        apply_all_transformations(o, s);
+Matrix4f get_object_ndc_matrix(object *o, scene *s) {
+    set_camera_matrices(s);
+    affine_transform<double> world_transf =
+        s->world_to_cam_mat * o->transformations.product;
+    Matrix4d m = get_perspective_projection_matrix(s) * world_transf.matrix();
+    return m.cast<float>();
 }
 
 /*
- * Given an object, applies all relevant transformations to it.
+ * Transforms points 1 to count of the coordinate arrays px, py and pz by a
+ * matrix into homogeneous clip coordinates cx, cy and cw, and maps the
+ * NDC point each divides out to onto fractional screen coordinates in a
+ * yres-by-xres pixel grid. The matrix entries are held in locals and none of
+ * the arrays overlap, so the compiler turns this into SIMD code.
  */
-void apply_all_transformations(object *o, scene *s) {
-    // Apply geometric transforms specified by matrices stored by object
-    transform_object_geom(o);
-    // Apply world -> camera transform
-    transform_object_camera(o, s);
-    // Apply camera -> Cartesian NDC transform
-    transform_object_ndc(o, s);
-}
+static void transform_points(const Matrix4f& mat, int xres, int yres,
+        int count, const float *__restrict px, const float *__restrict py,
+        const float *__restrict pz, float *__restrict cx,
+        float *__restrict cy, float *__restrict cw, float *__restrict sx,
+        float *__restrict sy) {
+    const float m00 = mat(0, 0), m01 = mat(0, 1), m02 = mat(0, 2),
+        m03 = mat(0, 3);
+    const float m10 = mat(1, 0), m11 = mat(1, 1), m12 = mat(1, 2),
+        m13 = mat(1, 3);
+    const float m30 = mat(3, 0), m31 = mat(3, 1), m32 = mat(3, 2),
+        m33 = mat(3, 3);
+    const float half_xres = xres / 2.0f;
+    const float half_yres = yres / 2.0f;
 
-/*
- * Applies a transformation (specified by a matrix) to the vertices of an
- * object.
- */
-void transform_object(object *o, MatrixXd mat) {
-    for (vertex *v : o->vertices) {
-        if (v == NULL)
-            continue;
-        MatrixXd vec(4,1);
-        vec << v->x, v->y, v->z, 1;
-        MatrixXd t_vec = mat * vec;
-        // Adjust the vector back to 3 dimensions, and change the vertex
-        float w = t_vec(3, 0);
-        v->x = t_vec(0,0) / w;
-        v->y = t_vec(1,0) / w;
-        v->z = t_vec(2,0) / w;
+    for (int i = 1; i <= count; i++) {
+        float x = px[i], y = py[i], z = pz[i];
+        float w = m30 * x + m31 * y + m32 * z + m33;
+        float clip_x = m00 * x + m01 * y + m02 * z + m03;
+        float clip_y = m10 * x + m11 * y + m12 * z + m13;
+        cx[i] = clip_x;
+        cy[i] = clip_y;
+        cw[i] = w;
+        // Add one to the NDC coordinates to make the screen non-negative, and
+        // then scale the 0-2 range to the grid
+        float inv_w = 1.0f / w;
+        sx[i] = (clip_x * inv_w + 1) * half_xres;
+        sy[i] = (clip_y * inv_w + 1) * half_yres;
     }
 }
 
 /*
- * Applies a geometric transformation on an object given the vector of
- * transformation matrices it has stored.
+ * Transforms the vertices of an object's mesh by a matrix into its clip and
+ * screen coordinate buffers, in a single pass over the mesh.
  */
-void transform_object_geom(object *o) {
-    MatrixXd m = compute_product(o->transformations);
-    transform_object(o, m);
-}
-
-/*
- * Applies the world -> camera transformation to an object.
- */
-void transform_object_camera(object *o, scene *s) {
-    MatrixXd world_transf_mat = get_world_transform_matrix(s->position, s->orient);
-    transform_object(o, world_transf_mat);
-}
-
-/*
- * Applies the perspective projection matrix to an object, transforming a point
- * in camera space to the Cartesian NDC (because we divide all the terms by w_{ndc})
- */
-void transform_object_ndc(object *o, scene *s) {
-    MatrixXd ndc_transf_mat = get_perspective_projection_matrix(s);
-    transform_object(o, ndc_transf_mat);
+void transform_object(object *o, const Matrix4f& mat, int xres, int yres) {
+    const coordinate_arrays& p = o->geometry->positions;
+    int count = p.count();
+    o->clip_x.resize(count + 1);
+    o->clip_y.resize(count + 1);
+    o->clip_w.resize(count + 1);
+    o->screen_x.resize(count + 1);
+    o->screen_y.resize(count + 1);
+    // The 0 index isn't a vertex, so it's left as it is
+    transform_points(mat, xres, yres, count, p.x.data(), p.y.data(),
+            p.z.data(), o->clip_x.data(), o->clip_y.data(), o->clip_w.data(),
+            o->screen_x.data(), o->screen_y.data());
 }
 
 /*
@@ -105,40 +99,58 @@ void transform_object_ndc(object *o, scene *s) {
  *
  * Note that position and orient are the position and orientation of the camera.
  */
-MatrixXd get_camera_transform_matrix(vertex position, orientation orient) {
-    MatrixXd transl_mat = get_translation_matrix(position.x, position.y,
-            position.z);
-    MatrixXd rot_mat = get_rotation_matrix(orient.x, orient.y,
-            orient.z, orient.angle);
-    vector<MatrixXd> matrices;
-    matrices.push_back(transl_mat);
-    matrices.push_back(rot_mat);
-    MatrixXd cam_transf_mat = compute_product(matrices);
-    return cam_transf_mat;
+affine_transform<double> get_camera_transform_matrix(vertex position,
+        orientation orient) {
+    transform_chain<double> camera;
+    camera.translate(position.x, position.y, position.z);
+    camera.rotate(orient.x, orient.y, orient.z, orient.angle);
+    return camera.product;
 }
 
 /*
  * Calculates and returns the matrix that transforms world coordinates to
  * camera coordinates. To do this, we just need to multiply by the inverse
- * of the camera transform. So this just returns the inverse.
+ * of the camera transform, which is rigid, so it's inverted by transposing
+ * its rotation rather than by a general matrix inverse.
+ */
+affine_transform<double> get_world_transform_matrix(vertex position,
+        orientation orient) {
+    return rigid_inverse(get_camera_transform_matrix(position, orient));
+}
+
+/*
+ * Computes a scene's world -> camera matrix from its camera, unless that's
+ * already been done.
+ */
+void set_camera_matrices(scene *s) {
+    if (s->camera_matrices_set)
+        return;
+    s->world_to_cam_mat = get_world_transform_matrix(s->position, s->orient);
+    s->camera_matrices_set = true;
+}
+
+/*
+ * Moves a scene's camera to the one the given camera transform places, for
+ * drawing the frames of an animation. The objects need transforming again
+ * afterwards.
  */
-MatrixXd get_world_transform_matrix(vertex position, orientation orient) {
-    MatrixXd cam_transf_mat = get_camera_transform_matrix(position, orient);
-    return cam_transf_mat.inverse();
+void set_camera_transform(scene *s, const affine_transform<double>& camera) {
+    s->world_to_cam_mat = rigid_inverse(camera);
+    s->camera_matrices_set = true;
 }
 
 /*
  * Given a scene, return the perspective projection matrix for that scene as
  * described in the assignment.
  */
-MatrixXd get_perspective_projection_matrix(scene *s) {
+Matrix4d get_perspective_projection_matrix(scene *s) {
     float n = s->near;
     float f = s->far;
     float r = s->right;
     float l = s->left;
     float b = s->bottom;
     float t = s->top;
-    MatrixXd m(4, 4);
+    Matrix4d m;
     m <<
         (2 * n) / (r - l), 0, (r + l) / (r - l), 0,
         0, (2 * n) / (t - b), (t + b) / (t - b), 0,
@@ -4,25 +4,25 @@
 #include "parser.h"
 #include <Eigen/Dense>
 
-using Eigen::MatrixXd;
+using Eigen::Matrix4d;
+using Eigen::Matrix4f;
 using namespace std;
 
 /*******************************************************************************
  * Defines methods needed for transforming/mapping vertices
  ******************************************************************************/
 
-/* Part 4 */
-void map_to_screen_coords(scene *s, int xres, int yres);
-void map_to_screen_coords(object *o, int xres, int yres);
-/* Parts 2-3 */
-void apply_all_transformations(scene *s);
-void apply_all_transformations(object *o, scene *s);
-void transform_object(object *o, MatrixXd mat);
-void transform_object_camera(object *o, scene *s);
-void transform_object_ndc(object *o, scene *s);
-void transform_object_geom(object *o);
-MatrixXd get_camera_transform_matrix(vertex position, orientation orient);
-MatrixXd get_world_transform_matrix(vertex position, orientation orient);
-MatrixXd get_perspective_projection_matrix(scene *s);
+/* Parts 2-4 */
+void apply_all_transformations(scene *s, int xres, int yres);
+void apply_all_transformations(object *o, scene *s, int xres, int yres);
+void transform_object(object *o, const Matrix4f& mat, int xres, int yres);
+Matrix4f get_object_ndc_matrix(object *o, scene *s);
+affine_transform<double> get_camera_transform_matrix(vertex position,
+        orientation orient);
+affine_transform<double> get_world_transform_matrix(vertex position,
+        orientation orient);
+Matrix4d get_perspective_projection_matrix(scene *s);
+void set_camera_matrices(scene *s);
+void set_camera_transform(scene *s, const affine_transform<double>& camera);
 
 #endif
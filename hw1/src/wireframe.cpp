@@ -4,32 +4,77 @@
 #include <fstream>
 #include "rasterizer.h"
 #include "transformer.h"
+#include "camera_path.h"
+#include "image_sequence.h"
 
 using Eigen::MatrixXd;
 using namespace std;
 
+/*
+ * Builds the camera transform of a camera path's pose the way the scene
+ * file's camera is read.
+ */
+static affine_transform<double> place_camera(const camera_pose& pose) {
+    vertex position(pose.x, pose.y, pose.z);
+    orientation orient(pose.axis_x, pose.axis_y, pose.axis_z, pose.angle);
+    return get_camera_transform_matrix(position, orient);
+}
+
+/*
+ * Draws a frame of the scene for each camera on a camera path, writing them
+ * out as numbered images. The meshes are only read once, and each frame only
+ * transforms and draws them again, while the frame before is written out.
+ */
+static bool write_animation(scene *s, int xres, int yres, image_format format,
+        const char *path, const char *prefix) {
+    vector<affine_transform<double> > cameras;
+    if (!read_camera_path(path, get_camera_transform_matrix(s->position,
+                    s->orient), place_camera, cameras))
+        return false;
+
+    image_sequence_writer frames(prefix, xres, yres, format);
+    vector<unsigned char> rgb;
+    for (const affine_transform<double>& camera : cameras) {
+        set_camera_transform(s, camera);
+        apply_all_transformations(s, xres, yres);
+        draw_scene_image(s, xres, yres, rgb);
+        if (!frames.write_frame(rgb))
+            return false;
+    }
+    return frames.finish();
+}
+
 int main(int argc, const char* argv[]) {
-    // Should be 3 arguments: the scene description file, xres, and yres
-    assert (argc == 4);
+    // Should be 3 arguments: the scene description file, xres, and yres,
+    // optionally followed by the image format to output (p3, p6 or png) and
+    // the number of rows to draw at a time (0, the default, for all of them).
+    // Those can be followed by a camera path and a filename prefix to draw an
+    // animation instead (see camera_path.h), whose frames are drawn whole
+    assert ((argc >= 4 && argc <= 6) || argc == 8);
 
     ifstream infile(argv[1]);
     int xres = atoi(argv[2]);
     int yres = atoi(argv[3]);
+    image_format format = P6_IMAGE;
+    if (argc >= 5 && !parse_image_format(argv[4], format)) {
+        fprintf(stderr, "wireframe ERROR unknown image format %s\n", argv[4]);
+        return 1;
+    }
+    int band_height = (argc >= 6) ? atoi(argv[5]) : 0;
+    if (band_height <= 0 || band_height > yres)
+        band_height = yres;
     scene *s = parse_scene(infile);
 
+    if (argc == 8)
+        return write_animation(s, xres, yres, format, argv[6], argv[7]) ? 0
+            : 1;
 
-    // Applying all transformations to scene's objects
-    apply_all_transformations(s);
-    // Initializing screen coordinate members of vertices for all objects
-    map_to_screen_coords(s, xres, yres);
+    // Applying all transformations to scene's objects, which also maps their
+    // vertices to screen coordinates
+    apply_all_transformations(s, xres, yres);
 
-    vector<char> grid(yres * xres);
-    // Fill grid
-    draw_objects(s, grid, xres, yres);
-    // Create ppm from grid
-    ppm p = create_ppm(xres, yres, grid);
-    // Output ppm
-    for (string line : p.lines)
-        cout << line << endl;
+    // Draw the scene a band at a time, outputting each band to stdout
+    return write_scene_image(s, xres, yres, band_height, stdout, format) ? 0
+        : 1;
 }
 
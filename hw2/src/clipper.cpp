@@ -0,0 +1,169 @@
+#include "clipper.h"
+#include "transformer.h"
+#include <algorithm>
+
+using namespace std;
+
+// The planes faces are clipped against, in the order they are clipped. The
+// near plane comes first, so that every point clipped against the others is
+// in front of the camera
+enum clip_plane {
+    near_plane,
+    far_plane,
+    left_plane,
+    right_plane,
+    bottom_plane,
+    top_plane,
+    plane_count
+};
+
+// A corner of a face being clipped, in clip space, with its barycentric
+// coordinates within the face
+struct clip_point {
+    double x;
+    double y;
+    double z;
+    double w;
+    double weights[3];
+};
+
+/*
+ * Returns how far inside a plane of the view frustum a point is, scaled by
+ * its w. This is negative for points outside it.
+ */
+static double plane_distance(const clip_point& p, int plane) {
+    switch (plane) {
+    case near_plane:
+        return p.w + p.z;
+    case far_plane:
+        return p.w - p.z;
+    case left_plane:
+        return guard_band * p.w + p.x;
+    case right_plane:
+        return guard_band * p.w - p.x;
+    case bottom_plane:
+        return guard_band * p.w + p.y;
+    default:
+        return guard_band * p.w - p.y;
+    }
+}
+
+/*
+ * Returns a bit for every plane the point is outside of.
+ */
+static int outcode(const clip_point& p) {
+    int code = 0;
+    for (int plane = 0; plane < plane_count; plane++) {
+        if (plane_distance(p, plane) < 0)
+            code |= 1 << plane;
+    }
+    return code;
+}
+
+/*
+ * Clips the polygon with the given corners against one plane, in the manner
+ * of Sutherland and Hodgman, and returns how many corners are left.
+ */
+static int clip_polygon(const clip_point *in, int count, int plane,
+        clip_point *out) {
+    int out_count = 0;
+    for (int i = 0; i < count; i++) {
+        const clip_point& a = in[i];
+        const clip_point& b = in[(i + 1) % count];
+        double d_a = plane_distance(a, plane);
+        double d_b = plane_distance(b, plane);
+        if (d_a >= 0)
+            out[out_count++] = a;
+        if ((d_a >= 0) == (d_b >= 0))
+            continue;
+
+        // The edge crosses the plane at a point a fraction t of the way to b
+        double t = d_a / (d_a - d_b);
+        clip_point& p = out[out_count++];
+        p.x = a.x + t * (b.x - a.x);
+        p.y = a.y + t * (b.y - a.y);
+        p.z = a.z + t * (b.z - a.z);
+        p.w = a.w + t * (b.w - a.w);
+        // In front of the camera, the rasterizer interpolates attributes
+        // linearly on the screen, so they are interpolated the same way along
+        // the projected edge. The near plane cuts through the part of the face
+        // with no sensible projection, so there they're interpolated in clip
+        // space
+        double s = (plane == near_plane) ? t : t * b.w / p.w;
+        for (int k = 0; k < 3; k++) {
+            p.weights[k] = a.weights[k] + s * (b.weights[k] - a.weights[k]);
+        }
+    }
+    return out_count;
+}
+
+/*
+ * Clips a face of an object crossing the edge of the view frustum. Faces
+ * entirely inside the frustum (up to the guard band at the sides) are drawn as
+ * they are, and faces entirely outside one of its planes are skipped.
+ * Otherwise the face is clipped, and the convex polygon left is split into a
+ * fan of pieces, which replace the contents of pieces.
+ */
+clip_result clip_face(face *f, object *o, int xres, int yres,
+        vector<face_piece>& pieces) {
+    int indices[] = {f->v1, f->v2, f->v3};
+    clip_point polygon[max_clipped_corners];
+    int codes_or = 0;
+    int codes_and = ~0;
+    for (int i = 0; i < 3; i++) {
+        const clip_vertex& v = o->clip_vertices[indices[i]];
+        clip_point& p = polygon[i];
+        p.x = v.x;
+        p.y = v.y;
+        p.z = v.z;
+        p.w = v.w;
+        for (int k = 0; k < 3; k++) {
+            p.weights[k] = (i == k) ? 1 : 0;
+        }
+        int code = outcode(p);
+        codes_or |= code;
+        codes_and &= code;
+    }
+    if (codes_and != 0)
+        return face_outside;
+    if (codes_or == 0)
+        return face_inside;
+
+    int count = 3;
+    clip_point clipped[max_clipped_corners];
+    for (int plane = 0; plane < plane_count && count > 0; plane++) {
+        if (codes_or & (1 << plane)) {
+            count = clip_polygon(polygon, count, plane, clipped);
+            copy(clipped, clipped + count, polygon);
+        }
+    }
+    if (count < 3)
+        return face_outside;
+
+    // Divide through by w and map the corners to the screen
+    clipped_corner corners[max_clipped_corners];
+    for (int i = 0; i < count; i++) {
+        const clip_point& p = polygon[i];
+        vertex ndc(p.x / p.w, p.y / p.w, p.z / p.w);
+        map_to_screen_coords(&ndc, xres, yres);
+        clipped_corner& corner = corners[i];
+        corner.x = ndc.x;
+        corner.y = ndc.y;
+        corner.z = ndc.z;
+        corner.screen_x = ndc.screen_x;
+        corner.screen_y = ndc.screen_y;
+        for (int k = 0; k < 3; k++) {
+            corner.weights[k] = p.weights[k];
+        }
+    }
+
+    pieces.clear();
+    for (int i = 1; i + 1 < count; i++) {
+        face_piece piece;
+        piece.corners[0] = corners[0];
+        piece.corners[1] = corners[i];
+        piece.corners[2] = corners[i + 1];
+        pieces.push_back(piece);
+    }
+    return face_clipped;
+}
@@ -0,0 +1,51 @@
+#ifndef CLIPPER_H
+#define CLIPPER_H
+
+#include "framework.h"
+
+using namespace std;
+
+/*******************************************************************************
+ * Defines the clipping of faces to the view frustum. Faces are clipped in
+ * homogeneous clip space, before the perspective divide, so that faces
+ * reaching behind the camera still come out right. The pieces left over are
+ * drawn instead of the face.
+ ******************************************************************************/
+
+// How far past the edges of the screen faces can reach before they are
+// clipped at the sides, in multiples of its half-width. The rasterizer only
+// visits the part of a face on the screen anyway, so the sides are only
+// clipped to keep screen coordinates in range
+static const double guard_band = 16;
+
+// A face is a triangle, and each of the six planes it is clipped against can
+// add a corner
+static const int max_clipped_corners = 9;
+
+// A corner of a piece of a clipped face, with its NDC and screen coordinates,
+// and the barycentric coordinates within the face that its attributes are
+// interpolated with
+struct clipped_corner {
+    float x;
+    float y;
+    float z;
+    int screen_x;
+    int screen_y;
+    float weights[3];
+};
+
+// One of the triangles a clipped face is split into
+struct face_piece {
+    clipped_corner corners[3];
+};
+
+enum clip_result {
+    face_outside,
+    face_inside,
+    face_clipped
+};
+
+clip_result clip_face(face *f, object *o, int xres, int yres,
+        vector<face_piece>& pieces);
+
+#endif
@@ -1,137 +1,419 @@
 #include "draw.h"
 #include "transformer.h"
-#include <sstream>
 #include <iostream>
 #include <algorithm>
 #include <cmath>
 
 using namespace std;
 
+// Side length of the square pixel blocks the rasterizer tests against a
+// triangle's edges before visiting their pixels
+static const int raster_block_size = 8;
+static_assert(raster_block_size == framebuffer_block_size,
+        "the rasterizer's blocks must line up with the framebuffer's");
+
+/*
+ * Sets up the integer edge function f_{ij} of the screen space edge from
+ * (x_i, y_i) to (x_j, y_j), so that f_{ij}(x, y) = a * x + b * y + c. The bias
+ * implements the top-left fill rule: it is 0 for top and left edges, and -1
+ * for the rest, so that pixels lying exactly on an edge two triangles share
+ * are only drawn by one of them.
+ */
+struct edge_function {
+    long long a;
+    long long b;
+    long long c;
+    long long bias;
+    edge_function(int x_i, int y_i, int x_j, int y_j) :
+            a(y_i - y_j), b(x_j - x_i),
+            c((long long) x_i * y_j - (long long) x_j * y_i) {}
+    long long at(int x, int y) const {
+        return a * x + b * y + c;
+    }
+    void flip() {
+        a = -a;
+        b = -b;
+        c = -c;
+    }
+    void set_bias() {
+        bias = (a > 0 || (a == 0 && b < 0)) ? 0 : -1;
+    }
+};
+
+/*
+ * Rasterizes a triangle given in NDC coordinates, whose screen coordinates
+ * have already been mapped, with backface culling and
+ * depth buffering. This is a half-space rasterizer: the three edge functions
+ * are set up once per triangle and stepped incrementally across each row,
+ * and blocks of the triangle's bounding box that lie entirely outside one of
+ * the edges are skipped with a single test. shade is called with the screen
+ * coordinates (x, y) and barycentric coordinates (alpha, beta, gamma) of every
+ * pixel that passes the depth test, and writes it out. Only the pixels inside
+ * bounds are drawn.
+ */
+template <typename Shader>
+static void raster_triangle(vertex *a, vertex *b, vertex *c,
+        framebuffer& fb, const tile& bounds, Shader shade) {
+    // Perform backface culling, ignoring faces facing away from the camera
+    Vector3f ndc_a = a->get_vec();
+    Vector3f ndc_b = b->get_vec();
+    Vector3f ndc_c = c->get_vec();
+    Vector3f cross = (ndc_c - ndc_b).cross(ndc_a - ndc_b);
+    if (cross(2, 0) < 0)
+        return;
+
+    int x_a = a->screen_x;
+    int y_a = a->screen_y;
+    int x_b = b->screen_x;
+    int y_b = b->screen_y;
+    int x_c = c->screen_x;
+    int y_c = c->screen_y;
+
+    // Clip the bounding box to the part of the grid being drawn
+    int x_min = max(min({x_a, x_b, x_c}), bounds.x_min);
+    int x_max = min(max({x_a, x_b, x_c}), bounds.x_max);
+    int y_min = max(min({y_a, y_b, y_c}), bounds.y_min);
+    int y_max = min(max({y_a, y_b, y_c}), bounds.y_max);
+    if (x_min > x_max || y_min > y_max)
+        return;
+
+    // The edge opposite each vertex gives its barycentric coordinate, so
+    // alpha = f_bc(x, y) / f_bc(x_a, y_a) and so on. All three denominators
+    // are twice the triangle's signed area
+    edge_function e_a(x_b, y_b, x_c, y_c);
+    edge_function e_b(x_c, y_c, x_a, y_a);
+    edge_function e_c(x_a, y_a, x_b, y_b);
+    long long area = e_a.at(x_a, y_a);
+    // Degenerate in screen space
+    if (area == 0)
+        return;
+    // Snapping to pixels can flip slivers, so make the inside positive
+    if (area < 0) {
+        e_a.flip();
+        e_b.flip();
+        e_c.flip();
+        area = -area;
+    }
+    e_a.set_bias();
+    e_b.set_bias();
+    e_c.set_bias();
+    float inv_area = 1.0 / area;
+    // If every corner is inside the NDC cube, every point of the triangle is
+    // too, so only the depth has to be checked per pixel
+    bool inside_cube = ndc_a.cwiseAbs().maxCoeff() <= 1
+        && ndc_b.cwiseAbs().maxCoeff() <= 1
+        && ndc_c.cwiseAbs().maxCoeff() <= 1;
+
+    for (int y0 = y_min & ~(raster_block_size - 1); y0 <= y_max;
+            y0 += raster_block_size) {
+        int y1 = y0 + raster_block_size - 1;
+        for (int x0 = x_min & ~(raster_block_size - 1); x0 <= x_max;
+                x0 += raster_block_size) {
+            int x1 = x0 + raster_block_size - 1;
+
+            // Each edge function is largest at one of the block's corners, so
+            // if it is negative there for any edge the block is empty
+            long long corners =
+                (e_a.at(e_a.a > 0 ? x1 : x0, e_a.b > 0 ? y1 : y0) + e_a.bias)
+                | (e_b.at(e_b.a > 0 ? x1 : x0, e_b.b > 0 ? y1 : y0) + e_b.bias)
+                | (e_c.at(e_c.a > 0 ? x1 : x0, e_c.b > 0 ? y1 : y0) + e_c.bias);
+            if (corners < 0)
+                continue;
+
+            int x_start = max(x0, x_min);
+            int x_end = min(x1, x_max);
+            int y_start = max(y0, y_min);
+            int y_end = min(y1, y_max);
+            long long row_a = e_a.at(x_start, y_start);
+            long long row_b = e_b.at(x_start, y_start);
+            long long row_c = e_c.at(x_start, y_start);
+            for (int y = y_start; y <= y_end; y++) {
+                // The block's row is contiguous in the framebuffer
+                float *depth_row = &fb.depth(x_start, y);
+                long long w_a = row_a;
+                long long w_b = row_b;
+                long long w_c = row_c;
+                for (int x = x_start; x <= x_end; x++) {
+                    // Check to make sure the point is inside the triangle
+                    if (((w_a + e_a.bias) | (w_b + e_b.bias)
+                            | (w_c + e_c.bias)) >= 0) {
+                        float alpha = w_a * inv_area;
+                        float beta = w_b * inv_area;
+                        float gamma = w_c * inv_area;
+                        float ndc_z = alpha * ndc_a(2) + beta * ndc_b(2)
+                            + gamma * ndc_c(2);
+                        // Check to see if NDC coords are in cube
+                        bool in_cube = abs(ndc_z) <= 1;
+                        if (!inside_cube) {
+                            float ndc_x = alpha * ndc_a(0) + beta * ndc_b(0)
+                                + gamma * ndc_c(0);
+                            float ndc_y = alpha * ndc_a(1) + beta * ndc_b(1)
+                                + gamma * ndc_c(1);
+                            in_cube = in_cube && abs(ndc_x) <= 1
+                                && abs(ndc_y) <= 1;
+                        }
+
+                        // Perform depth buffering, so we don't render points
+                        // behind other points
+                        if (in_cube && ndc_z <= depth_row[x - x_start]) {
+                            depth_row[x - x_start] = ndc_z;
+                            shade(x, y, alpha, beta, gamma);
+                        }
+                    }
+                    w_a += e_a.a;
+                    w_b += e_b.a;
+                    w_c += e_c.a;
+                }
+                row_a += e_a.b;
+                row_b += e_b.b;
+                row_c += e_c.b;
+            }
+        }
+    }
+}
+
 /*
- * This is the Gouraud shading algorithm. The idea is that for each face/triangle
- * of our object, we use the lighting model to calculate the illuminated color
- * at each vertex, and then use barycentric interpolation to rasterize the triangle.
- * This lends itself to Gouraud shading's other name, per vertex lighting.
+ * Finds the pixels a face's bounding box covers on a grid of the given
+ * resolution. Returns false if the face is culled as a backface or lies
+ * entirely off the grid, in which case it doesn't need to be rasterized.
  */
-void gouraud_shading(face *f, object *o, scene *s, MatrixColor& grid) {
-    vertex *a = o->vertices[f->v1];
-    vertex *b = o->vertices[f->v2];
-    vertex *c = o->vertices[f->v3];
+bool face_screen_bounds(face *f, object *o, int xres, int yres, tile& bounds) {
+    vertex *a = &o->ndc_vertices[f->v1];
+    vertex *b = &o->ndc_vertices[f->v2];
+    vertex *c = &o->ndc_vertices[f->v3];
 
-    f->c1 = lighting(a, o->normals[f->vn1], o->material, s);
-    f->c2 = lighting(b, o->normals[f->vn2], o->material, s);
-    f->c3 = lighting(c, o->normals[f->vn3], o->material, s);
+    Vector3f ndc_a = a->get_vec();
+    Vector3f ndc_b = b->get_vec();
+    Vector3f ndc_c = c->get_vec();
+    Vector3f cross = (ndc_c - ndc_b).cross(ndc_a - ndc_b);
+    if (cross(2, 0) < 0)
+        return false;
 
-    vertex *a_ndc = world_to_ndc(a, s);
-    vertex *b_ndc = world_to_ndc(b, s);
-    vertex *c_ndc = world_to_ndc(c, s);
+    bounds.x_min = max(min({a->screen_x, b->screen_x, c->screen_x}), 0);
+    bounds.x_max = min(max({a->screen_x, b->screen_x, c->screen_x}), xres - 1);
+    bounds.y_min = max(min({a->screen_y, b->screen_y, c->screen_y}), 0);
+    bounds.y_max = min(max({a->screen_y, b->screen_y, c->screen_y}), yres - 1);
+    return bounds.x_min <= bounds.x_max && bounds.y_min <= bounds.y_max;
+}
 
-    raster_colored_triangle(a_ndc, b_ndc, c_ndc,
-            f->c1, f->c2, f->c3, grid, s->depth_buffer);
+/*
+ * Phong shades the part of a triangle with the given corners and normals at
+ * them that lies inside bounds.
+ */
+static void phong_triangle(vertex *a_ndc, vertex *b_ndc, vertex *c_ndc,
+        const Vector3f& norm_a, const Vector3f& norm_b, const Vector3f& norm_c,
+        const surface_material& material, scene *s, framebuffer& fb,
+        const tile& bounds) {
+    Vector3f world_a = a_ndc->get_world_vec();
+    Vector3f world_b = b_ndc->get_world_vec();
+    Vector3f world_c = c_ndc->get_world_vec();
+
+    // The fragment is reused for every pixel so nothing is allocated in the
+    // pixel loop
+    fragment frag;
+    raster_triangle(a_ndc, b_ndc, c_ndc, fb, bounds,
+            [&](int x, int y, float alpha, float beta, float gamma) {
+        // World/normal interpolation
+        frag.position = alpha * world_a + beta * world_b + gamma * world_c;
+        frag.normal = alpha * norm_a + beta * norm_b + gamma * norm_c;
+        fb.set_color(x, y, lighting(frag, material, s));
+    });
 }
 
 /*
  * This is the Phong shading algorithm. The idea is that for each face/triangle
- * of our object, we interpolate the world coordinates and normals of the vertices
- * across the triangle. Then, during the rasterization process, for each pixel
- * we rasterize, we call the lighting model with the world coordinates and normal
- * corresponding to the pixel and rasterize the pixel with the resulting color.
+ * of our object, we interpolate the world coordinates and normals of the
+ * vertices across the triangle. Then, during the rasterization process, for
+ * each pixel we rasterize, we call the lighting model with the world
+ * coordinates and normal corresponding to the pixel and rasterize the pixel
+ * with the resulting color. Only the part of the face inside bounds is drawn.
  */
-void phong_shading(face *f, object *o, scene *s, MatrixColor& grid,
-        MatrixXd& depth_buffer) {
-    int xres = grid.cols();
-    int yres = grid.rows();
+void phong_shading(face *f, object *o, scene *s, framebuffer& fb,
+        const tile& bounds) {
+    phong_triangle(&o->ndc_vertices[f->v1], &o->ndc_vertices[f->v2],
+            &o->ndc_vertices[f->v3], o->world_normals[f->vn1].get_vec(),
+            o->world_normals[f->vn2].get_vec(),
+            o->world_normals[f->vn3].get_vec(),
+            o->material, s, fb, bounds);
+}
 
-    vertex *a = o->vertices[f->v1];
-    vertex *b = o->vertices[f->v2];
-    vertex *c = o->vertices[f->v3];
+/*
+ * Interpolates a value given at each corner of a face at the barycentric
+ * coordinates within the face of a corner of one of its pieces.
+ */
+template <typename T>
+static T interpolate(const clipped_corner& corner, const T& a, const T& b,
+        const T& c) {
+    return corner.weights[0] * a + corner.weights[1] * b
+        + corner.weights[2] * c;
+}
 
-    surface_normal *na = o->normals[f->vn1];
-    surface_normal *nb = o->normals[f->vn2];
-    surface_normal *nc = o->normals[f->vn3];
+/*
+ * Sets up the corners of a piece of a clipped face as vertices, with their
+ * world coordinates interpolated from the face's, and their normals.
+ */
+static void piece_corners(face *f, object *o, const face_piece& piece,
+        vertex corners[3], Vector3f normals[3]) {
+    Vector3f world_a = o->ndc_vertices[f->v1].get_world_vec();
+    Vector3f world_b = o->ndc_vertices[f->v2].get_world_vec();
+    Vector3f world_c = o->ndc_vertices[f->v3].get_world_vec();
+    Vector3f norm_a = o->world_normals[f->vn1].get_vec();
+    Vector3f norm_b = o->world_normals[f->vn2].get_vec();
+    Vector3f norm_c = o->world_normals[f->vn3].get_vec();
+    for (int i = 0; i < 3; i++) {
+        const clipped_corner& corner = piece.corners[i];
+        vertex& v = corners[i];
+        v.x = corner.x;
+        v.y = corner.y;
+        v.z = corner.z;
+        v.screen_x = corner.screen_x;
+        v.screen_y = corner.screen_y;
+        Vector3f world = interpolate(corner, world_a, world_b, world_c);
+        v.world_x = world(0);
+        v.world_y = world(1);
+        v.world_z = world(2);
+        normals[i] = interpolate(corner, norm_a, norm_b, norm_c);
+    }
+}
 
-    vertex *a_ndc = world_to_ndc(a, s);
-    vertex *b_ndc = world_to_ndc(b, s);
-    vertex *c_ndc = world_to_ndc(c, s);
+/*
+ * Phong shades the part of a piece of a clipped face that lies inside bounds.
+ */
+void phong_shading(face *f, object *o, const face_piece& piece, scene *s,
+        framebuffer& fb, const tile& bounds) {
+    vertex corners[3];
+    Vector3f normals[3];
+    piece_corners(f, o, piece, corners, normals);
+    phong_triangle(&corners[0], &corners[1], &corners[2], normals[0],
+            normals[1], normals[2], o->material, s, fb, bounds);
+}
 
-    // Get NDC coords as eigen vectors
-    Vector3f ndc_a = a_ndc->get_vec();
-    Vector3f ndc_b = b_ndc->get_vec();
-    Vector3f ndc_c = c_ndc->get_vec();
+/*
+ * Stores the part of a triangle with the given corners and normals at them
+ * that lies inside bounds in the G-buffer.
+ */
+static void deferred_phong_triangle(vertex *a_ndc, vertex *b_ndc,
+        vertex *c_ndc, const Vector3f& norm_a, const Vector3f& norm_b,
+        const Vector3f& norm_c, int object_index, gbuffer& gbuf,
+        framebuffer& fb, const tile& bounds) {
+    Vector3f world_a = a_ndc->get_world_vec();
+    Vector3f world_b = b_ndc->get_world_vec();
+    Vector3f world_c = c_ndc->get_world_vec();
+
+    raster_triangle(a_ndc, b_ndc, c_ndc, fb, bounds,
+            [&](int x, int y, float alpha, float beta, float gamma) {
+        int i = gbuf.index(x, y);
+        fragment& frag = gbuf.fragments[i];
+        frag.position = alpha * world_a + beta * world_b + gamma * world_c;
+        frag.normal = alpha * norm_a + beta * norm_b + gamma * norm_c;
+        gbuf.object_indices[i] = object_index;
+    });
+}
 
-    // Perform backface culling, ignoring faces facing away from the camera
-    Vector3f cross = (ndc_c - ndc_b).cross(ndc_a - ndc_b);
-    if (cross(2, 0) < 0)
-        return;
+/*
+ * This is the first pass of deferred Phong shading. Rather than calling the
+ * lighting model for every pixel that passes the depth test, we only store the
+ * interpolated world coordinates and normal of the part of the face inside
+ * bounds in a G-buffer, along with the index of the face's object, which
+ * gives its material. Once every face has been drawn the G-buffer holds
+ * exactly the visible points, and deferred_lighting lights each of them once.
+ */
+void deferred_phong_shading(face *f, object *o, int object_index,
+        gbuffer& gbuf, framebuffer& fb, const tile& bounds) {
+    deferred_phong_triangle(&o->ndc_vertices[f->v1], &o->ndc_vertices[f->v2],
+            &o->ndc_vertices[f->v3], o->world_normals[f->vn1].get_vec(),
+            o->world_normals[f->vn2].get_vec(),
+            o->world_normals[f->vn3].get_vec(),
+            object_index, gbuf, fb, bounds);
+}
 
-    // Get the screen coords
-    map_to_screen_coords(a_ndc, xres, yres);
-    map_to_screen_coords(b_ndc, xres, yres);
-    map_to_screen_coords(c_ndc, xres, yres);
-    int x_a = a_ndc->screen_x;
-    int y_a = a_ndc->screen_y;
-    int x_b = b_ndc->screen_x;
-    int y_b = b_ndc->screen_y;
-    int x_c = c_ndc->screen_x;
-    int y_c = c_ndc->screen_y;
-
-    int x_min = min({x_a, x_b, x_c});
-    int x_max = max({x_a, x_b, x_c});
-    int y_min = min({y_a, y_b, y_c});
-    int y_max = max({y_a, y_b, y_c});
-
-    for (int x = x_min; x <= x_max; x++) {
-        for (int y = y_min; y <= y_max; y++) {
-            float alpha = compute_alpha(x_a, y_a, x_b, y_b, x_c, y_c, x, y);
-            float beta = compute_beta(x_a, y_a, x_b, y_b, x_c, y_c, x, y);
-            float gamma = compute_gamma(x_a, y_a, x_b, y_b, x_c, y_c, x, y);
-
-            // Check to make sure the point is inside the triangle
-            if ((alpha >= 0 && alpha <= 1) && (beta >= 0 && beta <= 1)
-                    && (gamma >= 0 && gamma <= 1)) {
-                Vector3f ndc = (alpha * ndc_a) + (beta * ndc_b) + (gamma * ndc_c);
-                // Check to see if NDC coords are in cube
-                bool in_cube = abs(ndc(0, 0)) <= 1 && abs(ndc(1, 0)) <= 1
-                    && abs(ndc(2, 0)) <= 1;
-
-                // Perform depth buffering, so we don't render points behind
-                // other points
-                if (in_cube && ndc(2, 0) <= depth_buffer(y, x)) {
-                    depth_buffer(y, x) = ndc(2, 0);
-                    // World/normal interpolation
-                    Vector3f vert = alpha * a_ndc->get_world_vec()
-                        + beta * b_ndc->get_world_vec()
-                        + gamma * c_ndc->get_world_vec();
-                    Vector3f norm = alpha * na->get_vec() + beta * nb->get_vec()
-                        + gamma * nc->get_vec();
-                    vertex *v = new vertex(vert(0,0), vert(1,0), vert(2,0));
-                    surface_normal *n = new surface_normal(norm(0,0),
-                            norm(1,0), norm(2,0));
-                    color c = lighting(v, n, o->material, s);
-                    // IMPORTANT: adjust y coordinate
-                    grid(yres - 1 - y, x) = c;
-                }
-            }
+/*
+ * Stores the part of a piece of a clipped face inside bounds in the G-buffer.
+ */
+void deferred_phong_shading(face *f, object *o, const face_piece& piece,
+        int object_index, gbuffer& gbuf, framebuffer& fb, const tile& bounds) {
+    vertex corners[3];
+    Vector3f normals[3];
+    piece_corners(f, o, piece, corners, normals);
+    deferred_phong_triangle(&corners[0], &corners[1], &corners[2], normals[0],
+            normals[1], normals[2], object_index, gbuf, fb, bounds);
+}
+
+/*
+ * This is the second pass of deferred Phong shading. It lights every point
+ * the G-buffer holds inside bounds, using the material of the object with the
+ * stored index, and writes the results to the framebuffer. The points are
+ * gathered into batches for the lighting kernel, which computes the same
+ * lighting model as lighting() for a whole batch at once.
+ */
+void deferred_lighting(const gbuffer& gbuf, scene *s, const light_array& lights,
+        light_precision precision, framebuffer& fb, const tile& bounds) {
+    Vector3f cam_pos = s->position.get_vec();
+    fragment_batch batch;
+    light_sums sums;
+    // The G-buffer index of each fragment in the batch
+    int pixels[light_batch_size];
+
+    // Applies the materials to a full batch and writes it out
+    auto flush = [&]() {
+        light_batch(batch, lights, cam_pos, precision, sums);
+        for (int j = 0; j < batch.count; j++) {
+            int i = pixels[j];
+            const surface_material& m =
+                    s->objects[gbuf.object_indices[i]]->material;
+            float r = m.ambient.r + sums.diffuse_r[j] * m.diffuse.r
+                + sums.specular_r[j] * m.specular.r;
+            float g = m.ambient.g + sums.diffuse_g[j] * m.diffuse.g
+                + sums.specular_g[j] * m.specular.g;
+            float b = m.ambient.b + sums.diffuse_b[j] * m.diffuse.b
+                + sums.specular_b[j] * m.specular.b;
+            fb.set_color(i % gbuf.xres, i / gbuf.xres + gbuf.y_min,
+                    color(min(1.0f, r), min(1.0f, g), min(1.0f, b)));
+        }
+        batch.count = 0;
+    };
+
+    for (int y = bounds.y_min; y <= bounds.y_max; y++) {
+        for (int x = bounds.x_min; x <= bounds.x_max; x++) {
+            int i = gbuf.index(x, y);
+            int object_index = gbuf.object_indices[i];
+            if (object_index == no_object)
+                continue;
+            const fragment& frag = gbuf.fragments[i];
+            int j = batch.count++;
+            pixels[j] = i;
+            batch.x[j] = frag.position(0);
+            batch.y[j] = frag.position(1);
+            batch.z[j] = frag.position(2);
+            batch.normal_x[j] = frag.normal(0);
+            batch.normal_y[j] = frag.normal(1);
+            batch.normal_z[j] = frag.normal(2);
+            batch.shininess[j] = s->objects[object_index]->material.shininess;
+            if (batch.count == light_batch_size)
+                flush();
         }
     }
+    if (batch.count > 0)
+        flush();
 }
 
 /*
  * This is the algorithm for the lighting model, which computes the color
- * of a point v on an illuminated surface. It takes in:
- * v: The position of the point v as a triple of (x, y, z) coordinates.
- * n: The surface normal as a triple of (x, y, z) coordinates.
+ * of a point on an illuminated surface. It takes in:
+ * frag: The position of the point and the surface normal there.
  * m: The material reflectance and shininess properties.
  * s: The scene, which contains the list of light sources and the camera
  *    position.
  *
- * Note that in this function, we convert our structs (vertex, color,
- * surface_normal) to Eigen Vectors to make the vector math easier to perform.
+ * Note that in this function, we convert our structs (vertex, color) to Eigen
+ * Vectors to make the vector math easier to perform. Everything is passed by
+ * reference and lives on the stack, since this runs once per pixel for Phong
+ * shading.
  */
-color lighting(vertex *v, surface_normal *n, surface_material m, scene *s) {
-    Vector3f col_diff = m.diffuse.get_vec();
-    Vector3f col_amb = m.ambient.get_vec();
-    Vector3f col_spec = m.specular.get_vec();
+color lighting(const fragment& frag, const surface_material& m, scene *s) {
+    Vector3f col_diff(m.diffuse.r, m.diffuse.g, m.diffuse.b);
+    Vector3f col_amb(m.ambient.r, m.ambient.g, m.ambient.b);
+    Vector3f col_spec(m.specular.r, m.specular.g, m.specular.b);
     float shine = m.shininess;
 
     Vector3f diff_sum(3, 1);
@@ -139,12 +421,12 @@ color lighting(vertex *v, surface_normal *n, surface_material m, scene *s) {
     Vector3f spec_sum(3, 1);
     spec_sum << 0, 0, 0;
 
-    Vector3f point_pos = v->get_vec();
+    const Vector3f& point_pos = frag.position;
     Vector3f cam_pos = s->position.get_vec();
     Vector3f cam_dir = cam_pos - point_pos;
     cam_dir.normalize();
 
-    Vector3f normal_vec = n->get_vec();
+    const Vector3f& normal_vec = frag.normal;
 
     float zero = 0;
     for (light *l : s->lights) {
@@ -181,160 +463,45 @@ color lighting(vertex *v, surface_normal *n, surface_material m, scene *s) {
 
 /*
  * This is the algorithm for rasterizing colored triangles with interpolation
- * via barycentric coordinates, backface culling, and depth buffering.
+ * via barycentric coordinates, backface culling, and depth buffering, over the
+ * part of the triangle that lies inside bounds.
  * It takes in:
- * a: The first point of a face (NDC coordinates).
- * b: The second point of a face (NDC coordinates).
- * c: The third point of a face (NDC coordinates).
- * grid: The grid to fill with colors.
+ * a: The first point of a face (NDC coordinates, mapped to the screen).
+ * b: The second point of a face (NDC coordinates, mapped to the screen).
+ * c: The third point of a face (NDC coordinates, mapped to the screen).
+ * fb: The framebuffer to draw into.
  */
 void raster_colored_triangle(vertex *a, vertex *b, vertex *c, color& c_a,
-        color& c_b, color& c_c, MatrixColor& grid, MatrixXd& depth_buffer) {
-    int xres = grid.cols();
-    int yres = grid.rows();
-
-    // Get NDC coords as eigen vectors
-    Vector3f ndc_a = a->get_vec();
-    Vector3f ndc_b = b->get_vec();
-    Vector3f ndc_c = c->get_vec();
-
-    // Perform backface culling, ignoring faces facing away from the camera
-    Vector3f cross = (ndc_c - ndc_b).cross(ndc_a - ndc_b);
-    if (cross(2, 0) < 0)
-        return;
-
-    // Get the screen coords
-    map_to_screen_coords(a, xres, yres);
-    map_to_screen_coords(b, xres, yres);
-    map_to_screen_coords(c, xres, yres);
-    int x_a = a->screen_x;
-    int y_a = a->screen_y;
-    int x_b = b->screen_x;
-    int y_b = b->screen_y;
-    int x_c = c->screen_x;
-    int y_c = c->screen_y;
-
-    int x_min = min({x_a, x_b, x_c});
-    int x_max = max({x_a, x_b, x_c});
-    int y_min = min({y_a, y_b, y_c});
-    int y_max = max({y_a, y_b, y_c});
-
-    for (int x = x_min; x <= x_max; x++) {
-        for (int y = y_min; y <= y_max; y++) {
-            float alpha = compute_alpha(x_a, y_a, x_b, y_b, x_c, y_c, x, y);
-            float beta = compute_beta(x_a, y_a, x_b, y_b, x_c, y_c, x, y);
-            float gamma = compute_gamma(x_a, y_a, x_b, y_b, x_c, y_c, x, y);
-
-            // Check to make sure the point is inside the triangle
-            if ((alpha >= 0 && alpha <= 1) && (beta >= 0 && beta <= 1)
-                    && (gamma >= 0 && gamma <= 1)) {
-                Vector3f ndc = (alpha * ndc_a) + (beta * ndc_b) + (gamma * ndc_c);
-                // Check to see if NDC coords are in cube
-                bool in_cube = abs(ndc(0, 0)) <= 1 && abs(ndc(1, 0)) <= 1
-                    && abs(ndc(2, 0)) <= 1;
-                cout.flush();
-                if (in_cube && ndc(2, 0) <= depth_buffer(y, x)) {
-                    depth_buffer(y, x) = ndc(2, 0);
-                    // Color interpolation
-                    float r = alpha * c_a.r + beta * c_b.r + gamma * c_c.r;
-                    float g = alpha * c_a.g + beta * c_b.g + gamma * c_c.g;
-                    float b = alpha * c_a.b + beta * c_b.b + gamma * c_c.b;
-                    color c(r, g, b);
-                    // IMPORTANT: adjust y coordinate
-                    grid(yres - 1 - y, x) = c;
-                }
-            }
-        }
-    }
-}
-
-/*
- * Calculates alpha, which is used to compute barycentric coordinates.
- */
-float compute_alpha(int x_a, int y_a, int x_b, int y_b, int x_c, int y_c,
-        int x, int y) {
-    float numerator = f(x, y, x_b, y_b, x_c, y_c);
-    float denom = f(x_a, y_a, x_b, y_b, x_c, y_c);
-    return numerator / denom;
-}
-
-/*
- * Calculates beta, which is used to compute barycentric coordinates.
- */
-float compute_beta(int x_a, int y_a, int x_b, int y_b, int x_c, int y_c,
-        int x, int y) {
-    float numerator = f(x, y, x_a, y_a, x_c, y_c);
-    float denom = f(x_b, y_b, x_a, y_a, x_c, y_c);
-    return numerator / denom;
+        color& c_b, color& c_c, framebuffer& fb, const tile& bounds) {
+    raster_triangle(a, b, c, fb, bounds,
+            [&](int x, int y, float alpha, float beta, float gamma) {
+        // Color interpolation
+        float r = alpha * c_a.r + beta * c_b.r + gamma * c_c.r;
+        float g = alpha * c_a.g + beta * c_b.g + gamma * c_c.g;
+        float b = alpha * c_a.b + beta * c_b.b + gamma * c_c.b;
+        fb.set_color(x, y, color(r, g, b));
+    });
 }
 
 /*
- * Calculates gamma, which is used to compute barycentric coordinates.
+ * Rasterizes the part of a piece of a clipped face inside bounds, with the
+ * colors Gouraud shading found for the face's corners.
  */
-float compute_gamma(int x_a, int y_a, int x_b, int y_b, int x_c, int y_c,
-        int x, int y) {
-    float numerator = f(x, y, x_a, y_a, x_b, y_b);
-    float denom = f(x_c, y_c, x_a, y_a, x_b, y_b);
-    return numerator / denom;
-}
-
-/*
- * This is the helper function used to compute alpha, beta, and gamma.
- * Given that this is expressed, as f_{ij}(x, y) in the notes, we have
- * that the parameters are as follows:
- * x: This corresponds to x in the notes.
- * y: This corresponds to y in the notes.
- * x_i: This corresponds to x_i in the notes.
- * y_i: This corresponds to y_i in the notes.
- * x_j: This corresponds to x_j in the notes.
- * y_j: This corresponds to y_j in the notes.
- */
-float f(int x, int y, int x_i, int y_i, int x_j, int y_j) {
-    float val = (y_i - y_j) * x + (x_j - x_i) * y + x_i * y_j - x_j * y_i;
-    return val;
-}
-
-/*
- * Creates a ppm struct with the given resolution, based on the passed-in
- * grid.
- */
-ppm create_ppm(int xres, int yres, MatrixColor grid) {
-    vector<string> lines;
-    string header("P3");
-    lines.push_back(header);
-
-    ostringstream res_string_stream;
-    res_string_stream << xres << " " << yres;
-    string res_line = res_string_stream.str();
-    lines.push_back(res_line);
-
-    string intensity("255");
-    lines.push_back(intensity);
-
-    for (int y = 0; y < yres; y++) {
-        for (int x = 0; x < xres; x++) {
-            color c = grid(y, x);
-            lines.push_back(get_line(c));
-        }
+void raster_colored_piece(const face_piece& piece, const color face_colors[3],
+        framebuffer& fb, const tile& bounds) {
+    vertex corners[3];
+    color colors[3];
+    for (int i = 0; i < 3; i++) {
+        const clipped_corner& corner = piece.corners[i];
+        corners[i].x = corner.x;
+        corners[i].y = corner.y;
+        corners[i].z = corner.z;
+        corners[i].screen_x = corner.screen_x;
+        corners[i].screen_y = corner.screen_y;
+        Vector3f c = interpolate(corner, face_colors[0].get_vec(),
+                face_colors[1].get_vec(), face_colors[2].get_vec());
+        colors[i] = color(c(0), c(1), c(2));
     }
-
-    ppm p(xres, yres);
-    p.lines = lines;
-    return p;
-}
-
-/*
- * Returns a string representing a ppm line corresponding to the passed-in
- * color.
- */
-string get_line(color c) {
-    ostringstream color_string_stream;
-    // IMPORTANT: ppm values must be ints, and must be adjusted to values
-    // relative to 255
-    int red = (int) (c.r * 255);
-    int green = (int) (c.g * 255);
-    int blue = (int) (c.b * 255);
-    color_string_stream << red << " " << green << " " << blue;
-    string color_string = color_string_stream.str();
-    return color_string;
+    raster_colored_triangle(&corners[0], &corners[1], &corners[2], colors[0],
+            colors[1], colors[2], fb, bounds);
 }
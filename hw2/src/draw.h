@@ -2,36 +2,75 @@
 #define DRAW_H
 
 #include "framework.h"
+#include "lights.h"
+#include "clipper.h"
+#include "framebuffer.h"
 
 using namespace std;
 
-struct ppm {
-    vector<string> lines;
+// A point on a surface being lit: its world coordinates and the surface
+// normal interpolated there
+struct fragment {
+    Vector3f position;
+    Vector3f normal;
+    fragment() {}
+    fragment(const Vector3f& position, const Vector3f& normal) :
+            position(position), normal(normal) {}
+};
+
+// Marks the pixels of a G-buffer that no face covers
+static const int no_object = -1;
+
+// The geometry buffer deferred shading rasterizes into. For every pixel it
+// holds the fragment visible there and the index of the object whose material
+// it has. Like a framebuffer, it can hold just the rows of the screen from
+// y_min up
+struct gbuffer {
     int xres;
     int yres;
-    ppm(int x, int y) : xres(x), yres(y) {}
+    int y_min;
+    vector<fragment> fragments;
+    vector<int> object_indices;
+    gbuffer(int xres, int yres, int y_min = 0) : xres(xres), yres(yres),
+            y_min(y_min), fragments((size_t) xres * yres),
+            object_indices((size_t) xres * yres, no_object) {}
+    // Where the pixel (x, y), in screen coordinates, is stored
+    int index(int x, int y) const {
+        return (y - y_min) * xres + x;
+    }
+};
+
+// An inclusive rectangle of pixels on the screen
+struct tile {
+    int x_min;
+    int y_min;
+    int x_max;
+    int y_max;
+    tile() {}
+    tile(int x_min, int y_min, int x_max, int y_max) : x_min(x_min),
+            y_min(y_min), x_max(x_max), y_max(y_max) {}
 };
 
 /*******************************************************************************
  * Defines methods needed for drawing stuff
  ******************************************************************************/
 
-ppm create_ppm(int xres, int yres, MatrixColor grid);
-string get_line(color c);
-
-void gouraud_shading(face *f, object *o, scene *s, MatrixColor& grid);
-void phong_shading(face *f, object *o, scene *s, MatrixColor& grid,
-        MatrixXd& depth_buffer);
-color lighting(vertex *v, surface_normal *n, surface_material m, scene *s);
+bool face_screen_bounds(face *f, object *o, int xres, int yres, tile& bounds);
+void phong_shading(face *f, object *o, scene *s, framebuffer& fb,
+        const tile& bounds);
+void phong_shading(face *f, object *o, const face_piece& piece, scene *s,
+        framebuffer& fb, const tile& bounds);
+void deferred_phong_shading(face *f, object *o, int object_index,
+        gbuffer& gbuf, framebuffer& fb, const tile& bounds);
+void deferred_phong_shading(face *f, object *o, const face_piece& piece,
+        int object_index, gbuffer& gbuf, framebuffer& fb, const tile& bounds);
+void deferred_lighting(const gbuffer& gbuf, scene *s, const light_array& lights,
+        light_precision precision, framebuffer& fb, const tile& bounds);
+color lighting(const fragment& frag, const surface_material& m, scene *s);
 void raster_colored_triangle(vertex *a, vertex *b, vertex *c,
-        color &c_a, color &c_b, color &c_c, MatrixColor& grid,
-        MatrixXd &depth_buffer);
-float compute_alpha(int x_a, int y_a, int x_b, int y_b, int x_c, int y_c,
-        int x, int y);
-float compute_beta(int x_a, int y_a, int x_b, int y_b, int x_c, int y_c,
-        int x, int y);
-float compute_gamma(int x_a, int y_a, int x_b, int y_b, int x_c, int y_c,
-        int x, int y);
-float f(int x, int y, int x_i, int y_i, int x_j, int y_j);
+        color &c_a, color &c_b, color &c_c, framebuffer& fb,
+        const tile& bounds);
+void raster_colored_piece(const face_piece& piece, const color face_colors[3],
+        framebuffer& fb, const tile& bounds);
 
 #endif
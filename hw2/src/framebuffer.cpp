@@ -0,0 +1,44 @@
+#include "framebuffer.h"
+#include <algorithm>
+#include <cfloat>
+
+using namespace std;
+
+/*
+ * Makes a framebuffer of the given resolution, holding the rows of the screen
+ * from y_min up, cleared to black and to the farthest possible depth.
+ */
+framebuffer::framebuffer(int xres, int yres, int y_min) : xres(xres),
+        yres(yres), y_min(y_min),
+        blocks_x((xres + framebuffer_block_size - 1) / framebuffer_block_size) {
+    clear();
+}
+
+void framebuffer::clear() {
+    int blocks_y = (yres + framebuffer_block_size - 1) / framebuffer_block_size;
+    size_t size = (size_t) blocks_x * blocks_y * framebuffer_block_size
+        * framebuffer_block_size;
+    colors.assign(size, 0);
+    depths.assign(size, FLT_MAX);
+}
+
+/*
+ * Unpacks the colors into rgb as rows of 8 bit RGB triples, starting from the
+ * top row of the image.
+ */
+void framebuffer::resolve(vector<unsigned char>& rgb) const {
+    rgb.resize((size_t) xres * yres * 3);
+    unsigned char *out = rgb.data();
+    for (int y = y_min + yres - 1; y >= y_min; y--) {
+        // Each block contributes a contiguous run of the row
+        for (int x0 = 0; x0 < xres; x0 += framebuffer_block_size) {
+            const packed_color *in = &colors[index(x0, y)];
+            int run = min(framebuffer_block_size, xres - x0);
+            for (int i = 0; i < run; i++) {
+                *out++ = in[i] >> 16;
+                *out++ = (in[i] >> 8) & 0xff;
+                *out++ = in[i] & 0xff;
+            }
+        }
+    }
+}
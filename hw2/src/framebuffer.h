@@ -0,0 +1,79 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include "framework.h"
+#include <stdint.h>
+
+using namespace std;
+
+// Side length of the square blocks of pixels the framebuffer stores one after
+// another. It matches the rasterizer's blocks, so each row of pixels the
+// rasterizer visits in a block is contiguous in memory
+static const int framebuffer_block_size = 8;
+
+// A color with 8 bits per channel, as 0x00RRGGBB
+typedef uint32_t packed_color;
+
+/*******************************************************************************
+ * Defines the framebuffer faces are drawn into. Pixels are addressed with y
+ * going up from the bottom row, like screen coordinates, and stored block by
+ * block rather than row by row or column by column, so drawing a face stays
+ * within a few cache lines at a time. Colors are packed into 32 bits and
+ * depths are floats, so each pixel only takes 8 bytes. resolve() unpacks the
+ * colors into plain rows for output.
+ *
+ * A framebuffer can hold just a band of the screen's rows, so that a large
+ * image can be drawn a band at a time. Pixels are still addressed with their
+ * screen coordinates, so drawing into a band is no different from drawing
+ * into the whole screen, as long as nothing outside the band is drawn.
+ ******************************************************************************/
+
+struct framebuffer {
+    int xres;
+    // The number of rows held, starting from row y_min of the screen
+    int yres;
+    int y_min;
+    // The number of blocks across. The buffers are padded out to whole blocks
+    int blocks_x;
+    vector<packed_color> colors;
+    vector<float> depths;
+
+    framebuffer(int xres, int yres, int y_min = 0);
+
+    // Clears every pixel to black and to the farthest possible depth
+    void clear();
+
+    // Where the pixel (x, y) is stored
+    int index(int x, int y) const {
+        y -= y_min;
+        int block = (y / framebuffer_block_size) * blocks_x
+            + x / framebuffer_block_size;
+        return (block * framebuffer_block_size + y % framebuffer_block_size)
+            * framebuffer_block_size + x % framebuffer_block_size;
+    }
+    float& depth(int x, int y) {
+        return depths[index(x, y)];
+    }
+    void set_color(int x, int y, const color& c);
+    void resolve(vector<unsigned char>& rgb) const;
+};
+
+/*
+ * Scales a color channel in [0, 1] to [0, 255], rounding down the same way
+ * the PPM output always has.
+ */
+inline packed_color pack_channel(float value) {
+    int scaled = (int) (value * 255);
+    return (scaled < 0) ? 0 : ((scaled > 255) ? 255 : scaled);
+}
+
+inline packed_color pack_color(const color& c) {
+    return (pack_channel(c.r) << 16) | (pack_channel(c.g) << 8)
+        | pack_channel(c.b);
+}
+
+inline void framebuffer::set_color(int x, int y, const color& c) {
+    colors[index(x, y)] = pack_color(c);
+}
+
+#endif
@@ -29,13 +29,13 @@ void output_object_normals(vector<object *> objects) {
 }
 
 /*
- * Prints out all the surface normals of an object.
+ * Prints out all the transformed surface normals of an object.
  */
 void output_object_normals(object *o) {
-    for (surface_normal *n : o->normals) {
-        if (n != NULL) {
-            cout << "vn " << n->x << " " << n->y << " " << n->z << endl;
-        }
+    // The 0 index isn't a normal
+    for (size_t i = 1; i < o->world_normals.size(); i++) {
+        const surface_normal& n = o->world_normals[i];
+        cout << "vn " << n.x << " " << n.y << " " << n.z << endl;
     }
 }
 
@@ -48,14 +48,15 @@ void output_object_vertices(vector<object *> objects) {
 }
 
 /*
- * Prints out all the vertices of an object.
+ * Prints out the world coordinates of all the vertices of an object, and where
+ * they are on the screen.
  */
 void output_object_vertices(object *o) {
-    for (vertex *v : o->vertices) {
-        if (v != NULL) {
-            cout << "v " << v->x << " " << v->y << " " << v->z <<
-                " " << v->screen_x << " " << v->screen_y << endl;
-        }
+    // The 0 index isn't a vertex
+    for (size_t i = 1; i < o->ndc_vertices.size(); i++) {
+        const vertex& v = o->ndc_vertices[i];
+        cout << "v " << v.world_x << " " << v.world_y << " " << v.world_z <<
+            " " << v.screen_x << " " << v.screen_y << endl;
     }
 }
 
@@ -71,11 +72,10 @@ void output_object_faces(vector<object *> objects) {
  * Prints out all the faces of an object.
  */
 void output_object_faces(object *o) {
-    for (face *f : o->faces) {
-        if (f != NULL) {
-            cout << "f " << f->v1 << "//" << f->vn1 << " "
-                << f->v2 << "//" << f->vn2 << " "
-                << f->v3 << "//" << f->vn3 << endl;
-        }
+    for (int i = 0; i < o->geometry->face_count(); i++) {
+        face f(*o->geometry, i);
+        cout << "f " << f.v1 << "//" << f.vn1 << " "
+            << f.v2 << "//" << f.vn2 << " "
+            << f.v3 << "//" << f.vn3 << endl;
     }
 }
@@ -6,6 +6,8 @@
 #include <string>
 #include <iostream>
 #include <Eigen/Dense>
+#include "mesh.h"
+#include "transform.h"
 
 using namespace Eigen;
 using namespace std;
@@ -21,7 +23,7 @@ struct color {
     float b;
     color() {}
     color(float r, float g, float b) : r(r), g(g), b(b) {}
-    Vector3f get_vec() {
+    Vector3f get_vec() const {
         Vector3f vec(r, g, b);
         return vec;
     }
@@ -47,7 +49,7 @@ struct vertex {
     int screen_y = -1;
     vertex() {}
     vertex(float x, float y, float z) : x(x), y(y), z(z) {}
-    vertex(vertex& other) : x(other.x), y(other.y), z(other.z) {}
+    vertex(const vertex& other) : x(other.x), y(other.y), z(other.z) {}
     Vector3f get_vec() {
         Vector3f vec(x, y, z);
         return vec;
@@ -65,7 +67,8 @@ struct surface_normal {
     float z;
     surface_normal() {}
     surface_normal(float x, float y, float z) : x(x), y(y), z(z) {}
-    surface_normal(surface_normal& other) : x(other.x), y(other.y), z(other.z) {}
+    surface_normal(const surface_normal& other) : x(other.x), y(other.y),
+            z(other.z) {}
     Vector3f get_vec() {
         Vector3f vec(x, y, z);
         return vec;
@@ -75,8 +78,9 @@ struct surface_normal {
 // Face struct contains the numbers of the vertices the face is composed of
 // (1-indexed), as well as the numbers of the surfaces normals for those
 // vertices. So, for example vertex #v1 has the vn1-th surface normal.
-// In other words, these numbers index into the vectors that are stored
-// in the object struct.
+// In other words, these numbers index into the arrays that are stored
+// in the mesh. Faces are copied out of the index triplets of a mesh when
+// they're drawn.
 struct face {
     int v1;
     int v2;
@@ -84,13 +88,21 @@ struct face {
     int vn1;
     int vn2;
     int vn3;
-    color c1;
-    color c2;
-    color c3;
     face() {}
     face(int v1, int v2, int v3, int vn1, int vn2, int vn3) :
             v1(v1), v2(v2), v3(v3), vn1(vn1), vn2(vn2), vn3(vn3) {}
-    face(face& other) : v1(other.v1), v2(other.v2), v3(other.v3),
+    // The i-th face of a mesh
+    face(const tri_mesh& m, int i) {
+        const index_triplet& v = m.position_indices[i];
+        const index_triplet& vn = m.normal_indices[i];
+        v1 = v[0];
+        v2 = v[1];
+        v3 = v[2];
+        vn1 = vn[0];
+        vn2 = vn[1];
+        vn3 = vn[2];
+    }
+    face(const face& other) : v1(other.v1), v2(other.v2), v3(other.v3),
             vn1(other.vn1), vn2(other.vn2), vn3(other.vn3) {}
 };
 
@@ -123,64 +135,48 @@ struct light {
             attenuation(other.attenuation) {}
 };
 
-// Objects contain a list of vertices (1-indexed),
-// list of surface normals (also 1-indexed), and faces
+// A vertex in homogeneous clip space, before the perspective divide
+struct clip_vertex {
+    double x;
+    double y;
+    double z;
+    double w;
+    clip_vertex() {}
+    clip_vertex(double x, double y, double z, double w) : x(x), y(y), z(z),
+            w(w) {}
+};
+
+// Where an object's bounding sphere lies relative to the view frustum
+enum frustum_test {
+    outside_frustum,
+    crosses_frustum,
+    inside_frustum
+};
+
+// Objects are instances of a mesh (see mesh.h), each with its own
+// transformations and material. Everything transformed from the mesh is kept
+// in the object's own buffers, which are refilled every frame, so a scene only
+// holds one copy of each mesh however many objects are made from it
 struct object {
-    vector<vertex *> vertices;
-    vector<surface_normal *> normals;
-    vector<face *> faces;
-    vector<MatrixXd> transformations;
-    vector<MatrixXd> normal_transformations;
+    const tri_mesh *geometry;
+    // The vertices transformed to NDC and screen space (also 1-indexed), with
+    // their world coordinates saved. transform_object_geom fills in the world
+    // coordinates, and transform_object_to_ndc the rest
+    vector<vertex> ndc_vertices;
+    // The normals transformed to world space (also 1-indexed). Filled by
+    // transform_object_normals
+    vector<surface_normal> world_normals;
+    // The vertices in clip space (also 1-indexed). Only filled for objects
+    // that cross the edge of the view frustum, whose faces may need clipping
+    vector<clip_vertex> clip_vertices;
+    // Set by transform_object_to_ndc. Objects outside the frustum aren't
+    // drawn, and only have the world coordinates of their ndc_vertices
+    frustum_test visibility;
+    transform_chain<double> transformations;
     surface_material material;
     string label;
-    object() {}
-    object(vector<vertex *> vertices, vector<surface_normal *> normals,
-            vector<face *> faces) : vertices(vertices), normals(normals),
-            faces(faces) {}
-    object(object& other) {
-        vector<vertex *> new_vertices;
-        for (vertex *v : other.vertices) {
-            vertex *v2 = NULL;
-            if (v != NULL) // 0 index is null
-                 v2 = new vertex(*v);
-            new_vertices.push_back(v2);
-        }
-        vertices = new_vertices;
-
-        vector<surface_normal *> new_normals;
-        for (surface_normal *n : other.normals) {
-            surface_normal *n2 = NULL;
-            if (n != NULL) // 0 index is null
-                 n2 = new surface_normal(*n);
-            new_normals.push_back(n2);
-        }
-        normals = new_normals;
-
-        vector<face *> new_faces;
-        for (face *f : other.faces) {
-            face *f2 = new face(*f);
-            new_faces.push_back(f2);
-        }
-        faces = new_faces;
-
-        transformations = other.transformations;
-        material = other.material;
-        label = other.label;
-    }
-    ~object() {
-        for (vertex *v : vertices) {
-            if (v != NULL)
-                delete v;
-        }
-        for (face *f : faces) {
-            if (f != NULL)
-                delete f;
-        }
-        for (surface_normal *n : normals) {
-            if (n != NULL)
-                delete n;
-        }
-    }
+    object() : geometry(NULL) {}
+    object(const tri_mesh *geometry) : geometry(geometry) {}
 };
 
 void output_lights(vector<light *> lights);
@@ -203,16 +199,23 @@ struct scene {
     float top;
     float bottom;
     vector<object *> objects;
+    // The meshes the objects are made from, one for each file
+    vector<tri_mesh *> meshes;
     vector<light *> lights;
-    MatrixXd pp_mat;
-    MatrixXd world_to_cam_mat;
-    MatrixXd depth_buffer;
-    scene() {}
+    // Filled by set_camera_matrices
+    Matrix4d pp_mat;
+    affine_transform<double> world_to_cam_mat;
+    bool camera_matrices_set;
+    scene() : camera_matrices_set(false) {}
     ~scene() {
         for (object *o : objects) {
             if (o != NULL)
                 delete o;
         }
+        for (tri_mesh *m : meshes) {
+            if (m != NULL)
+                delete m;
+        }
         for (light *l : lights) {
             if (l != NULL)
                 delete l;
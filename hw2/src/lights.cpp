@@ -0,0 +1,213 @@
+#include "lights.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace std;
+
+/*
+ * Lays the scene's lights out as a structure of arrays for light_batch.
+ */
+void build_light_array(scene *s, light_array& lights) {
+    lights.count = s->lights.size();
+    lights.x.resize(lights.count);
+    lights.y.resize(lights.count);
+    lights.z.resize(lights.count);
+    lights.r.resize(lights.count);
+    lights.g.resize(lights.count);
+    lights.b.resize(lights.count);
+    lights.attenuation.resize(lights.count);
+    for (int l = 0; l < lights.count; l++) {
+        light *lt = s->lights[l];
+        lights.x[l] = lt->position.x;
+        lights.y[l] = lt->position.y;
+        lights.z[l] = lt->position.z;
+        lights.r[l] = lt->colr.r;
+        lights.g[l] = lt->colr.g;
+        lights.b[l] = lt->colr.b;
+        lights.attenuation[l] = lt->attenuation;
+    }
+}
+
+/*
+ * Reinterprets the bits of a float as an int and back.
+ */
+static inline int float_bits(float f) {
+    int i;
+    memcpy(&i, &f, sizeof(i));
+    return i;
+}
+
+static inline float bits_float(int i) {
+    float f;
+    memcpy(&f, &i, sizeof(f));
+    return f;
+}
+
+/*
+ * Approximates pow(x, y) for x in [0, 1] and y >= 0 as 2^(y * log2(x)). The
+ * exponent of x gives the integer part of log2(x), and a polynomial in the
+ * mantissa the rest (absolute error below 7.4e-6). 2^t is then built the same
+ * way in reverse, with a polynomial for the fractional part of t (relative
+ * error below 3.5e-6). Everything is done with selects rather than branches,
+ * so a loop calling this can be vectorized.
+ */
+static inline float fast_pow(float x, float y) {
+    int x_bits = float_bits(x);
+    float exponent = (float) (x_bits >> 23) - 127.0f;
+    float u = bits_float((x_bits & 0x7fffff) | 0x3f800000) - 1.0f;
+    // log2(1 + u) / u on [0, 1)
+    float log2_mantissa = u * (1.44268147f + u * (-0.720358773f
+            + u * (0.468658879f + u * (-0.30163801f + u * (0.144471096f
+            + u * -0.033822046f)))));
+
+    // Anything smaller than 2^-126 rounds to 0 when it becomes a color
+    float t = y * (exponent + log2_mantissa);
+    t = (t < -126.0f) ? -126.0f : t;
+    float whole = (float) (int) t;
+    whole -= (whole > t) ? 1.0f : 0.0f;
+    float f = t - whole;
+    // 2^f on [0, 1)
+    float p = 1.00000349f + f * (0.692972922f + f * (0.241604357f
+            + f * (0.0517449978f + f * 0.0136703095f)));
+    p = bits_float(float_bits(p) + ((int) whole << 23));
+
+    // pow(0, y) is 0, except that pow(x, 0) is always 1
+    p = (x > 0) ? p : 0.0f;
+    return (y == 0) ? 1.0f : p;
+}
+
+/*
+ * Adds the diffuse and specular light the l-th light casts on each fragment
+ * of a batch to the sums, given the directions from the fragments to the
+ * camera. Raising the specular term to the shininess is left to a second loop:
+ * the exact version has to call pow there, and the fast one vectorizes more
+ * readily on its own.
+ */
+template <light_precision precision>
+static void add_light(const fragment_batch& batch, const float *cam_x,
+        const float *cam_y, const float *cam_z, const light_array& lights,
+        int l, light_sums& sums) {
+    const int n = light_batch_size;
+    float light_x = lights.x[l];
+    float light_y = lights.y[l];
+    float light_z = lights.z[l];
+    float light_r = lights.r[l];
+    float light_g = lights.g[l];
+    float light_b = lights.b[l];
+    float light_k = lights.attenuation[l];
+
+    float col_r[n], col_g[n], col_b[n], spec[n];
+    for (int i = 0; i < n; i++) {
+        float dir_x = light_x - batch.x[i];
+        float dir_y = light_y - batch.y[i];
+        float dir_z = light_z - batch.z[i];
+        // Sums of three are grouped the way Eigen groups them, so that the
+        // exact mode matches lighting() bit for bit
+        float distance = sqrt(dir_x * dir_x + (dir_y * dir_y
+                + dir_z * dir_z));
+        dir_x /= distance;
+        dir_y /= distance;
+        dir_z /= distance;
+
+        // Factor in attenuation. lighting() does this in double precision
+        float attenuation_const;
+        if (precision == exact_lighting) {
+            attenuation_const = 1.0 / (1.0 + light_k * distance * distance);
+        } else {
+            attenuation_const = 1.0f / (1.0f + light_k * distance * distance);
+        }
+        col_r[i] = light_r * attenuation_const;
+        col_g[i] = light_g * attenuation_const;
+        col_b[i] = light_b * attenuation_const;
+
+        // Add to diffuse sum
+        float diff = max(0.0f, batch.normal_x[i] * dir_x
+                + (batch.normal_y[i] * dir_y + batch.normal_z[i] * dir_z));
+        sums.diffuse_r[i] += col_r[i] * diff;
+        sums.diffuse_g[i] += col_g[i] * diff;
+        sums.diffuse_b[i] += col_b[i] * diff;
+
+        // Halfway vector for the specular sum
+        float h_x = cam_x[i] + dir_x;
+        float h_y = cam_y[i] + dir_y;
+        float h_z = cam_z[i] + dir_z;
+        float h_norm = sqrt(h_x * h_x + (h_y * h_y + h_z * h_z));
+        h_x /= h_norm;
+        h_y /= h_norm;
+        h_z /= h_norm;
+        spec[i] = max(0.0f, batch.normal_x[i] * h_x
+                + (batch.normal_y[i] * h_y + batch.normal_z[i] * h_z));
+    }
+
+    for (int i = 0; i < n; i++) {
+        if (precision == exact_lighting) {
+            spec[i] = pow(spec[i], batch.shininess[i]);
+        } else {
+            spec[i] = fast_pow(spec[i], batch.shininess[i]);
+        }
+        sums.specular_r[i] += col_r[i] * spec[i];
+        sums.specular_g[i] += col_g[i] * spec[i];
+        sums.specular_b[i] += col_b[i] * spec[i];
+    }
+}
+
+/*
+ * Sums the diffuse and specular light every light in the scene casts on each
+ * fragment of a batch, following the lighting model in lighting(). The loops
+ * over the fragments of the batch work on plain arrays, so they can be
+ * vectorized, and the per light values are read once per batch rather than
+ * once per fragment. Unused slots of the batch are filled with copies of its
+ * first fragment.
+ */
+void light_batch(fragment_batch& batch, const light_array& lights,
+        const Vector3f& cam_pos, light_precision precision, light_sums& sums) {
+    const int n = light_batch_size;
+    for (int i = batch.count; i < n; i++) {
+        batch.x[i] = batch.x[0];
+        batch.y[i] = batch.y[0];
+        batch.z[i] = batch.z[0];
+        batch.normal_x[i] = batch.normal_x[0];
+        batch.normal_y[i] = batch.normal_y[0];
+        batch.normal_z[i] = batch.normal_z[0];
+        batch.shininess[i] = batch.shininess[0];
+    }
+
+    // Direction from each fragment to the camera
+    float cam_x[n], cam_y[n], cam_z[n];
+    for (int i = 0; i < n; i++) {
+        cam_x[i] = cam_pos(0) - batch.x[i];
+        cam_y[i] = cam_pos(1) - batch.y[i];
+        cam_z[i] = cam_pos(2) - batch.z[i];
+        // lighting() uses Eigen's normalize() here, which multiplies by the
+        // reciprocal of the norm rather than dividing by it
+        float inv_norm = 1.0f / sqrt(cam_x[i] * cam_x[i]
+                + (cam_y[i] * cam_y[i] + cam_z[i] * cam_z[i]));
+        cam_x[i] *= inv_norm;
+        cam_y[i] *= inv_norm;
+        cam_z[i] *= inv_norm;
+    }
+
+    // Accumulate into locals, which the compiler knows don't alias the batch
+    light_sums local_sums;
+    for (int i = 0; i < n; i++) {
+        local_sums.diffuse_r[i] = 0;
+        local_sums.diffuse_g[i] = 0;
+        local_sums.diffuse_b[i] = 0;
+        local_sums.specular_r[i] = 0;
+        local_sums.specular_g[i] = 0;
+        local_sums.specular_b[i] = 0;
+    }
+    const fragment_batch local_batch = batch;
+
+    for (int l = 0; l < lights.count; l++) {
+        if (precision == exact_lighting) {
+            add_light<exact_lighting>(local_batch, cam_x, cam_y, cam_z, lights,
+                    l, local_sums);
+        } else {
+            add_light<fast_lighting>(local_batch, cam_x, cam_y, cam_z, lights,
+                    l, local_sums);
+        }
+    }
+    sums = local_sums;
+}
@@ -0,0 +1,69 @@
+#ifndef LIGHTS_H
+#define LIGHTS_H
+
+#include "framework.h"
+
+using namespace std;
+
+// Number of fragments the lighting kernel shades at once
+static const int light_batch_size = 8;
+
+/*******************************************************************************
+ * Defines the batched lighting kernel. It evaluates the same lighting model as
+ * lighting() in draw.cpp, but for light_batch_size fragments at a time against
+ * the scene's lights laid out as a structure of arrays, so that the inner loop
+ * over the fragments of a batch can be vectorized.
+ ******************************************************************************/
+
+// How the kernel raises the specular term to the shininess. exact_lighting
+// calls pow, and fast_lighting uses a polynomial approximation whose relative
+// error is below 1e-5 * (1 + shininess)
+enum light_precision {
+    exact_lighting,
+    fast_lighting
+};
+
+// The scene's lights as a structure of arrays. Attenuation is the k in
+// 1 / (1 + k * d^2)
+struct light_array {
+    int count;
+    vector<float> x;
+    vector<float> y;
+    vector<float> z;
+    vector<float> r;
+    vector<float> g;
+    vector<float> b;
+    vector<float> attenuation;
+    light_array() : count(0) {}
+};
+
+// The fragments to shade, also as a structure of arrays. Only the first count
+// of them are used
+struct fragment_batch {
+    int count;
+    float x[light_batch_size];
+    float y[light_batch_size];
+    float z[light_batch_size];
+    float normal_x[light_batch_size];
+    float normal_y[light_batch_size];
+    float normal_z[light_batch_size];
+    float shininess[light_batch_size];
+    fragment_batch() : count(0) {}
+};
+
+// The diffuse and specular light reaching each fragment of a batch, summed
+// over every light, before the material's colors are applied
+struct light_sums {
+    float diffuse_r[light_batch_size];
+    float diffuse_g[light_batch_size];
+    float diffuse_b[light_batch_size];
+    float specular_r[light_batch_size];
+    float specular_g[light_batch_size];
+    float specular_b[light_batch_size];
+};
+
+void build_light_array(scene *s, light_array& lights);
+void light_batch(fragment_batch& batch, const light_array& lights,
+        const Vector3f& cam_pos, light_precision precision, light_sums& sums);
+
+#endif
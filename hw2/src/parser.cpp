@@ -1,6 +1,7 @@
 /*** For parsing graphics files. Contains a lot of copied code from Assignment 0 ***/
 
 #include "parser.h"
+#include "mesh_cache.h"
 #include <stdio.h>
 #include <iostream>
 #include <fstream>
@@ -30,7 +31,7 @@ scene *parse_scene(ifstream &infile) {
      */
     while (getline(infile, line)) {
         if (line.compare("objects:") == 0) {
-            s->objects = parse_objects(infile);
+            s->objects = parse_objects(infile, s->meshes);
             break;
         } else {
             istringstream iss(line);
@@ -77,12 +78,14 @@ scene *parse_scene(ifstream &infile) {
 
 /*
  * Given an input file of the format specified in HW0 Part 3, reads through it and
- * returns a vector of pointers to object structs. Each object struct has a
- * vector of pointers to vertices, a vector of pointers to faces, and a vector
- * of transformation matrices. Each object struct also has a label.
+ * returns a vector of pointers to object structs. Each object struct points to
+ * the mesh it was made from, and has a vector of transformation matrices and a
+ * label. Each file is only read once, into a mesh that is added to meshes and
+ * shared by every object made from it.
  */
-vector<object *> parse_objects(ifstream &infile) {
-    unordered_map<string, object *> labels_map;
+vector<object *> parse_objects(ifstream &infile,
+        vector<tri_mesh *>& meshes) {
+    unordered_map<string, tri_mesh *> labels_map;
     vector<object *> object_copies;
 
     string line;
@@ -92,7 +95,6 @@ vector<object *> parse_objects(ifstream &infile) {
     float x, y, z, r, g, b;
     float shine;
     float angle = 0;
-    object *curr_object;
     object *object_copy;
 
     /*
@@ -105,11 +107,11 @@ vector<object *> parse_objects(ifstream &infile) {
         if (iss >> determ >> x >> y >> z) {
             if (determ == 'r')
                 (iss >> angle);
-            MatrixXd matrix = get_matrix(determ, x, y, z, angle);
-            // Add transformation matrix to current object copy
-            object_copy->transformations.push_back(matrix);
-            if (determ != 't')
-                object_copy->normal_transformations.push_back(matrix);
+            // Add transformation to current object copy
+            if (!object_copy->transformations.add(determ, x, y, z, angle)) {
+                cout << "Invalid argument, exiting" << endl;
+                exit(EXIT_FAILURE);
+            }
             continue;
         }
 
@@ -121,28 +123,32 @@ vector<object *> parse_objects(ifstream &infile) {
             (iss >> r >> g >> b);
             color amb(r, g, b);
             object_copy->material.ambient = amb;
+            continue;
         } else if (shading_determ.compare("diffuse") == 0) {
             (iss >> r >> g >> b);
             color diff(r, g, b);
             object_copy->material.diffuse = diff;
+            continue;
         } else if (shading_determ.compare("specular") == 0) {
             (iss >> r >> g >> b);
             color spec(r, g, b);
             object_copy->material.specular = spec;
+            continue;
         } else if (shading_determ.compare("shininess") == 0) {
             (iss >> shine);
             object_copy->material.shininess = shine;
+            continue;
         }
 
         iss.str(line);
         iss.clear();
         /* This reads the first part of the file, labels and filenames. */
         if (iss >> label >> filename) {
-            // For each filename, create the corresponding object and put it in
+            // For each filename, create the corresponding mesh and put it in
             // the unordered_map
-            object *o = parse_object(filename.c_str());
-            o->label = label;
-            labels_map[label] = o;
+            tri_mesh *m = parse_mesh(filename.c_str());
+            meshes.push_back(m);
+            labels_map[label] = m;
             continue;
         }
 
@@ -150,155 +156,25 @@ vector<object *> parse_objects(ifstream &infile) {
         iss.clear();
         /* This reads labels for the second part of the file. */
         if (iss >> label) {
-            // Get current object from map we populated when reading first part
-            // of file
-            curr_object = labels_map[label];
-            object_copy = new object(*curr_object);
+            // Make a new object from the mesh we read for this label in the
+            // first part of the file
+            object_copy = new object(labels_map[label]);
+            object_copy->label = label;
             object_copies.push_back(object_copy);
         }
     }
 
-    // Free memory
-    for (unordered_map<string, object *>::iterator iter = labels_map.begin();
-            iter != labels_map.end(); ++iter) {
-        object *o = iter->second;
-        delete o;
-    }
-
     return object_copies;
 }
 
 /*
- * Creats an object from a file, and returns a pointer to it.
+ * Creates a mesh from a file, and returns a pointer to it.
  */
-object *parse_object(const char *filename) {
+tri_mesh *parse_mesh(const char *filename) {
     string rel_filename = DATA_DIR;
     rel_filename.append(filename);
-    ifstream infile(rel_filename);
-    string line;
-    string determ;
-    float x, y, z;
-    string mult_x, mult_y, mult_z;
-    vector<vertex *> vertices;
-    vector<surface_normal *> normals;
-    vector<face *> faces;
-    // Vertices are 1-indexed, so push null for 0th element
-    vertices.push_back(NULL);
-    // Normals are 1-indexed too, so push null for 0th element
-    normals.push_back(NULL);
-
-    // Go through file and read vertices and faces, create structs
-    while (getline(infile, line)) {
-        istringstream iss(line);
-        (iss >> determ);
-        // Create new vertex
-        if (determ.compare("v") == 0) {
-            (iss >> x >> y >> z);
-            vertex *v = new vertex(x, y, z);
-            vertices.push_back(v);
-        } else if (determ.compare("vn") == 0) {
-            (iss >> x >> y >> z);
-            surface_normal *n = new surface_normal(x, y, z);
-            normals.push_back(n);
-        } else {
-            (iss >> mult_x >> mult_y >> mult_z);
-            string v1_str = mult_x.substr(0, mult_x.find("//"));
-            string vn1_str = mult_x.substr(mult_x.find("//") + 2);
-            int v1 = stoi(v1_str);
-            int vn1 = stoi(vn1_str);
-            string v2_str = mult_y.substr(0, mult_y.find("//"));
-            string vn2_str = mult_y.substr(mult_y.find("//") + 2);
-            int v2 = stoi(v2_str);
-            int vn2 = stoi(vn2_str);
-            string v3_str = mult_z.substr(0, mult_z.find("//"));
-            string vn3_str = mult_z.substr(mult_z.find("//") + 2);
-            int v3 = stoi(v3_str);
-            int vn3 = stoi(vn3_str);
-            face *f = new face(v1, v2, v3, vn1, vn2, vn3);
-            faces.push_back(f);
-        }
-    }
-
-    object *o = new object(vertices, normals, faces);
-    return o;
-}
-
-/*
- * Compute the product of a vector of matrixes. Given that the vector contains
- * matrices A, B, and C, in that order, we will compute the product CBA.
- */
-MatrixXd compute_product(vector<MatrixXd> matrices) {
-    MatrixXd prod = matrices[matrices.size() - 1];
-    for (int i = matrices.size() - 2; i >= 0; i--) {
-        prod = prod * matrices[i];
-    }
-    return prod;
-}
-
-/*
- * From character determ, determines which matrix (of translation/scaling/rotation)
- * to get, and returns it.
- */
-MatrixXd get_matrix(char determ, float x, float y, float z, float angle) {
-    if (determ == 't') {
-        // Translation matrix
-        return get_translation_matrix(x, y, z);
-    } else if (determ == 's') {
-        // Scaling matrix
-        return get_scaling_matrix(x, y, z);
-    } else if (determ == 'r') {
-        // Rotation matrix
-        return get_rotation_matrix(x, y, z, angle);
-    } else {
-        cout << "Invalid argument, exiting" << endl;
-        exit(EXIT_FAILURE);
-    }
-}
-
-/*
- * Creates the translation matrix corresponding to the (x, y, z) vector and
- * returns it.
- */
-MatrixXd get_translation_matrix(float x, float y, float z) {
-    MatrixXd m(4,4);
-    m << 1, 0, 0, x,
-      0, 1, 0, y,
-      0, 0, 1, z,
-      0, 0, 0, 1;
-    return m;
-}
-
-/*
- * Creates the scaling matrix corresponding to the (x, y, z) vector and
- * returns it.
- */
-MatrixXd get_scaling_matrix(float x, float y, float z) {
-    MatrixXd m(4,4);
-    m << x, 0, 0, 0,
-      0, y, 0, 0,
-      0, 0, z, 0,
-      0, 0, 0, 1;
-    return m;
-}
-
-/*
- * Creates the rotation matrix corresponding to the (x, y, z) vector and the
- * passed-in angle and returns it.
- */
-MatrixXd get_rotation_matrix(float x, float y, float z, float angle) {
-    MatrixXd m(4,4);
-    // Make input vector a unit vector
-    float magnitude = sqrt(x * x + y * y + z * z);
-    x /= magnitude;
-    y /= magnitude;
-    z /= magnitude;
-
-    m << (x * x) + (1 - (x * x)) * cos(angle), (x * y) * (1 - cos(angle)) - z * sin(angle),
-              (x * z) * (1 - cos(angle)) + y * sin(angle), 0,
-      (y * x) * (1 - cos(angle)) + z * sin(angle), (y * y) + (1 - y * y) * cos(angle),
-              (y * z) * (1 - cos(angle)) - x * sin(angle), 0,
-      (z * x) * (1 - cos(angle)) - y * sin(angle), (z * y) * (1 - cos(angle)) + x * sin(angle),
-              (z * z) + (1 - (z * z)) * cos(angle), 0,
-      0, 0, 0, 1;
+    // If the file can't be read, the loader says so and the mesh is empty
+    tri_mesh *m = new tri_mesh;
+    load_obj_cached(rel_filename.c_str(), *m);
     return m;
 }
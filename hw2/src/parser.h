@@ -6,10 +6,8 @@
 #include <vector>
 #include <string>
 #include <iostream>
-#include <Eigen/Dense>
 #include "framework.h"
 
-using Eigen::MatrixXd;
 using namespace std;
 
 /*******************************************************************************
@@ -17,12 +15,8 @@ using namespace std;
  ******************************************************************************/
 
 scene *parse_scene(ifstream &infile);
-vector<object *> parse_objects(ifstream &infile);
-object *parse_object(const char* filename);
-MatrixXd compute_product(vector<MatrixXd> matrices);
-MatrixXd get_matrix(char determ, float x, float y, float z, float angle = 0);
-MatrixXd get_translation_matrix(float x, float y, float z);
-MatrixXd get_scaling_matrix(float x, float y, float z);
-MatrixXd get_rotation_matrix(float x, float y, float z, float angle);
+vector<object *> parse_objects(ifstream &infile,
+        vector<tri_mesh *>& meshes);
+tri_mesh *parse_mesh(const char* filename);
 
 #endif
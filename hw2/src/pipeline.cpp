@@ -0,0 +1,547 @@
+#include "pipeline.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <climits>
+#include <thread>
+
+using namespace std;
+
+// Side length of the square pixel blocks the hierarchical depth buffer keeps
+// the farthest depth of. Tiles are a whole number of blocks across
+static const int hiz_block_size = 8;
+
+// How much nearer than its nearest vertex a face's interpolated depth can
+// come out through rounding
+static const float depth_slack = 1e-5;
+
+// A face to draw, by its index in the mesh of the object it belongs to, along
+// with that object and its index in the scene. Once binned, it also holds the
+// face's screen bounds and the depth of its nearest vertex, and the pieces to
+// draw instead if the face had to be clipped. For Gouraud shading it holds the
+// colors of its corners too, since the face itself is shared by every object
+// made from the same mesh
+struct face_ref {
+    object *o;
+    int triangle;
+    int object_index;
+    bool binned;
+    tile bounds;
+    float nearest;
+    vector<face_piece> pieces;
+    color colors[3];
+    face_ref(object *o, int triangle, int object_index) : o(o),
+            triangle(triangle), object_index(object_index), binned(false) {}
+    face get_face() const {
+        return face(*o->geometry, triangle);
+    }
+};
+
+// A corner Gouraud shading lights: a vertex of an object paired with the
+// normal a face gives it there. The corners listed for the same vertex are
+// chained together through next
+struct lit_corner {
+    object *o;
+    int v;
+    int vn;
+    int next;
+};
+
+// The screen bounds of an object and the depth of its nearest vertex
+struct object_bounds {
+    tile bounds;
+    float nearest;
+};
+
+/*
+ * A coarse depth buffer over one tile, holding the farthest depth in each
+ * block of its pixels. A face or object that is farther away than every block
+ * it covers would fail the depth test at all of its pixels, so it can be
+ * skipped without rasterizing it. Blocks start out at the depth buffer's
+ * initial value, and are recomputed from the depth buffer after something is
+ * drawn over them, so they only start rejecting faces once they are filled.
+ */
+struct hiz_tile {
+    tile bounds;
+    int blocks_x;
+    vector<float> farthest;
+    vector<bool> stale;
+
+    hiz_tile(const tile& bounds) : bounds(bounds),
+            blocks_x((bounds.x_max - bounds.x_min) / hiz_block_size + 1),
+            farthest(blocks_x * ((bounds.y_max - bounds.y_min)
+                / hiz_block_size + 1), FLT_MAX),
+            stale(farthest.size(), false) {}
+
+    /*
+     * Calls visit(i, block) for every block overlapping region, which must
+     * lie within the tile.
+     */
+    template <typename Visit>
+    void for_blocks(const tile& region, Visit visit) {
+        int bx_min = (region.x_min - bounds.x_min) / hiz_block_size;
+        int bx_max = (region.x_max - bounds.x_min) / hiz_block_size;
+        int by_min = (region.y_min - bounds.y_min) / hiz_block_size;
+        int by_max = (region.y_max - bounds.y_min) / hiz_block_size;
+        for (int by = by_min; by <= by_max; by++) {
+            for (int bx = bx_min; bx <= bx_max; bx++) {
+                int x_min = bounds.x_min + bx * hiz_block_size;
+                int y_min = bounds.y_min + by * hiz_block_size;
+                visit(by * blocks_x + bx, tile(x_min, y_min,
+                        min(x_min + hiz_block_size - 1, bounds.x_max),
+                        min(y_min + hiz_block_size - 1, bounds.y_max)));
+            }
+        }
+    }
+
+    /*
+     * Returns whether every pixel of region is nearer than the given depth.
+     */
+    bool occludes(const tile& region, float nearest, framebuffer& fb) {
+        bool occluded = true;
+        for_blocks(region, [&](int i, const tile& block) {
+            if (!occluded)
+                return;
+            if (stale[i]) {
+                // Each row of the block is contiguous in the framebuffer
+                float block_farthest = -FLT_MAX;
+                int width = block.x_max - block.x_min + 1;
+                for (int y = block.y_min; y <= block.y_max; y++) {
+                    const float *depths = &fb.depth(block.x_min, y);
+                    for (int x = 0; x < width; x++) {
+                        block_farthest = max(block_farthest, depths[x]);
+                    }
+                }
+                farthest[i] = block_farthest;
+                stale[i] = false;
+            }
+            occluded = nearest - depth_slack > farthest[i];
+        });
+        return occluded;
+    }
+
+    /*
+     * Marks the blocks overlapping region as drawn over.
+     */
+    void update(const tile& region) {
+        for_blocks(region, [&](int i, const tile&) {
+            stale[i] = true;
+        });
+    }
+};
+
+/*
+ * Returns the part of region inside bounds, which may be empty.
+ */
+static tile clip(const tile& region, const tile& bounds) {
+    return tile(max(region.x_min, bounds.x_min),
+            max(region.y_min, bounds.y_min),
+            min(region.x_max, bounds.x_max),
+            min(region.y_max, bounds.y_max));
+}
+
+// The faces overlapping each tile, as indices into the list of faces
+typedef vector<vector<unsigned int> > tile_bins;
+
+/*
+ * Runs work(t) on thread_count threads, with t going from 0 to
+ * thread_count - 1, and waits for all of them to finish.
+ */
+template <typename Work>
+static void run_in_parallel(unsigned int thread_count, Work work) {
+    vector<thread> workers;
+    for (unsigned int t = 1; t < thread_count; t++) {
+        workers.emplace_back(work, t);
+    }
+    work(0);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/*
+ * Lights the corners of every binned face for Gouraud shading, storing the
+ * colors in the faces. Neighbouring faces share most of their corners, so the
+ * corners are listed first, once for each pairing of a vertex and a normal in
+ * an object, and then lit in parallel. Each face takes its colors from the
+ * list, which gives the same colors as lighting the face's corners itself.
+ */
+static void light_corners(vector<face_ref>& faces, scene *s,
+        unsigned int thread_count) {
+    vector<lit_corner> corners;
+    // The corners of the i-th face, as indices into the list
+    vector<int> face_corners(3 * faces.size());
+    // The last corner listed for each vertex of the current object. The faces
+    // of an object are listed together, so this is reset when a new one starts
+    vector<int> vertex_corners;
+    object *current = NULL;
+    for (size_t i = 0; i < faces.size(); i++) {
+        if (!faces[i].binned)
+            continue;
+        object *o = faces[i].o;
+        face tri = faces[i].get_face();
+        face *f = &tri;
+        if (o != current) {
+            current = o;
+            vertex_corners.assign(o->ndc_vertices.size(), -1);
+        }
+
+        int v[] = {f->v1, f->v2, f->v3};
+        int vn[] = {f->vn1, f->vn2, f->vn3};
+        for (int k = 0; k < 3; k++) {
+            int c = vertex_corners[v[k]];
+            while (c != -1 && corners[c].vn != vn[k])
+                c = corners[c].next;
+            if (c == -1) {
+                c = corners.size();
+                lit_corner corner = {o, v[k], vn[k], vertex_corners[v[k]]};
+                corners.push_back(corner);
+                vertex_corners[v[k]] = c;
+            }
+            face_corners[3 * i + k] = c;
+        }
+    }
+
+    vector<color> colors(corners.size());
+    run_in_parallel(thread_count, [&](unsigned int t) {
+        size_t first = corners.size() * t / thread_count;
+        size_t last = corners.size() * (t + 1) / thread_count;
+        for (size_t c = first; c < last; c++) {
+            object *o = corners[c].o;
+            colors[c] = lighting(fragment(
+                    o->ndc_vertices[corners[c].v].get_world_vec(),
+                    o->world_normals[corners[c].vn].get_vec()), o->material, s);
+        }
+    });
+
+    for (size_t i = 0; i < faces.size(); i++) {
+        if (!faces[i].binned)
+            continue;
+        for (int k = 0; k < 3; k++) {
+            faces[i].colors[k] = colors[face_corners[3 * i + k]];
+        }
+    }
+}
+
+// A scene's faces, along with everything about them that's worked out once
+// however many bands of the image they're then drawn into
+struct prepared_scene {
+    int xres;
+    int yres;
+    vector<object_bounds> objects;
+    vector<face_ref> faces;
+};
+
+/*
+ * Lists and bounds the faces of a scene for an image of the given resolution,
+ * and lights their corners for Gouraud shading.
+ */
+static void prepare_scene(scene *s, int xres, int yres, int mode,
+        unsigned int thread_count, prepared_scene& prepared) {
+    prepared.xres = xres;
+    prepared.yres = yres;
+
+    // Find where each object lies on the screen, and how near it gets. The
+    // vertices of objects crossing the edge of the view frustum can be behind
+    // the camera, where their projections mean nothing, so those objects are
+    // taken to cover the whole screen, right up to the near plane
+    vector<object_bounds>& objects = prepared.objects;
+    objects.resize(s->objects.size());
+    for (size_t i = 0; i < s->objects.size(); i++) {
+        object_bounds& ob = objects[i];
+        if (s->objects[i]->visibility == crosses_frustum) {
+            ob.bounds = tile(0, 0, xres - 1, yres - 1);
+            ob.nearest = -1;
+            continue;
+        }
+        ob.bounds = tile(INT_MAX, INT_MAX, INT_MIN, INT_MIN);
+        ob.nearest = FLT_MAX;
+        for (size_t v = 1; v < s->objects[i]->ndc_vertices.size(); v++) {
+            const vertex& ndc = s->objects[i]->ndc_vertices[v];
+            ob.bounds.x_min = min(ob.bounds.x_min, ndc.screen_x);
+            ob.bounds.y_min = min(ob.bounds.y_min, ndc.screen_y);
+            ob.bounds.x_max = max(ob.bounds.x_max, ndc.screen_x);
+            ob.bounds.y_max = max(ob.bounds.y_max, ndc.screen_y);
+            ob.nearest = min(ob.nearest, ndc.z);
+        }
+    }
+
+    // List every face of the objects in view, drawing the objects roughly
+    // front to back so that the nearer ones fill the hierarchical depth buffer
+    // first
+    vector<int> order(s->objects.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), [&](int i, int j) {
+        return objects[i].nearest < objects[j].nearest;
+    });
+    vector<face_ref>& faces = prepared.faces;
+    for (int i : order) {
+        if (s->objects[i]->visibility == outside_frustum)
+            continue;
+        for (int k = 0; k < s->objects[i]->geometry->face_count(); k++) {
+            faces.emplace_back(s->objects[i], k, i);
+        }
+    }
+
+    /*
+     * PHASE 1: Each thread clips and bounds a contiguous range of the faces.
+     */
+    run_in_parallel(thread_count, [&](unsigned int t) {
+        size_t first = faces.size() * t / thread_count;
+        size_t last = faces.size() * (t + 1) / thread_count;
+        for (size_t i = first; i < last; i++) {
+            object *o = faces[i].o;
+            face tri = faces[i].get_face();
+            face *f = &tri;
+            tile& bounds = faces[i].bounds;
+            clip_result clipped = face_inside;
+            if (o->visibility == crosses_frustum)
+                clipped = clip_face(f, o, xres, yres, faces[i].pieces);
+            if (clipped == face_outside)
+                continue;
+
+            if (clipped == face_inside) {
+                if (!face_screen_bounds(f, o, xres, yres, bounds))
+                    continue;
+                const vector<vertex>& ndc = o->ndc_vertices;
+                faces[i].nearest = min({ndc[f->v1].z, ndc[f->v2].z,
+                        ndc[f->v3].z});
+            } else {
+                // Bound the pieces instead
+                bounds = tile(xres, yres, -1, -1);
+                faces[i].nearest = FLT_MAX;
+                for (const face_piece& piece : faces[i].pieces) {
+                    for (const clipped_corner& corner : piece.corners) {
+                        bounds.x_min = min(bounds.x_min, corner.screen_x);
+                        bounds.y_min = min(bounds.y_min, corner.screen_y);
+                        bounds.x_max = max(bounds.x_max, corner.screen_x);
+                        bounds.y_max = max(bounds.y_max, corner.screen_y);
+                        faces[i].nearest = min(faces[i].nearest, corner.z);
+                    }
+                }
+                bounds = clip(bounds, tile(0, 0, xres - 1, yres - 1));
+                if (bounds.x_min > bounds.x_max || bounds.y_min > bounds.y_max)
+                    continue;
+            }
+            faces[i].binned = true;
+        }
+    });
+
+    /*
+     * Gouraud shading lights the corners of the bounded faces before they are
+     * drawn, so that each is lit once no matter how many faces share it or
+     * how many tiles they overlap.
+     */
+    if (mode == 0)
+        light_corners(faces, s, thread_count);
+}
+
+/*
+ * Draws the faces with the given indices, which must all overlap the rows the
+ * framebuffer holds, into it. The rows are split into tiles starting from the
+ * framebuffer's first row, which should be a whole number of tiles up the
+ * screen so that the tiles are the same ones drawing the whole screen at once
+ * would use.
+ */
+static void render_band(scene *s, prepared_scene& prepared,
+        const vector<unsigned int>& band_faces, framebuffer& fb, int mode,
+        unsigned int thread_count) {
+    if (mode < 0 || mode > 3)
+        return;
+    int xres = fb.xres;
+    int y_min = fb.y_min;
+    int y_max = fb.y_min + fb.yres - 1;
+    int tiles_x = (xres + tile_size - 1) / tile_size;
+    int tiles_y = (fb.yres + tile_size - 1) / tile_size;
+    unsigned int tile_count = tiles_x * tiles_y;
+    const vector<object_bounds>& objects = prepared.objects;
+    vector<face_ref>& faces = prepared.faces;
+
+    // The pixels of the i-th tile
+    auto get_tile = [&](unsigned int i) {
+        int tx = i % tiles_x;
+        int ty = i / tiles_x;
+        return tile(tx * tile_size, y_min + ty * tile_size,
+                min((tx + 1) * tile_size, xres) - 1,
+                min(y_min + (ty + 1) * tile_size - 1, y_max));
+    };
+    // Deferred shading's G-buffer
+    bool deferred = mode == 2 || mode == 3;
+    gbuffer gbuf(deferred ? xres : 0, deferred ? fb.yres : 0, y_min);
+
+    /*
+     * Each thread bins a contiguous range of the band's faces into its own
+     * set of tiles.
+     */
+    vector<tile_bins> bins(thread_count, tile_bins(tile_count));
+    run_in_parallel(thread_count, [&](unsigned int t) {
+        size_t first = band_faces.size() * t / thread_count;
+        size_t last = band_faces.size() * (t + 1) / thread_count;
+        for (size_t k = first; k < last; k++) {
+            unsigned int i = band_faces[k];
+            const tile& bounds = faces[i].bounds;
+            int ty_min = (max(bounds.y_min, y_min) - y_min) / tile_size;
+            int ty_max = (min(bounds.y_max, y_max) - y_min) / tile_size;
+            for (int ty = ty_min; ty <= ty_max; ty++) {
+                for (int tx = bounds.x_min / tile_size;
+                        tx <= bounds.x_max / tile_size; tx++) {
+                    bins[t][ty * tiles_x + tx].push_back(i);
+                }
+            }
+        }
+    });
+
+    /*
+     * PHASE 2: Threads take tiles one at a time and draw every face binned
+     * into them, clipped to the tile. Going through the threads' bins in order
+     * draws the faces in the order they were listed. Each tile keeps its own
+     * hierarchical depth buffer, which whole objects and then single faces
+     * are tested against before they are rasterized.
+     */
+    atomic<unsigned int> next_tile(0);
+    run_in_parallel(thread_count, [&](unsigned int) {
+        for (unsigned int i = next_tile++; i < tile_count; i = next_tile++) {
+            tile bounds = get_tile(i);
+            hiz_tile hiz(bounds);
+            int current_object = -1;
+            bool object_hidden = false;
+            for (const tile_bins& thread_bins : bins) {
+                for (unsigned int j : thread_bins[i]) {
+                    // The faces of an object are binned together, so it's
+                    // only tested when a new one starts
+                    if (faces[j].object_index != current_object) {
+                        current_object = faces[j].object_index;
+                        const object_bounds& ob = objects[current_object];
+                        object_hidden = hiz.occludes(clip(ob.bounds, bounds),
+                                ob.nearest, fb);
+                    }
+                    if (object_hidden)
+                        continue;
+                    tile region = clip(faces[j].bounds, bounds);
+                    if (hiz.occludes(region, faces[j].nearest, fb))
+                        continue;
+
+                    object *o = faces[j].o;
+                    face tri = faces[j].get_face();
+                    face *f = &tri;
+                    const vector<face_piece>& pieces = faces[j].pieces;
+                    if (mode == 0) {
+                        if (pieces.empty()) {
+                            raster_colored_triangle(&o->ndc_vertices[f->v1],
+                                    &o->ndc_vertices[f->v2],
+                                    &o->ndc_vertices[f->v3],
+                                    faces[j].colors[0], faces[j].colors[1],
+                                    faces[j].colors[2], fb, bounds);
+                        }
+                        for (const face_piece& piece : pieces) {
+                            raster_colored_piece(piece, faces[j].colors, fb,
+                                    bounds);
+                        }
+                    } else if (mode == 1) {
+                        if (pieces.empty()) {
+                            phong_shading(f, o, s, fb, bounds);
+                        }
+                        for (const face_piece& piece : pieces) {
+                            phong_shading(f, o, piece, s, fb, bounds);
+                        }
+                    } else {
+                        if (pieces.empty()) {
+                            deferred_phong_shading(f, o,
+                                    faces[j].object_index, gbuf, fb, bounds);
+                        }
+                        for (const face_piece& piece : pieces) {
+                            deferred_phong_shading(f, o, piece,
+                                    faces[j].object_index, gbuf, fb, bounds);
+                        }
+                    }
+                    hiz.update(region);
+                }
+            }
+        }
+    });
+
+    /*
+     * PHASE 3: For deferred shading, the G-buffer now holds the visible point
+     * of every pixel, so the tiles are lit in parallel, once per pixel.
+     */
+    if (deferred) {
+        light_array lights;
+        build_light_array(s, lights);
+        light_precision precision =
+            (mode == 3) ? fast_lighting : exact_lighting;
+
+        next_tile = 0;
+        run_in_parallel(thread_count, [&](unsigned int) {
+            for (unsigned int i = next_tile++; i < tile_count;
+                    i = next_tile++) {
+                deferred_lighting(gbuf, s, lights, precision, fb,
+                        get_tile(i));
+            }
+        });
+    }
+}
+
+/*
+ * The indices of the faces that were bounded, in the order they're drawn.
+ */
+static vector<unsigned int> bounded_faces(const prepared_scene& prepared) {
+    vector<unsigned int> indices;
+    for (size_t i = 0; i < prepared.faces.size(); i++) {
+        if (prepared.faces[i].binned)
+            indices.push_back(i);
+    }
+    return indices;
+}
+
+void render_scene(scene *s, framebuffer& fb, int mode,
+        unsigned int thread_count) {
+    if (thread_count == 0)
+        thread_count = thread::hardware_concurrency();
+    if (thread_count == 0)
+        thread_count = 1;
+
+    prepared_scene prepared;
+    prepare_scene(s, fb.xres, fb.yres, mode, thread_count, prepared);
+    render_band(s, prepared, bounded_faces(prepared), fb, mode, thread_count);
+}
+
+void render_scene_banded(scene *s, int xres, int yres, int band_height,
+        int mode, unsigned int thread_count, image_writer& writer) {
+    if (thread_count == 0)
+        thread_count = thread::hardware_concurrency();
+    if (thread_count == 0)
+        thread_count = 1;
+    // Bands are a whole number of tiles high
+    band_height = max(tile_size, (band_height + tile_size - 1) / tile_size
+            * tile_size);
+
+    prepared_scene prepared;
+    prepare_scene(s, xres, yres, mode, thread_count, prepared);
+
+    // Bucket the faces by the bands they overlap, counting bands up from the
+    // bottom of the screen like the tiles
+    int band_count = (yres + band_height - 1) / band_height;
+    vector<vector<unsigned int> > bands(band_count);
+    for (unsigned int i : bounded_faces(prepared)) {
+        const tile& bounds = prepared.faces[i].bounds;
+        for (int band = bounds.y_min / band_height;
+                band <= bounds.y_max / band_height; band++) {
+            bands[band].push_back(i);
+        }
+    }
+
+    // The image is written from the top down
+    vector<unsigned char> rgb;
+    for (int band = band_count - 1; band >= 0; band--) {
+        int y_min = band * band_height;
+        int rows = min(band_height, yres - y_min);
+        framebuffer fb(xres, rows, y_min);
+        render_band(s, prepared, bands[band], fb, mode, thread_count);
+        // The band's faces aren't needed again
+        vector<unsigned int>().swap(bands[band]);
+        fb.resolve(rgb);
+        writer.write_rows(rgb.data(), rows);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "draw.h"
+#include "image_writer.h"
+
+using namespace std;
+
+// Side length of the square screen tiles faces are binned into
+static const int tile_size = 64;
+
+/*******************************************************************************
+ * Defines the multithreaded rendering pipeline. Faces are first clipped and
+ * bounded in parallel, then binned into the screen tiles they overlap in
+ * parallel, and then the tiles are rasterized and shaded in parallel. Each
+ * tile only ever writes its own pixels, and draws its faces in the same order,
+ * so the image is the same no matter how many threads render it. Objects are
+ * drawn roughly front to back, and a coarse depth buffer per tile lets hidden
+ * objects and faces be skipped before they are rasterized.
+ *
+ * An image too large to hold in memory can be rendered in bands of rows
+ * instead. The faces are bucketed by the bands they overlap, and each band is
+ * then rendered like a whole image and written out before the next one is
+ * started, so only a band's worth of pixels is ever in memory. Bands are a
+ * whole number of tiles high, so the image comes out the same as it would
+ * rendered all at once.
+ ******************************************************************************/
+
+// mode is 0 for Gouraud shading, 1 for Phong shading, and 2 for deferred Phong
+// shading, which only lights each visible pixel once. Mode 3 is deferred Phong
+// shading with a faster approximation of the specular term. A thread_count of
+// 0 uses every core
+void render_scene(scene *s, framebuffer& fb, int mode,
+        unsigned int thread_count);
+// Renders an image of the given resolution band_height rows at a time (rounded
+// up to whole tiles), writing the bands to writer from the top down
+void render_scene_banded(scene *s, int xres, int yres, int band_height,
+        int mode, unsigned int thread_count, image_writer& writer);
+
+#endif
@@ -6,18 +6,78 @@
 #include "parser.h"
 #include "transformer.h"
 #include "draw.h"
+#include "pipeline.h"
+#include "image_writer.h"
+#include "image_sequence.h"
+#include "camera_path.h"
 
 using Eigen::MatrixXd;
 using namespace std;
 
+/*
+ * Builds the camera transform of a camera path's pose the way the scene
+ * file's camera is read.
+ */
+static affine_transform<double> place_camera(const camera_pose& pose) {
+    vertex position(pose.x, pose.y, pose.z);
+    orientation orient(pose.axis_x, pose.axis_y, pose.axis_z, pose.angle);
+    return get_camera_transform_matrix(position, orient);
+}
+
+/*
+ * Renders a frame of the scene for each camera on a camera path, writing them
+ * out as numbered images. The objects' world coordinates and normals don't
+ * depend on the camera, so they were transformed once, and each frame only
+ * transforms the objects to NDC and renders them again, into the same
+ * framebuffer, while the frame before is written out.
+ */
+static bool write_animation(scene *s, int xres, int yres, int mode,
+        unsigned int thread_count, image_format format, const char *path,
+        const char *prefix) {
+    vector<affine_transform<double> > cameras;
+    if (!read_camera_path(path, get_camera_transform_matrix(s->position,
+                    s->orient), place_camera, cameras))
+        return false;
+
+    image_sequence_writer frames(prefix, xres, yres, format);
+    framebuffer fb(xres, yres);
+    vector<unsigned char> rgb;
+    for (const affine_transform<double>& camera : cameras) {
+        set_camera_transform(s, camera);
+        for (object *o : s->objects) {
+            transform_object_to_ndc(o, s, xres, yres);
+        }
+        fb.clear();
+        if (mode >= 0 && mode <= 3)
+            render_scene(s, fb, mode, thread_count);
+        fb.resolve(rgb);
+        if (!frames.write_frame(rgb))
+            return false;
+    }
+    return frames.finish();
+}
+
 int main(int argc, const char* argv[]) {
-    // Should be 4 arguments: the scene description file, xres, yres, and mode
-    assert (argc == 5);
+    // Should be 4 arguments: the scene description file, xres, yres, and mode,
+    // optionally followed by the number of threads to render with, the image
+    // format to output (p3, p6 or png), and the number of rows to render at a
+    // time (0, the default, for all of them). Those can be followed by a
+    // camera path and a filename prefix to render an animation instead (see
+    // camera_path.h), whose frames are rendered whole
+    assert ((argc >= 5 && argc <= 8) || argc == 10);
 
     ifstream infile(argv[1]);
     int xres = atoi(argv[2]);
     int yres = atoi(argv[3]);
     int mode = atoi(argv[4]);
+    // Default to every core
+    unsigned int thread_count = (argc >= 6) ? atoi(argv[5]) : 0;
+    image_format format = P6_IMAGE;
+    if (argc >= 7 && !parse_image_format(argv[6], format)) {
+        fprintf(stderr, "shaded ERROR unknown image format %s\n", argv[6]);
+        return 1;
+    }
+    int band_height = (argc >= 8) ? atoi(argv[7]) : 0;
 
     /* PART 1: Parse the scene description file */
     scene *s = parse_scene(infile);
@@ -26,8 +86,7 @@ int main(int argc, const char* argv[]) {
      * PART 2: Create transformation matrices, and apply geometric
      * transformations to each object-copy's vertices.
      */
-    s->pp_mat = get_perspective_projection_matrix(s);
-    s->world_to_cam_mat = get_world_transform_matrix(s->position, s->orient);
+    set_camera_matrices(s);
     for (object *o : s->objects) {
         transform_object_geom(o);
     }
@@ -42,49 +101,47 @@ int main(int argc, const char* argv[]) {
         normalize_normals(o);
     }
 
+    if (argc == 10)
+        return write_animation(s, xres, yres, mode, thread_count, format,
+                argv[8], argv[9]) ? 0 : 1;
+
+    /*
+     * Transform each object-copy's vertices to NDC and screen space once, so
+     * the faces sharing a vertex don't each transform it again.
+     */
+    for (object *o : s->objects) {
+        transform_object_to_ndc(o, s, xres, yres);
+    }
+
     /*
      * PART 4: Implement the light algorithm. Don't forget attenuation.
      * Remember that the same vertex on two different faces can have a different
-     * normal. So we will store the colors for vertices in the face struct.
+     * normal. So we will store the colors for the vertices of each face.
      */
     /*
      * PART 5: Implement the algorithm for rasterizing colored triangles with
      * interpoloation via barycentric coordinates, backface culling, and
      * depth buffering.
      */
-    MatrixColor grid(yres, xres);
-    // Initialize colors to black
-    for (int y = 0; y < yres; y++) {
-        for (int x = 0; x < xres; x++) {
-            grid(y, x) = color(0, 0, 0);
-        }
-    }
-    MatrixXd depth_buffer(yres, xres);
-    // Initialize all depths to very high value
-    for (int y = 0; y < yres; y++) {
-        for (int x = 0; x < xres; x++) {
-            depth_buffer(y, x) = DBL_MAX;
-        }
+    // A large image is rendered a band at a time, each band written to stdout
+    // once it's done, so the whole image never has to fit in memory
+    if (band_height > 0 && band_height < yres) {
+        image_writer writer(stdout, xres, yres, format);
+        render_scene_banded(s, xres, yres, band_height, mode, thread_count,
+                writer);
+        return writer.finish() ? 0 : 1;
     }
-    s->depth_buffer = depth_buffer;
-    if (mode == 0) {
-        for (object *o : s->objects) {
-            for (face *f : o->faces) {
-                // This takes care of calling the lighting algorithm and the
-                // rasterization algorithm
-                gouraud_shading(f, o, s, grid);
-            }
-        }
-    } else if (mode == 1) {
-        for (object *o : s->objects) {
-            for (face *f : o->faces) {
-                phong_shading(f, o, s, grid, s->depth_buffer);
-            }
-        }
+
+    // Starts out black, and with every depth as far as possible
+    framebuffer fb(xres, yres);
+    if (mode >= 0 && mode <= 3) {
+        // This takes care of calling the lighting algorithm and the
+        // rasterization algorithm for every face, split across threads
+        render_scene(s, fb, mode, thread_count);
     }
 
-    // Create ppm from grid and output it to stdout
-    ppm p = create_ppm(xres, yres, grid);
-    for (string line : p.lines)
-        cout << line << endl;
+    // Output the framebuffer's colors to stdout
+    vector<unsigned char> rgb;
+    fb.resolve(rgb);
+    return write_image(stdout, rgb.data(), xres, yres, format) ? 0 : 1;
 }
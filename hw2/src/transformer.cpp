@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <cmath>
 #include <cassert>
+#include <cfloat>
+#include <algorithm>
 #include "transformer.h"
 using namespace std;
 
@@ -17,78 +19,54 @@ void map_to_screen_coords(vertex *v, int xres, int yres) {
 }
 
 /*
- * Get a pointer to a vertex transformed by the passed-in matrix.
+ * Applies an affine transformation to the vertices of an object's mesh,
+ * saving the results as the world coordinates of the object's ndc_vertices.
+ * The mesh itself is left as it is.
  */
-vertex *get_transformed_vertex(vertex *v, MatrixXd mat) {
-    vertex *copy = new vertex(*v);
-    transform_vertex(copy, mat);
-    return copy;
-}
-
-/*
- * Applies a transformation (specified by a matrix) to a single vertex.
- */
-void transform_vertex(vertex *v, MatrixXd mat) {
-    assert (v != NULL);
-
-    MatrixXd vec(4,1);
-    vec << v->x, v->y, v->z, 1;
-    MatrixXd t_vec = mat * vec;
-
-    // Adjust the vector back to 3 dimensions, and change the vertex
-    float w = t_vec(3, 0);
-    v->x = t_vec(0,0) / w;
-    v->y = t_vec(1,0) / w;
-    v->z = t_vec(2,0) / w;
-}
-
-/*
- * Applies a transformation (specified by a matrix) to the vertices of an
- * object.
- */
-void transform_vertices(object *o, MatrixXd mat) {
-    for (vertex *v : o->vertices) {
-        if (v == NULL)
-            continue;
-        transform_vertex(v, mat);
+void transform_vertices(object *o, const affine_transform<double>& transform) {
+    const coordinate_arrays& p = o->geometry->positions;
+    o->ndc_vertices.resize(p.x.size());
+    for (int i : p.indices()) {
+        Vector3d world = transform.transform_point(p.x[i], p.y[i], p.z[i]);
+        vertex& transformed = o->ndc_vertices[i];
+        transformed.world_x = world(0);
+        transformed.world_y = world(1);
+        transformed.world_z = world(2);
     }
 }
 
 /*
- * Applies a transformation (specified by a matrix) to a single surface_normal.
+ * Applies a transformation (specified by a 3x3 matrix) to a single
+ * surface_normal.
  */
-void transform_normal(surface_normal *n, MatrixXd mat) {
+void transform_normal(surface_normal *n, const Matrix3d& mat) {
     assert (n != NULL);
 
-    MatrixXd vec(4,1);
-    vec << n->x, n->y, n->z, 1;
-    MatrixXd t_vec = mat * vec;
-    // Adjust the vector back to 3 dimensions, and change the vertex
-    float w = t_vec(3, 0);
-    n->x = t_vec(0,0) / w;
-    n->y = t_vec(1,0) / w;
-    n->z = t_vec(2,0) / w;
+    Vector3d t_vec = mat * Vector3d(n->x, n->y, n->z);
+    n->x = t_vec(0);
+    n->y = t_vec(1);
+    n->z = t_vec(2);
 }
 
 /*
- * Applies a transformation (specified by a matrix) to the normals of an
- * object.
+ * Applies a transformation (specified by a 3x3 matrix) to the normals of an
+ * object's mesh, saving the results in the object's world_normals.
  */
-void transform_normals(object *o, MatrixXd mat) {
-    for (surface_normal *n : o->normals) {
-        if (n == NULL)
-            continue;
-        transform_normal(n, mat);
+void transform_normals(object *o, const Matrix3d& mat) {
+    const coordinate_arrays& n = o->geometry->normals;
+    o->world_normals.resize(n.x.size());
+    for (int i : n.indices()) {
+        o->world_normals[i] = surface_normal(n.x[i], n.y[i], n.z[i]);
+        transform_normal(&o->world_normals[i], mat);
     }
 }
 
 /*
- * Normalizes all the normals of an object. Call this after transforming.
+ * Normalizes all the world normals of an object. Call this after transforming.
  */
 void normalize_normals(object *o) {
-    for (surface_normal *n : o->normals) {
-        if (n == NULL)
-            continue;
+    for (size_t i = 1; i < o->world_normals.size(); i++) {
+        surface_normal *n = &o->world_normals[i];
         float magnitude = sqrt(n->x * n->x + n->y * n->y + n->z * n->z);
         n->x /= magnitude;
         n->y /= magnitude;
@@ -97,46 +75,124 @@ void normalize_normals(object *o) {
 }
 
 /*
- * Transform a vertex from world space to camera space and finally to
- * NDC space.
- *
- * IMPORTANT: Before we apply a transformation, go through and save
- * the world coordinates for each vertex. This is so we can interpolate
- * these coordinates for the Phong shading algorithm.
+ * Tests an object's bounding sphere against the view frustum. Objects outside
+ * it can be skipped entirely, and only the faces of objects crossing its edge
+ * can need clipping. The sphere is centered on the object's bounding box, and
+ * tested in camera space, where the camera looks down the negative z axis.
+ * This reads the world coordinates transform_object_geom saved.
  */
-vertex *world_to_ndc(vertex *v, scene *s) {
-    if (s->world_to_cam_mat.rows() == 0)
-        s->world_to_cam_mat = get_world_transform_matrix(s->position, s->orient);
-    if (s->pp_mat.rows() == 0)
-        s->pp_mat = get_perspective_projection_matrix(s);
-
-    vertex *transformed = get_transformed_vertex(v, s->world_to_cam_mat);
-    transform_vertex(transformed, s->pp_mat);
-    // Save world coords
-    transformed->world_x = v->x;
-    transformed->world_y = v->y;
-    transformed->world_z = v->z;
-    return transformed;
+frustum_test test_object_frustum(object *o, scene *s) {
+    set_camera_matrices(s);
+
+    Vector3d lowest(DBL_MAX, DBL_MAX, DBL_MAX);
+    Vector3d highest(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+    // The 0 index isn't a vertex
+    for (size_t i = 1; i < o->ndc_vertices.size(); i++) {
+        const vertex& v = o->ndc_vertices[i];
+        Vector3d pos(v.world_x, v.world_y, v.world_z);
+        lowest = lowest.cwiseMin(pos);
+        highest = highest.cwiseMax(pos);
+    }
+    if (lowest(0) > highest(0))
+        return outside_frustum;
+
+    Vector3d center = (lowest + highest) / 2;
+    double radius = 0;
+    for (size_t i = 1; i < o->ndc_vertices.size(); i++) {
+        const vertex& v = o->ndc_vertices[i];
+        radius = max(radius,
+                (Vector3d(v.world_x, v.world_y, v.world_z) - center).norm());
+    }
+
+    // The camera transform is rigid, so the radius stays the same
+    Vector3d cam = s->world_to_cam_mat.transform_point(center);
+    double x = cam(0);
+    double y = cam(1);
+    double z = cam(2);
+    double n = s->near;
+    double l = s->left;
+    double r = s->right;
+    double b = s->bottom;
+    double t = s->top;
+    // The signed distance of the center from each plane, positive inside
+    double distances[] = {
+        -z - n,
+        s->far + z,
+        (n * x + l * z) / sqrt(n * n + l * l),
+        -(n * x + r * z) / sqrt(n * n + r * r),
+        (n * y + b * z) / sqrt(n * n + b * b),
+        -(n * y + t * z) / sqrt(n * n + t * t)
+    };
+
+    frustum_test result = inside_frustum;
+    for (double distance : distances) {
+        if (distance < -radius)
+            return outside_frustum;
+        if (distance < radius)
+            result = crosses_frustum;
+    }
+    return result;
 }
 
 /*
- * Transform each surface normal of an object by the correct normal
- * transformation.
+ * Transforms every vertex of an object from the world coordinates
+ * transform_object_geom saved to NDC and screen space at once, storing the
+ * results in the object's ndc_vertices so that faces can index into them
+ * instead of transforming each of their vertices separately. The world
+ * coordinates stay saved for the Phong shading algorithm. Objects outside the
+ * view frustum are left untransformed, and objects crossing its edge also keep
+ * their clip space coordinates, so that their faces can be clipped.
+ */
+void transform_object_to_ndc(object *o, scene *s, int xres, int yres) {
+    set_camera_matrices(s);
+
+    o->visibility = test_object_frustum(o, s);
+    o->clip_vertices.clear();
+    if (o->visibility == outside_frustum)
+        return;
+    bool keep_clip = o->visibility == crosses_frustum;
+
+    // The camera transform is rigid, so there's no need to divide by w
+    // between the two transformations
+    Matrix4d mat = s->pp_mat * s->world_to_cam_mat.matrix();
+
+    if (keep_clip)
+        o->clip_vertices.resize(o->ndc_vertices.size());
+    // The 0 index isn't a vertex
+    for (size_t i = 1; i < o->ndc_vertices.size(); i++) {
+        vertex& transformed = o->ndc_vertices[i];
+        Vector4d t_vec = mat * Vector4d(transformed.world_x,
+                transformed.world_y, transformed.world_z, 1);
+        if (keep_clip) {
+            o->clip_vertices[i] =
+                clip_vertex(t_vec(0), t_vec(1), t_vec(2), t_vec(3));
+        }
+
+        transformed.x = t_vec(0) / t_vec(3);
+        transformed.y = t_vec(1) / t_vec(3);
+        transformed.z = t_vec(2) / t_vec(3);
+        map_to_screen_coords(&transformed, xres, yres);
+    }
+}
+
+/*
+ * Transform each surface normal of an object's mesh by the correct normal
+ * transformation, into the object's world_normals. That's the inverse
+ * transpose of the object's transformation, leaving out translations, which
+ * don't move directions.
  */
 void transform_object_normals(object *o) {
-    MatrixXd m = compute_product(o->normal_transformations);
-    m = m.inverse().transpose();
-    transform_normals(o, m);
+    transform_normals(o, o->transformations.inverse.linear().transpose());
 }
 
 
 /*
  * Applies a geometric transformation on an object given the vector of
- * transformation matrices it has stored.
+ * transformation matrices it has stored, saving the world coordinates of its
+ * vertices in its ndc_vertices.
  */
 void transform_object_geom(object *o) {
-    MatrixXd m = compute_product(o->transformations);
-    transform_vertices(o, m);
+    transform_vertices(o, o->transformations.product);
 }
 
 /*
@@ -148,40 +204,37 @@ void transform_object_geom(object *o) {
  *
  * Note that position and orient are the position and orientation of the camera.
  */
-MatrixXd get_camera_transform_matrix(vertex position, orientation orient) {
-    MatrixXd transl_mat = get_translation_matrix(position.x, position.y,
-            position.z);
-    MatrixXd rot_mat = get_rotation_matrix(orient.x, orient.y,
-            orient.z, orient.angle);
-    vector<MatrixXd> matrices;
-    matrices.push_back(rot_mat);
-    matrices.push_back(transl_mat);
-    MatrixXd cam_transf_mat = compute_product(matrices);
-    return cam_transf_mat;
+affine_transform<double> get_camera_transform_matrix(vertex position,
+        orientation orient) {
+    transform_chain<double> camera;
+    camera.rotate(orient.x, orient.y, orient.z, orient.angle);
+    camera.translate(position.x, position.y, position.z);
+    return camera.product;
 }
 
 /*
  * Calculates and returns the matrix that transforms world coordinates to
  * camera coordinates. To do this, we just need to multiply by the inverse
- * of the camera transform. So this just returns the inverse.
+ * of the camera transform, which is rigid, so it's inverted by transposing
+ * its rotation rather than by a general matrix inverse.
  */
-MatrixXd get_world_transform_matrix(vertex position, orientation orient) {
-    MatrixXd cam_transf_mat = get_camera_transform_matrix(position, orient);
-    return cam_transf_mat.inverse();
+affine_transform<double> get_world_transform_matrix(vertex position,
+        orientation orient) {
+    return rigid_inverse(get_camera_transform_matrix(position, orient));
 }
 
 /*
  * Given a scene, return the perspective projection matrix for that scene as
  * described in the assignment.
  */
-MatrixXd get_perspective_projection_matrix(scene *s) {
+Matrix4d get_perspective_projection_matrix(scene *s) {
     float n = s->near;
     float f = s->far;
     float r = s->right;
     float l = s->left;
     float b = s->bottom;
     float t = s->top;
-    MatrixXd m(4, 4);
+    Matrix4d m;
     m <<
         (2 * n) / (r - l), 0, (r + l) / (r - l), 0,
         0, (2 * n) / (t - b), (t + b) / (t - b), 0,
@@ -189,3 +242,28 @@ MatrixXd get_perspective_projection_matrix(scene *s) {
         0, 0, -1, 0;
     return m;
 }
+
+/*
+ * Computes a scene's world -> camera and perspective projection matrices,
+ * unless that's already been done.
+ */
+void set_camera_matrices(scene *s) {
+    if (s->camera_matrices_set)
+        return;
+    s->world_to_cam_mat = get_world_transform_matrix(s->position, s->orient);
+    s->pp_mat = get_perspective_projection_matrix(s);
+    s->camera_matrices_set = true;
+}
+
+/*
+ * Moves a scene's camera to the one the given camera transform places, for
+ * rendering the frames of an animation. The camera's position is updated too,
+ * since lighting depends on it. The objects need transforming to NDC again
+ * afterwards, but their world coordinates and normals stay as they are.
+ */
+void set_camera_transform(scene *s, const affine_transform<double>& camera) {
+    s->world_to_cam_mat = rigid_inverse(camera);
+    s->pp_mat = get_perspective_projection_matrix(s);
+    s->camera_matrices_set = true;
+    s->position = vertex(camera.m[0][3], camera.m[1][3], camera.m[2][3]);
+}
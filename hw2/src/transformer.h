@@ -4,7 +4,6 @@
 #include "parser.h"
 #include <Eigen/Dense>
 
-using Eigen::MatrixXd;
 using namespace std;
 
 /*******************************************************************************
@@ -13,18 +12,21 @@ using namespace std;
 
 void map_to_screen_coords(vertex *v, int xres, int yres);
 
-vertex *get_transformed_vertex(vertex *v, MatrixXd mat);
-void transform_vertex(vertex *v, MatrixXd mat);
-void transform_vertices(object *o, MatrixXd mat);
-void transform_normals(object *o, MatrixXd mat);
-void transform_normal(object *o, MatrixXd mat);
+void transform_vertices(object *o, const affine_transform<double>& transform);
+void transform_normals(object *o, const Matrix3d& mat);
+void transform_normal(surface_normal *n, const Matrix3d& mat);
 void normalize_normals(object *o);
-vertex *world_to_ndc(vertex *v, scene *s);
+frustum_test test_object_frustum(object *o, scene *s);
+void transform_object_to_ndc(object *o, scene *s, int xres, int yres);
 void transform_object_geom(object *o);
 void transform_object_normals(object *o);
 
-MatrixXd get_camera_transform_matrix(vertex position, orientation orient);
-MatrixXd get_world_transform_matrix(vertex position, orientation orient);
-MatrixXd get_perspective_projection_matrix(scene *s);
+affine_transform<double> get_camera_transform_matrix(vertex position,
+        orientation orient);
+affine_transform<double> get_world_transform_matrix(vertex position,
+        orientation orient);
+Matrix4d get_perspective_projection_matrix(scene *s);
+void set_camera_matrices(scene *s);
+void set_camera_transform(scene *s, const affine_transform<double>& camera);
 
 #endif
@@ -1,6 +1,7 @@
 /*** For parsing graphics files. Contains a lot of copied code from Assignment 0 ***/
 
 #include "parser.h"
+#include "mesh_cache.h"
 #include <stdio.h>
 #include <iostream>
 #include <fstream>
@@ -138,15 +139,19 @@ vector<Object *> parse_objects(ifstream &infile) {
         if (shading_determ.compare("ambient") == 0) {
             (iss >> r >> g >> b);
             object_copy->set_ambient(r, g, b);
+            continue;
         } else if (shading_determ.compare("diffuse") == 0) {
             (iss >> r >> g >> b);
             object_copy->set_diffuse(r, g, b);
+            continue;
         } else if (shading_determ.compare("specular") == 0) {
             (iss >> r >> g >> b);
             object_copy->set_specular(r, g, b);
+            continue;
         } else if (shading_determ.compare("shininess") == 0) {
             (iss >> shine);
             object_copy->shininess = shine;
+            continue;
         }
 
         iss.str(line);
@@ -183,55 +188,25 @@ vector<Object *> parse_objects(ifstream &infile) {
 Object *parse_object(const char *filename) {
     string rel_filename = DATA_DIR;
     rel_filename.append(filename);
-    ifstream infile(rel_filename);
-    string line;
-    string determ;
-    float x, y, z;
-    string mult_x, mult_y, mult_z;
+    // If the file can't be read, the loader says so and the object is empty
+    tri_mesh mesh;
+    load_obj_cached(rel_filename.c_str(), mesh);
     vector<Triple> vertex_buffer;
     vector<Triple> normal_buffer;
-    vector<Triple> unique_vertices;
-    vector<Triple> unique_normals;
-    // Vertices are 1-indexed, so push null for 0th element
-    unique_vertices.push_back(Triple());
-    // Normals are 1-indexed too, so push null for 0th element
-    unique_normals.push_back(Triple());
+    vertex_buffer.reserve(3 * mesh.face_count());
+    normal_buffer.reserve(3 * mesh.face_count());
 
-    // Go through file and read vertices and faces, create structs
-    while (getline(infile, line)) {
-        istringstream iss(line);
-        (iss >> determ);
-        // Create new vertex
-        if (determ.compare("v") == 0) {
-            (iss >> x >> y >> z);
-            Triple v(x, y, z);
-            unique_vertices.push_back(v);
-        } else if (determ.compare("vn") == 0) {
-            (iss >> x >> y >> z);
-            Triple n(x, y, z);
-            unique_normals.push_back(n);
-        } else {
-            (iss >> mult_x >> mult_y >> mult_z);
-            string v1_str = mult_x.substr(0, mult_x.find("//"));
-            string vn1_str = mult_x.substr(mult_x.find("//") + 2);
-            int v1 = stoi(v1_str);
-            int vn1 = stoi(vn1_str);
-            string v2_str = mult_y.substr(0, mult_y.find("//"));
-            string vn2_str = mult_y.substr(mult_y.find("//") + 2);
-            int v2 = stoi(v2_str);
-            int vn2 = stoi(vn2_str);
-            string v3_str = mult_z.substr(0, mult_z.find("//"));
-            string vn3_str = mult_z.substr(mult_z.find("//") + 2);
-            int v3 = stoi(v3_str);
-            int vn3 = stoi(vn3_str);
-            // Push back vertices of the face
-            vertex_buffer.push_back(unique_vertices[v1]);
-            vertex_buffer.push_back(unique_vertices[v2]);
-            vertex_buffer.push_back(unique_vertices[v3]);
-            // Push back normals of the face
-            normal_buffer.push_back(unique_normals[vn1]);
-            normal_buffer.push_back(unique_normals[vn2]);
-            normal_buffer.push_back(unique_normals[vn3]);
+    // Push back the vertices and normals of each face. Corners without a
+    // normal index the mesh's unused normal 0, which is zero
+    const coordinate_arrays& p = mesh.positions;
+    const coordinate_arrays& n = mesh.normals;
+    for (int i = 0; i < mesh.face_count(); i++) {
+        const index_triplet& v = mesh.position_indices[i];
+        const index_triplet& vn = mesh.normal_indices[i];
+        for (int k = 0; k < 3; k++) {
+            vertex_buffer.push_back(Triple(p.x[v[k]], p.y[v[k]], p.z[v[k]]));
+            normal_buffer.push_back(Triple(n.x[vn[k]], n.y[vn[k]],
+                    n.z[vn[k]]));
         }
     }
 
@@ -145,11 +145,10 @@ struct Object
     vector<Vertex> vertex_buffer;
     vector<Vec3f> normal_buffer;
 
-    vector<Face> faces;
-    vector<Face *> face_pointers;
-
-    vector<Vertex> unique_vertices;
-    vector<Vertex *> unique_vertex_pointers;
+    /* The vertices of the object, each stored once, and its faces as
+     * triplets of vertex indices. Both are 1-indexed as in the .obj file.
+     */
+    tri_mesh geometry;
     vector<Vec3f> unique_normals;
 
     vector<Transforms> transform_sets;
@@ -200,7 +199,6 @@ struct Scene {
     float bottom;
     vector<Point_Light> lights;
     vector<Object> objects;
-    vector<Mesh_Data *> meshes;
     vector<vector<HEV *>*> object_hevs;
     vector<vector<HEF *>*> object_hefs;
     int xres;
@@ -225,45 +223,36 @@ struct Scene {
     void update_vertices() {
         for (int i = 0; i < objects.size(); i++) {
             // Clear current vertex buffer
-            vector<Vertex> old_buffer = objects[i].vertex_buffer;
             objects[i].vertex_buffer.clear();
 
             // Calculate new vertices using implicit fairing.
-            VectorXf xh_vec = solve_xh(object_hevs[i], objects[i].unique_vertices);
-            VectorXf yh_vec = solve_yh(object_hevs[i], objects[i].unique_vertices);
-            VectorXf zh_vec = solve_zh(object_hevs[i], objects[i].unique_vertices);
+            coordinate_arrays& vertices = objects[i].geometry.positions;
+            VectorXf xh_vec = solve_xh(object_hevs[i], vertices.x);
+            VectorXf yh_vec = solve_yh(object_hevs[i], vertices.y);
+            VectorXf zh_vec = solve_zh(object_hevs[i], vertices.z);
 
             // Update vertex buffer based on recalculated vertices.
-            for (int j = 0; j < objects[i].faces.size(); j++) {
-                Face f = objects[i].faces[j];
-                // Make sure to adjust the indices to be 0-indexed for the time
-                // step vectors
-                Vertex new_vertex1(xh_vec(f.idx1 - 1), yh_vec(f.idx1 - 1), zh_vec(f.idx1 - 1));
-                Vertex new_vertex2(xh_vec(f.idx2 - 1), yh_vec(f.idx2 - 1), zh_vec(f.idx2 - 1));
-                Vertex new_vertex3(xh_vec(f.idx3 - 1), yh_vec(f.idx3 - 1), zh_vec(f.idx3 - 1));
-
-                Vertex old_vertex1 = old_buffer[j * 3];
-                objects[i].vertex_buffer.push_back(new_vertex1);
-                objects[i].vertex_buffer.push_back(new_vertex2);
-                objects[i].vertex_buffer.push_back(new_vertex3);
+            for (const index_triplet& f : objects[i].geometry.position_indices) {
+                for (int k = 0; k < 3; k++) {
+                    // Make sure to adjust the indices to be 0-indexed for the
+                    // time step vectors
+                    int j = f[k] - 1;
+                    objects[i].vertex_buffer.push_back(
+                            Vertex(xh_vec(j), yh_vec(j), zh_vec(j)));
+                }
             }
 
-            // Update unique vertices
-            objects[i].unique_vertices.clear();
-            objects[i].unique_vertex_pointers.clear();
-
-            objects[i].unique_vertices.push_back(Vertex());
-            objects[i].unique_vertex_pointers.push_back(NULL);
-            for (int j = 0; j < xh_vec.size(); j++) {
-                Vertex *new_unique_vertex = new Vertex(xh_vec(j), yh_vec(j), zh_vec(j));
-                objects[i].unique_vertices.push_back(*new_unique_vertex);
-                objects[i].unique_vertex_pointers.push_back(new_unique_vertex);
+            // Update unique vertices, which are 1-indexed
+            for (int j : vertices.indices()) {
+                vertices.x[j] = xh_vec(j - 1);
+                vertices.y[j] = yh_vec(j - 1);
+                vertices.z[j] = zh_vec(j - 1);
             }
         }
     }
 
     // Get new z values based on the Scene's time step (smoothed values)
-    Eigen::VectorXf solve_zh(vector<HEV *> *vertices, vector<Vertex> unique_vertices) {
+    Eigen::VectorXf solve_zh(vector<HEV *> *vertices, const vector<float>& zs) {
         // Get our matrix representation of F
         Eigen::SparseMatrix<float> F = build_F_operator(vertices);
 
@@ -276,11 +265,9 @@ struct Scene {
 
         int num_vertices = vertices->size() - 1;
 
-        // Initialize our vector representation of x0's
-        Eigen::VectorXf z0_vector(num_vertices);
-        for (int i = 1; i < vertices->size(); i++) {
-            z0_vector(i - 1) = unique_vertices[i].z;
-        }
+        // Our vector representation of z0's is the mesh's own array of them,
+        // without its unused element 0
+        Eigen::Map<const Eigen::VectorXf> z0_vector(zs.data() + 1, num_vertices);
 
         // Have Eigen solve for our z_h vector
         Eigen::VectorXf zh_vector(num_vertices);
@@ -290,7 +277,7 @@ struct Scene {
     }
 
     // Get new y values based on the Scene's time step (smoothed values)
-    Eigen::VectorXf solve_yh(vector<HEV *> *vertices, vector<Vertex> unique_vertices) {
+    Eigen::VectorXf solve_yh(vector<HEV *> *vertices, const vector<float>& ys) {
         // Get our matrix representation of F
         Eigen::SparseMatrix<float> F = build_F_operator(vertices);
 
@@ -303,11 +290,9 @@ struct Scene {
 
         int num_vertices = vertices->size() - 1;
 
-        // Initialize our vector representation of x0's
-        Eigen::VectorXf y0_vector(num_vertices);
-        for (int i = 1; i < vertices->size(); i++) {
-            y0_vector(i - 1) = unique_vertices[i].y;
-        }
+        // Our vector representation of y0's is the mesh's own array of them,
+        // without its unused element 0
+        Eigen::Map<const Eigen::VectorXf> y0_vector(ys.data() + 1, num_vertices);
 
         // Have Eigen solve for our x_h vector
         Eigen::VectorXf yh_vector(num_vertices);
@@ -317,7 +302,7 @@ struct Scene {
     }
 
     // Get new x values based on the Scene's time step (smoothed values)
-    Eigen::VectorXf solve_xh(vector<HEV *> *vertices, vector<Vertex> unique_vertices) {
+    Eigen::VectorXf solve_xh(vector<HEV *> *vertices, const vector<float>& xs) {
         // Get our matrix representation of F
         Eigen::SparseMatrix<float> F = build_F_operator(vertices);
 
@@ -330,11 +315,9 @@ struct Scene {
 
         int num_vertices = vertices->size() - 1;
 
-        // Initialize our vector representation of x0's
-        Eigen::VectorXf x0_vector(num_vertices);
-        for (int i = 1; i < vertices->size(); i++) {
-            x0_vector(i - 1) = unique_vertices[i].x;
-        }
+        // Our vector representation of x0's is the mesh's own array of them,
+        // without its unused element 0
+        Eigen::Map<const Eigen::VectorXf> x0_vector(xs.data() + 1, num_vertices);
 
         // Have Eigen solve for our x_h vector
         Eigen::VectorXf xh_vector(num_vertices);
@@ -482,16 +465,11 @@ struct Scene {
         object_hevs.clear();
         object_hefs.clear();
 
-        for (Object o : objects) {
-            Mesh_Data *mesh_data = new Mesh_Data;
-            mesh_data->vertices = &o.unique_vertex_pointers;
-            mesh_data->faces = &o.face_pointers;
-
+        for (const Object& o : objects) {
             vector<HEV*> *hevs = new vector<HEV*>();
             vector<HEF*> *hefs = new vector<HEF*>();
 
-            build_HE(mesh_data, hevs, hefs);
-            meshes.push_back(mesh_data);
+            build_HE(&o.geometry, hevs, hefs);
             object_hevs.push_back(hevs);
             object_hefs.push_back(hefs);
         }
@@ -520,11 +498,11 @@ struct Scene {
             // Clear normal buffer before populating
             objects[i].normal_buffer.clear();
 
-            for (Face f : objects[i].faces) {
+            for (const index_triplet& f : objects[i].geometry.position_indices) {
                 // Use same indices as vertices.
-                Vec3f n1 = objects[i].unique_normals[f.idx1];
-                Vec3f n2 = objects[i].unique_normals[f.idx2];
-                Vec3f n3 = objects[i].unique_normals[f.idx3];
+                Vec3f n1 = objects[i].unique_normals[f[0]];
+                Vec3f n2 = objects[i].unique_normals[f[1]];
+                Vec3f n3 = objects[i].unique_normals[f[2]];
                 objects[i].normal_buffer.push_back(n1);
                 objects[i].normal_buffer.push_back(n2);
                 objects[i].normal_buffer.push_back(n3);
@@ -651,8 +629,8 @@ struct Scene {
             }
         }
 
-        cout << "faces size = " << objects[0].faces.size() << endl;
-        cout << "unique_vertices size = " << objects[0].unique_vertices.size() << endl;
+        cout << "faces size = " << objects[0].geometry.face_count() << endl;
+        cout << "unique_vertices size = " << objects[0].geometry.positions.x.size() << endl;
         cout << "unique_normals size = " << objects[0].unique_normals.size() << endl;
         cout << "vertex_buffer size = " << objects[0].vertex_buffer.size() << endl;
         cout << "normal_buffer size = " << objects[0].normal_buffer.size() << endl;
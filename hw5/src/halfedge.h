@@ -14,20 +14,18 @@
  *
  * The main function of interest in this header file is:
  *
- *     build_HE(Mesh_Data *mesh,
+ *     build_HE(const tri_mesh *mesh,
  *              std::vector<HEV*> *hevs,
  *              std::vector<HEF*> *hefs);
  *
  * This function constructs the halfedge data structure and takes in three
  * arguments:
  *
- *     Mesh_Data *mesh is a reference to a Mesh_Data struct that contains
- *      std::vector lists of our vertices and faces. See the struct.h file
- *      to see the code for the Mesh_Data struct. It should be fairly straight-
- *      forward to figure out how to use it based on the code, since the structs
- *      are all very simple. One thing to note is that the first element pushed
- *      onto the vertices vector should be a NULL; this is just filler since
- *      .obj files 1-index vertices.
+ *     const tri_mesh *mesh is a reference to the mesh container the OBJ
+ *      loader reads into, which holds the coordinates of our vertices and the
+ *      vertex indices of our faces. See the common mesh.h file to see the code
+ *      for it. One thing to note is that its vertices are 1-indexed like in
+ *      .obj files, so the face indices can be used as they are.
  *
  *     std::vector<HEV*> *hevs is just a new, empty vector of HEV structs.
  *      This vector is meant to be initialized and populated by our build_HE
@@ -47,15 +45,15 @@
  * The following is a code snippet of how we might build a halfedge using
  * the build_HE function:
  *
- *     Mesh_Data *mesh_data = new Mesh_Data;
- *     parse_OBJ(mesh_data, filename); // your parsing function
+ *     tri_mesh mesh;
+ *     load_obj(filename, mesh);
  *
- *     // at this point, mesh_data contains our vertices and faces for the mesh
+ *     // at this point, mesh contains our vertices and faces for the mesh
  *
  *     std::vector<HEV*> *hevs = new std::vector<HEV*>();
  *     std::vector<HEF*> *hefs = new std::vector<HEF*>();
  *
- *     build_HE(mesh_data, hevs, hefs);
+ *     build_HE(&mesh, hevs, hefs);
  *     // do things with hevs and hefs
  *
  * If the build is successful, then hevs and hefs should contain lists of
@@ -177,7 +175,7 @@ static bool check_face(HEF *face);
 static bool orient_flip_face(HE *edge);
 static bool orient_face(HEF *face);
 
-static bool build_HE(Mesh_Data *mesh,
+static bool build_HE(const tri_mesh *mesh,
                      std::vector<HEV*> *hevs,
                      std::vector<HEF*> *hefs);
 
@@ -289,35 +287,34 @@ static bool orient_face(HEF *face)
            && check_face(face);
 }
 
-static bool build_HE(Mesh_Data *mesh,
+static bool build_HE(const tri_mesh *mesh,
                      std::vector<HEV*> *hevs,
                      std::vector<HEF*> *hefs)
 {
-    std::vector<Vertex*> *vertices = mesh->vertices;
-    std::vector<Face*> *faces = mesh->faces;
+    const coordinate_arrays &vertices = mesh->positions;
 
+    hevs->reserve(vertices.count() + 1);
     hevs->push_back(NULL);
     std::map<std::pair<int, int>, HE*> edge_hash;
 
-    int size_vertices = vertices->size();
-
-    for(int i = 1; i < size_vertices; ++i)
+    for(int i : vertices.indices())
     {
         HEV *hev = new HEV;
-        hev->x = vertices->at(i)->x;
-        hev->y = vertices->at(i)->y;
-        hev->z = vertices->at(i)->z;
+        hev->x = vertices.x[i];
+        hev->y = vertices.y[i];
+        hev->z = vertices.z[i];
         hev->out = NULL;
 
         hevs->push_back(hev);
     }
 
     HEF *first_face = NULL;
-    int num_faces = faces->size();
+    int num_faces = mesh->face_count();
+    hefs->reserve(num_faces);
 
     for (int i = 0; i < num_faces; ++i)
     {
-        Face *f = faces->at(i);
+        const index_triplet &f = mesh->position_indices[i];
 
         HE *e1 = new HE;
         HE *e2 = new HE;
@@ -340,17 +337,17 @@ static bool build_HE(Mesh_Data *mesh,
         e2->next = e3;
         e3->next = e1;
 
-        e1->vertex = hevs->at(f->idx1);
-        e2->vertex = hevs->at(f->idx2);
-        e3->vertex = hevs->at(f->idx3);
+        e1->vertex = hevs->at(f[0]);
+        e2->vertex = hevs->at(f[1]);
+        e3->vertex = hevs->at(f[2]);
 
-        hevs->at(f->idx1)->out = e1;
-        hevs->at(f->idx2)->out = e2;
-        hevs->at(f->idx3)->out = e3;
+        hevs->at(f[0])->out = e1;
+        hevs->at(f[1])->out = e2;
+        hevs->at(f[2])->out = e3;
 
-        hash_edge(edge_hash, get_edge_key(f->idx1, f->idx2), e1);
-        hash_edge(edge_hash, get_edge_key(f->idx2, f->idx3), e2);
-        hash_edge(edge_hash, get_edge_key(f->idx3, f->idx1), e3);
+        hash_edge(edge_hash, get_edge_key(f[0], f[1]), e1);
+        hash_edge(edge_hash, get_edge_key(f[1], f[2]), e2);
+        hash_edge(edge_hash, get_edge_key(f[2], f[0]), e3);
 
         hefs->push_back(hef);
 
@@ -1,6 +1,7 @@
 /*** For parsing graphics files. Contains a lot of copied code from Assignment 0 ***/
 
 #include "parser.h"
+#include "mesh_cache.h"
 #include <stdio.h>
 #include <iostream>
 #include <fstream>
@@ -99,8 +100,8 @@ vector<Object> object_list_converter(vector<Object *> pointer_list) {
 /*
  * Given an input file of the format specified in HW0 Part 3, reads through it
  * and returns a vector of pointers to object structs. Each object struct has a
- * vector of pointers to vertices, a vector of pointers to faces, and a vector
- * of transformation matrices. Each object struct also has a label.
+ * mesh of vertices and faces, and a vector of transformation matrices. Each
+ * object struct also has a label.
  */
 vector<Object *> parse_objects(ifstream &infile) {
     unordered_map<string, Object *> labels_map;
@@ -187,53 +188,19 @@ vector<Object *> parse_objects(ifstream &infile) {
 Object *parse_object(const char *filename) {
     string rel_filename = DATA_DIR;
     rel_filename.append(filename);
-    ifstream infile(rel_filename);
-    string line;
-    string determ;
-    float x, y, z;
-    int idx1, idx2, idx3;
-    string mult_x, mult_y, mult_z;
-    vector<Vertex> vertex_buffer;
-    vector<Vertex> unique_vertices;
-    vector<Vertex *> unique_vertex_pointers;
-    vector<Face> faces;
-    vector<Face *> face_pointers;
-    // Vertices are 1-indexed, so push null for 0th element
-    unique_vertices.push_back(Vertex());
-    unique_vertex_pointers.push_back(NULL);
-
-    // Go through file and read vertices and faces, create structs
-    while (getline(infile, line)) {
-        istringstream iss(line);
-        (iss >> determ);
-        // Create new vertex
-        if (determ.compare("v") == 0) {
-            (iss >> x >> y >> z);
-            Vertex *v = new Vertex(x, y, z);
-            unique_vertices.push_back(*v);
-            unique_vertex_pointers.push_back(v);
-        } else if (determ.compare("f") == 0) {
-            (iss >> idx1 >> idx2 >> idx3);
-            // Push back vertices of the face, and pointers to these vertices
-            vertex_buffer.push_back(unique_vertices[idx1]);
-            vertex_buffer.push_back(unique_vertices[idx2]);
-            vertex_buffer.push_back(unique_vertices[idx3]);
-
-            // Push back the face, and a pointer to the face
-            Face *f = new Face(idx1, idx2, idx3);
-            faces.push_back(*f);
+    // If the file can't be read, the loader says so and the object is empty
+    Object *o = new Object();
+    load_obj_cached(rel_filename.c_str(), o->geometry);
 
-            face_pointers.push_back(f);
+    // Push back the vertices of each face
+    const coordinate_arrays& p = o->geometry.positions;
+    o->vertex_buffer.reserve(3 * o->geometry.face_count());
+    for (const index_triplet& f : o->geometry.position_indices) {
+        for (int k = 0; k < 3; k++) {
+            o->vertex_buffer.push_back(Vertex(p.x[f[k]], p.y[f[k]], p.z[f[k]]));
         }
     }
 
-    Object *o = new Object();
-    o->unique_vertices = unique_vertices;
-    o->vertex_buffer = vertex_buffer;
-    o->faces = faces;
-    o->unique_vertex_pointers = unique_vertex_pointers;
-    o->face_pointers = face_pointers;
-
     return o;
 }
 
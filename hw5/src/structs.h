@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <Eigen/Dense>
+#include "mesh.h"
 
 using namespace Eigen;
 
@@ -24,17 +25,4 @@ struct Vertex
     }
 };
 
-struct Face
-{
-    int idx1, idx2, idx3;
-    Face(float idx1, float idx2, float idx3) : idx1(idx1), idx2(idx2),
-            idx3(idx3) {}
-};
-
-struct Mesh_Data
-{
-    std::vector<Vertex*> *vertices;
-    std::vector<Face*> *faces;
-};
-
 #endif
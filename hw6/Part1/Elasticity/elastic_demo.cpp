@@ -25,6 +25,8 @@
 
 /* Separate header file */
 #include "utils.h"
+/* OBJ loader shared by all the assignments */
+#include "obj_loader.h"
 
 using namespace std;
 using namespace Eigen;
@@ -80,72 +82,58 @@ vector<MatrixXd> restmats;
 /* Parses in an OBJ file and fills vertices, triangles, and restmats above */
 static bool parse_OBJ(std::string file_name)
 {
-    std::string read_line;
-    std::ifstream file_in(file_name.c_str());
+    // The loader prints its own error if the file can't be read
+    tri_mesh mesh;
+    if(!load_obj(file_name.c_str(), mesh))
+        return 0;
 
-    if(file_in.is_open())
+    // Initialize the fields of each vertex and push it into the list
+    for(int i : mesh.positions.indices())
     {
-        while(getline(file_in, read_line))
-        {
-            std::vector<std::string> tokens = split(read_line, ' ');
-
-            if(tokens.size() == 0)
-                continue;
-
-            // Read in vertex, initialize fields, and push into list
-            if(tokens[0].compare("v") == 0)
-            {
-                Vertex v;
-                v.x = stof(tokens[1]);
-                v.y = stof(tokens[2]);
-
-                v.restx = v.x;
-                v.resty = v.y;
-
-                v.vx = 0;
-                v.vy = 0;
-
-                v.fx = 0;
-                v.fy = 0;
-
-                v.mass = 1.0;
-
-                vertices.push_back(v);
-            }
-            // Read in face, initialize fields and corresponding rest matrix,
-            // and push them onto the appropriate lists
-            else if(tokens[0].compare("f") == 0)
-            {
-                Triangle t;
-
-                t.p1 = stoi(split(tokens[1], '/').at(0)) - 1;
-                t.p2 = stoi(split(tokens[2], '/').at(0)) - 1;
-                t.p3 = stoi(split(tokens[3], '/').at(0)) - 1;
-
-                // Don't worry about this matrix; it's needed for the simulation
-                MatrixXd restmat(2,2);
-                restmat << vertices.at(t.p1).restx - vertices.at(t.p3).restx,
-                           vertices.at(t.p2).restx - vertices.at(t.p3).restx,
-                           vertices.at(t.p1).resty - vertices.at(t.p3).resty,
-                           vertices.at(t.p2).resty - vertices.at(t.p3).resty;
-                restmats.push_back(restmat);
-
-                // Also don't worry about the rest area
-                t.restarea = 1.0 / 2.0 * abs(restmat(0,0) * restmat(1,1) -
-                                             restmat(1,0) * restmat(0,1));
-
-                triangles.push_back(t);
-            }
-        }
-
-        file_in.close();
-        return 1;
+        Vertex v;
+        v.x = mesh.positions.x[i];
+        v.y = mesh.positions.y[i];
+
+        v.restx = v.x;
+        v.resty = v.y;
+
+        v.vx = 0;
+        v.vy = 0;
+
+        v.fx = 0;
+        v.fy = 0;
+
+        v.mass = 1.0;
+
+        vertices.push_back(v);
     }
-    else
+
+    // Initialize the fields of each face and its corresponding rest matrix,
+    // and push them onto the appropriate lists
+    for(const index_triplet &indices : mesh.position_indices)
     {
-        std::cerr << "ERROR: Cannot find specified input file: " << file_name << "!\n";
-        return 0;
+        Triangle t;
+
+        t.p1 = indices[0] - 1;
+        t.p2 = indices[1] - 1;
+        t.p3 = indices[2] - 1;
+
+        // Don't worry about this matrix; it's needed for the simulation
+        MatrixXd restmat(2,2);
+        restmat << vertices.at(t.p1).restx - vertices.at(t.p3).restx,
+                   vertices.at(t.p2).restx - vertices.at(t.p3).restx,
+                   vertices.at(t.p1).resty - vertices.at(t.p3).resty,
+                   vertices.at(t.p2).resty - vertices.at(t.p3).resty;
+        restmats.push_back(restmat);
+
+        // Also don't worry about the rest area
+        t.restarea = 1.0 / 2.0 * abs(restmat(0,0) * restmat(1,1) -
+                                     restmat(1,0) * restmat(0,1));
+
+        triangles.push_back(t);
     }
+
+    return 1;
 }
 
 void init(void)
@@ -5,6 +5,7 @@
 #include <cassert>
 #include <string>
 #include "parser.h"
+#include "obj_loader.h"
 
 using namespace std;
 
@@ -17,27 +18,19 @@ const int NUM_FILES = 5;
 /*
  * Parse the passed-in file into a Keyframe struct.
  */
-Keyframe parse_frame(ifstream &infile, int frame_num) {
-    string line;
+Keyframe parse_frame(const char *filename, int frame_num) {
+    tri_mesh mesh;
+    bool loaded = load_obj(filename, mesh);
+    assert (loaded);
+
     vector<Vec3f> vertices;
     vector<Vec3f> faces;
-    float x, y, z;
-    char label;
-
-    while (getline(infile, line)) {
-        istringstream iss(line);
-
-        (iss >> label >> x >> y >> z);
-
-        assert (label == 'v' || label == 'f');
-
-        Vec3f triple(x, y, z);
-
-        if (label == 'v') {
-            vertices.push_back(triple);
-        } else if (label == 'f') {
-            faces.push_back(triple);
-        }
+    const coordinate_arrays& p = mesh.positions;
+    for (int i : p.indices()) {
+        vertices.push_back(Vec3f(p.x[i], p.y[i], p.z[i]));
+    }
+    for (const index_triplet& f : mesh.position_indices) {
+        faces.push_back(Vec3f(f[0], f[1], f[2]));
     }
 
     Keyframe keyframe;
@@ -55,9 +48,8 @@ Animation parse_animation() {
     for (int i = 0; i < NUM_FILES; i++) {
         string filename = directory;
         filename.append(filenames[i]);
-        ifstream infile(filename);
         int frame_num = frame_nums[i];
-        Keyframe frame = parse_frame(infile, frame_num);
+        Keyframe frame = parse_frame(filename.c_str(), frame_num);
         keyframes.push_back(frame);
     }
 
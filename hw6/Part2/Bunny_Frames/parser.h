@@ -61,5 +61,5 @@ struct Animation {
     vector<Keyframe> keyframes;
 };
 
-Keyframe parse_frame(ifstream &infile);
+Keyframe parse_frame(const char *filename, int frame_num);
 Animation parse_animation();
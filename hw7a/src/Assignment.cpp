@@ -9,6 +9,8 @@
 #include <utility>
 #include <cstdlib>
 #include <cmath>
+#include <atomic>
+#include <thread>
 #include "Eigen/Dense"
 
 using namespace std;
@@ -49,20 +51,28 @@ void Assignment::drawIOTest() {
     scene_copy.clear();
     traverseRen(ren, vector<Transformation>(), 0);
 
+    // Lay out the lattice and classify all of it at once
+    vector<float> xs, ys, zs;
     for (int i = -10; i <= 10; i++) {
         for (int j = -10; j <= 10; j++) {
             for (int k = -10; k <= 10; k++) {
-                float x = i * 0.5;
-                float y = j * 0.5;
-                float z = k * 0.5;
-                // Check if point is inside one of the scene's primitives
-                if (isInsidePrm(x, y, z))
-                    drawSphere(1.0, 0, 0, x, y, z); // red
-                else
-                    drawSphere(0, 0, 1.0, x, y, z); // blue
+                xs.push_back(i * 0.5);
+                ys.push_back(j * 0.5);
+                zs.push_back(k * 0.5);
             }
         }
     }
+    vector<unsigned char> inside(xs.size());
+    classifyPoints(cacheIOPrimitives(scene_copy), xs.data(), ys.data(),
+            zs.data(), xs.size(), inside.data());
+
+    for (unsigned int p = 0; p < xs.size(); p++) {
+        // Check if point is inside one of the scene's primitives
+        if (inside[p])
+            drawSphere(1.0, 0, 0, xs[p], ys[p], zs[p]); // red
+        else
+            drawSphere(0, 0, 1.0, xs[p], ys[p], zs[p]); // blue
+    }
 
     glColor3f(wire_col[0], wire_col[1], wire_col[2]);
 }
@@ -119,10 +129,8 @@ void Assignment::traverseObj(Object* obj, int depth) {
         return;
 
     // Iterate thru children
-    const unordered_map<Name, Child, NameHasher>& child_map = obj->getChildren();
-    for (auto it = child_map.begin(); it != child_map.end(); ++it) {
-        Child child = it->second;
-        Renderable *ren = Renderable::get(child.name);
+    for (const Child& child : obj->getChildren()) {
+        Renderable *ren = Renderable::get(child.id);
         traverseRen(ren, child.transformations, depth);
     }
 }
@@ -152,15 +160,13 @@ bool Assignment::isInsidePrm(float i, float j, float k) {
  */
 bool Assignment::isInsidePrm(float i, float j, float k, Primitive* prm,
         vector<Transformation> transformations) {
-    MatrixXf transform = get_inverse_prod(transformations);
-    Vector4f vec(i, j, k, 1);
-    Vector4f transformed = transform * vec;
+    Vector3f transformed = get_transform_chain(transformations).inverse
+        .transform_point(i, j, k);
 
     // Plug transformed vec into inside-outside function
-    float w = transformed(3);
-    float x = transformed(0) / w;
-    float y = transformed(1) / w;
-    float z = transformed(2) / w;
+    float x = transformed(0);
+    float y = transformed(1);
+    float z = transformed(2);
     float e = prm->getExp0();
     float n = prm->getExp1();
     float inside_outside = pow((pow((x * x), 1.0 / e) + pow(y * y, 1.0 / e)), e / n) +
@@ -172,122 +178,155 @@ bool Assignment::isInsidePrm(float i, float j, float k, Primitive* prm,
 }
 
 /*
- * Transforms a vector.
+ * Keeps the top three rows of the inverse transformation and precomputes the
+ * exponents of the inside-outside function.
  */
-Vector3f transform_vector(Vector3f v, MatrixXf transform) {
-    Vector4f v1(v(0), v(1), v(2), 1);
-    Vector4f v_t = transform * v1;
-    Vector3f v_f;
-    v_f(0) = v_t(0) / v_t(3);
-    v_f(1) = v_t(1) / v_t(3);
-    v_f(2) = v_t(2) / v_t(3);
-    return v_f;
+IOPrimitive makeIOPrimitive(const Primitive* prm,
+        const affine_transform<float>& inverse) {
+    IOPrimitive io_prm;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 4; col++) {
+            io_prm.inv[4 * row + col] = inverse.m[row][col];
+        }
+    }
+    float e = prm->getExp0();
+    float n = prm->getExp1();
+    io_prm.inv_e = 1.0 / e;
+    io_prm.e_over_n = e / n;
+    io_prm.inv_n = 1.0 / n;
+    return io_prm;
 }
 
 /*
- * Get product of passed-in transformations. Compute product in reverse order;
- * that is, if vector is ABC, compute product CBA.
+ * Caches the inverse transformation and inside-outside exponents of each
+ * primitive so that classifyPoints never rebuilds them per point.
  */
-MatrixXf get_matrix_prod(vector<Transformation> transformations) {
-    MatrixXf prod = MatrixXf::Identity(4, 4);
-    MatrixXf curr_mat;
-    for (int i = (int) transformations.size() - 1; i >= 0; i--) {
-        curr_mat = get_matrix(transformations[i]);
-        prod = prod * curr_mat;
+vector<IOPrimitive> Assignment::cacheIOPrimitives(
+        const vector<pair<Primitive*, vector<Transformation>>>& prms) {
+    vector<IOPrimitive> io_prms(prms.size());
+    for (unsigned int p = 0; p < prms.size(); p++) {
+        io_prms[p] = makeIOPrimitive(prms[p].first,
+                get_transform_chain(prms[p].second).inverse);
     }
-
-    return prod;
+    return io_prms;
 }
 
 /*
- * Get inverse product of passed-in transformations.
+ * Classifies the points [begin, end) which must span at most io_chunk_size
+ * points. Each primitive first transforms the whole chunk, then drops every
+ * point outside the unit cube (which contains every superquadric) before the
+ * expensive inside-outside function is evaluated on what is left. At -O3 the
+ * compiler vectorizes the transform loop; the powf calls stay scalar.
  */
-MatrixXf get_inverse_prod(vector<Transformation> transformations,
-        bool exclude_translation) {
-    MatrixXf prod = MatrixXf::Identity(4, 4);
-    MatrixXf curr_mat;
-    for (int i = 0; i < (int) transformations.size(); i++) {
-        if (exclude_translation && transformations[i].type == TRANS)
-            continue;
-        curr_mat = get_matrix(transformations[i]);
-        curr_mat = curr_mat.inverse();
-        prod = prod * curr_mat;
-    }
+static void classifyChunk(const vector<IOPrimitive>& prms,
+        const float* xs, const float* ys, const float* zs,
+        unsigned int begin, unsigned int end, unsigned char* inside,
+        int* containing) {
+    float tx[io_chunk_size];
+    float ty[io_chunk_size];
+    float tz[io_chunk_size];
+    int found[io_chunk_size];
+    unsigned int candidates[io_chunk_size];
+
+    unsigned int count = end - begin;
+    const float* x = xs + begin;
+    const float* y = ys + begin;
+    const float* z = zs + begin;
+    for (unsigned int i = 0; i < count; i++)
+        found[i] = io_no_primitive;
+
+    unsigned int remaining = count;
+    for (unsigned int p = 0; p < prms.size() && remaining > 0; p++) {
+        const IOPrimitive& prm = prms[p];
+        const float* m = prm.inv;
+
+        for (unsigned int i = 0; i < count; i++) {
+            tx[i] = m[0] * x[i] + m[1] * y[i] + m[2] * z[i] + m[3];
+            ty[i] = m[4] * x[i] + m[5] * y[i] + m[6] * z[i] + m[7];
+            tz[i] = m[8] * x[i] + m[9] * y[i] + m[10] * z[i] + m[11];
+        }
 
-    return prod;
-}
+        // A coordinate of magnitude 1 or more makes its term at least 1
+        unsigned int candidate_count = 0;
+        for (unsigned int i = 0; i < count; i++) {
+            candidates[candidate_count] = i;
+            candidate_count += (found[i] == io_no_primitive &&
+                    fabsf(tx[i]) < 1.0 && fabsf(ty[i]) < 1.0 &&
+                    fabsf(tz[i]) < 1.0);
+        }
 
-/*
- * From character determ, determines which matrix (of translation/scaling/rotation)
- * to get, and returns it.
- */
-MatrixXf get_matrix(Transformation transf) {
-    TransformationType type = transf.type;
-    float x = transf.trans(0);
-    float y = transf.trans(1);
-    float z = transf.trans(2);
-    float angle = transf.trans(3);
-    if (type == TRANS) {
-        // Translation matrix
-        return get_translation_matrix(x, y, z);
-    } else if (type == SCALE) {
-        // Scaling matrix
-        return get_scaling_matrix(x, y, z);
-    } else if (type == ROTATE) {
-        // Rotation matrix
-        return get_rotation_matrix(x, y, z, angle);
-    } else {
-        cout << "Invalid argument, exiting" << endl;
-        exit(EXIT_FAILURE);
+        for (unsigned int c = 0; c < candidate_count; c++) {
+            unsigned int i = candidates[c];
+            float inside_outside =
+                insideOutside(prm, tx[i], ty[i], tz[i]) - 1.0;
+            if (inside_outside < 0) {
+                found[i] = p;
+                remaining--;
+            }
+        }
     }
-}
 
-/*
- * Creates the translation matrix corresponding to the (x, y, z) vector and
- * returns it.
- */
-MatrixXf get_translation_matrix(float x, float y, float z) {
-    MatrixXf m(4,4);
-    m << 1, 0, 0, x,
-      0, 1, 0, y,
-      0, 0, 1, z,
-      0, 0, 0, 1;
-    return m;
+    for (unsigned int i = 0; i < count; i++) {
+        if (inside)
+            inside[begin + i] = (found[i] != io_no_primitive);
+        if (containing)
+            containing[begin + i] = found[i];
+    }
 }
 
 /*
- * Creates the scaling matrix corresponding to the (x, y, z) vector and
- * returns it.
+ * Checks which of the passed-in points lie inside of the cached primitives.
+ * Chunks of points are handed out to as many threads as the machine has.
  */
-MatrixXf get_scaling_matrix(float x, float y, float z) {
-    MatrixXf m(4,4);
-    m << x, 0, 0, 0,
-      0, y, 0, 0,
-      0, 0, z, 0,
-      0, 0, 0, 1;
-    return m;
+void Assignment::classifyPoints(const vector<IOPrimitive>& prms,
+        const float* xs, const float* ys, const float* zs,
+        unsigned int count, unsigned char* inside, int* containing) {
+    unsigned int chunk_count = (count + io_chunk_size - 1) / io_chunk_size;
+    unsigned int thread_count = thread::hardware_concurrency();
+    thread_count = max(1u, min(thread_count, chunk_count));
+
+    atomic<unsigned int> next_chunk(0);
+    auto classify = [&]() {
+        unsigned int chunk;
+        while ((chunk = next_chunk++) < chunk_count) {
+            unsigned int begin = chunk * io_chunk_size;
+            unsigned int end = min(count, begin + io_chunk_size);
+            classifyChunk(prms, xs, ys, zs, begin, end, inside, containing);
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned int t = 1; t < thread_count; t++)
+        workers.emplace_back(classify);
+    classify();
+    for (thread& worker : workers)
+        worker.join();
 }
 
 /*
- * Creates the rotation matrix corresponding to the (x, y, z) vector and the
- * passed-in angle and returns it.
+ * Composes the passed-in transformations, the first one applied first, along
+ * with the inverse of their product.
  */
-MatrixXf get_rotation_matrix(float x, float y, float z, float angle) {
-    MatrixXf m(4,4);
-    // Make input vector a unit vector
-    float magnitude = sqrt(x * x + y * y + z * z);
-    x /= magnitude;
-    y /= magnitude;
-    z /= magnitude;
-
-    m << (x * x) + (1 - (x * x)) * cos(angle), (x * y) * (1 - cos(angle)) - z * sin(angle),
-              (x * z) * (1 - cos(angle)) + y * sin(angle), 0,
-      (y * x) * (1 - cos(angle)) + z * sin(angle), (y * y) + (1 - y * y) * cos(angle),
-              (y * z) * (1 - cos(angle)) - x * sin(angle), 0,
-      (z * x) * (1 - cos(angle)) - y * sin(angle), (z * y) * (1 - cos(angle)) + x * sin(angle),
-              (z * z) + (1 - (z * z)) * cos(angle), 0,
-      0, 0, 0, 1;
-    return m;
+transform_chain<float> get_transform_chain(
+        const vector<Transformation>& transformations) {
+    transform_chain<float> chain;
+    for (const Transformation& transf : transformations) {
+        float x = transf.trans(0);
+        float y = transf.trans(1);
+        float z = transf.trans(2);
+        float angle = transf.trans(3);
+        if (transf.type == TRANS) {
+            chain.translate(x, y, z);
+        } else if (transf.type == SCALE) {
+            chain.scale(x, y, z);
+        } else if (transf.type == ROTATE) {
+            chain.rotate(x, y, z, angle);
+        } else {
+            cout << "Invalid argument, exiting" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    return chain;
 }
 
 /*
@@ -362,8 +401,7 @@ Vector3f Assignment::getNormal(Vector3f u_point, Primitive* prm,
  */
 Vector3f Assignment::transformIntersection(Vector3f u_point,
         vector<Transformation> transformations) {
-    MatrixXf transform = get_matrix_prod(transformations);
-    return transform_vector(u_point, transform);
+    return get_transform_chain(transformations).product.transform_point(u_point);
 }
 
 /*
@@ -372,21 +410,19 @@ Vector3f Assignment::transformIntersection(Vector3f u_point,
  */
 Vector3f* Assignment::intersectPrm(Camera* camera, Primitive* prm,
         vector<Transformation> transformations) {
-    MatrixXf transform = get_inverse_prod(transformations);
+    affine_transform<float> inverse = get_transform_chain(transformations).inverse;
 
     /* Apply inverse transforms to cam position and direction */
-    Vector3f cam_pos_transformed = transform_vector(camera->getPosition(),
-            transform);
+    Vector3f cam_pos_transformed = inverse.transform_point(camera->getPosition());
 
     Vector3f cam_dir(0.0, 0.0, -1.0);
     Vector3f rotation_axis = camera->getAxis();
     float rotation_angle = camera->getAngle();
-    MatrixXf cam_rotation = get_rotation_matrix(rotation_axis(0), rotation_axis(1),
-            rotation_axis(2), rotation_angle);
-    Vector3f cam_dir_transformed = transform_vector(cam_dir, cam_rotation);
+    Vector3f cam_dir_transformed = rotation_transform(rotation_axis(0),
+            rotation_axis(1), rotation_axis(2), rotation_angle)
+        .transform_direction(cam_dir);
     // Don't apply translations to cam_dir
-    MatrixXf transform_cam = get_inverse_prod(transformations, true);
-    cam_dir_transformed = transform_vector(cam_dir_transformed, transform_cam);
+    cam_dir_transformed = inverse.transform_direction(cam_dir_transformed);
 
     float e = prm->getExp0();
     float n = prm->getExp1();
@@ -510,8 +546,8 @@ int Assignment::closestPointIndex(vector<Vector3f> points,
     for (int i = 0; i < (int) points.size(); i++) {
         // Untransform point because it has had the inverse superquadric transformations
         // applied
-        MatrixXf transform = get_matrix_prod(pairs[i].second);
-        Vector3f point = transform_vector(points[i], transform);
+        Vector3f point = get_transform_chain(pairs[i].second).product
+            .transform_point(points[i]);
         Vector3f diffs = camera->getPosition() - point;
         float dist = diffs.norm();
         if (dist < min_dist) {
@@ -1,10 +1,44 @@
 #ifndef ASSIGNMENT_HPP
 #define ASSIGNMENT_HPP
 
+#include <math.h>
+
 #include "model.hpp"
+#include "transform.h"
 
 class Camera;
 
+// points are handed to each thread in chunks of this size
+static const unsigned int io_chunk_size = 1024;
+// returned by classifyPoints for points outside of every primitive
+static const int io_no_primitive = -1;
+
+/*
+ * A primitive prepared for batched inside-outside tests. The inverse of its
+ * transformations is affine so only its top three rows are kept, and the
+ * exponents of the inside-outside function are precomputed.
+ */
+struct IOPrimitive {
+    float inv[12];
+    float inv_e;
+    float e_over_n;
+    float inv_n;
+};
+
+// prepares prm for inside-outside tests, with inverse taking points from the
+// space they are given in to the primitive's own space
+IOPrimitive makeIOPrimitive(const Primitive* prm,
+        const affine_transform<float>& inverse);
+
+/*
+ * The inside-outside function of prm at the point (x, y, z) of its own space,
+ * plus one. It is below 1 exactly at the points inside the superquadric.
+ */
+inline float insideOutside(const IOPrimitive& prm, float x, float y, float z) {
+    return powf(powf(x * x, prm.inv_e) + powf(y * y, prm.inv_e),
+            prm.e_over_n) + powf(z * z, prm.inv_n);
+}
+
 class Assignment {
     public:
         Assignment() = default;
@@ -18,6 +52,17 @@ class Assignment {
         static bool isInsidePrm(float i, float j, float k, Primitive* prm,
                 vector<Transformation> transformations);
         static bool isInside(float i, float j, float k);
+
+        // batched inside-outside test over points stored as separate x, y and
+        // z arrays. inside (if not NULL) is set to 1 for points inside any of
+        // the primitives, containing (if not NULL) to the index of the first
+        // primitive containing the point or io_no_primitive
+        static vector<IOPrimitive> cacheIOPrimitives(
+                const vector<pair<Primitive*, vector<Transformation>>>& prms);
+        static void classifyPoints(const vector<IOPrimitive>& prms,
+                const float* xs, const float* ys, const float* zs,
+                unsigned int count, unsigned char* inside,
+                int* containing = NULL);
         static void drawSphere(float r, float g, float b, float i, float j, float k);
         static float randFloat(float lo, float hi);
 
@@ -34,13 +79,7 @@ class Assignment {
                 vector<pair<Primitive*, vector<Transformation>>> pairs, Camera* camera);
 };
 
-Vector3f transform_vector(Vector3f v, MatrixXf transform);
-MatrixXf get_matrix_prod(vector<Transformation> transformations);
-MatrixXf get_inverse_prod(vector<Transformation> transformations,
-        bool exclude_translation = false);
-MatrixXf get_matrix(Transformation transf);
-MatrixXf get_translation_matrix(float x, float y, float z);
-MatrixXf get_scaling_matrix(float x, float y, float z);
-MatrixXf get_rotation_matrix(float x, float y, float z, float angle);
+transform_chain<float> get_transform_chain(
+        const vector<Transformation>& transformations);
 
 #endif
@@ -116,7 +116,7 @@ void Renderer::checkUIState() {
     // If we need to rebuild the vertex buffers, do so
     if (ui.rebuild_scene) {
         ui.rebuild_scene = false;
-        scene.update();
+        scene.update(true);
     }
 }
 
@@ -141,8 +141,7 @@ void Renderer::draw(Renderable* ren, int depth) {
  * normals start at the given offset in the respective vertex buffers.
  */
 void Renderer::drawPrimitive(Primitive* prm) {
-    assert(Scene::prm_tessellation_start.find(prm) !=
-        Scene::prm_tessellation_start.end());
+    assert(Scene::prm_tessellation_start[prm->getID()] != no_tessellation);
 
     const RGBf& color = prm->getColor();
     const float ambient = prm->getAmbient();
@@ -164,7 +163,7 @@ void Renderer::drawPrimitive(Primitive* prm) {
     glMaterialfv(GL_FRONT, GL_SPECULAR, specularColor);
     glMaterialf(GL_FRONT, GL_SHININESS, prm->getReflected());
 
-    uint start = Scene::prm_tessellation_start[prm];
+    uint start = Scene::prm_tessellation_start[prm->getID()];
 
     int ures = prm->getPatchX();
     int vres = prm->getPatchY();
@@ -318,15 +317,14 @@ void Renderer::drawObject(Object* obj, int depth) {
         transform(overall_trans.at(i));
     }
 
-    for (auto& child_it : obj->getChildren()) {
+    for (const Child& child : obj->getChildren()) {
         glPushMatrix();
 
-        const vector<Transformation>& child_trans = 
-            child_it.second.transformations;
+        const vector<Transformation>& child_trans = child.transformations;
         for (int i = child_trans.size() - 1; i >= 0; i--) {
             transform(child_trans.at(i));
         }
-        draw(Renderable::get(child_it.second.name), depth + 1);
+        draw(Renderable::get(child.id), depth + 1);
 
         glPopMatrix();
     }
@@ -484,19 +482,27 @@ void Renderer::display() {
     glPushMatrix();
     glMultMatrixf(ui.arcball_object_mat.data());
 
+    // Only copy the buffers over when the scene has been re-tessellated
+    bool upload = scene.buffers_dirty;
+    scene.buffers_dirty = false;
+
     // Bind the first vertex buffer as the active one
     glBindBuffer(GL_ARRAY_BUFFER, vb_objects[0]);
     // Copy the array of vertex values to the buffer
-    glBufferData(GL_ARRAY_BUFFER, scene.vertices.size() * sizeof(Vec3f),
-        scene.vertices.data(), GL_STATIC_DRAW);
+    if (upload) {
+        glBufferData(GL_ARRAY_BUFFER, scene.vertices.size() * sizeof(Vec3f),
+            scene.vertices.data(), GL_STATIC_DRAW);
+    }
     // Set the buffer as a list of groups of 3 floats, and enable it
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(0);
 
     // Do the same for the second buffer, filling it with the normal vectors
     glBindBuffer(GL_ARRAY_BUFFER, vb_objects[1]);
-    glBufferData(GL_ARRAY_BUFFER, scene.normals.size() * sizeof(Vec3f),
-        scene.normals.data(), GL_STATIC_DRAW);
+    if (upload) {
+        glBufferData(GL_ARRAY_BUFFER, scene.normals.size() * sizeof(Vec3f),
+            scene.normals.data(), GL_STATIC_DRAW);
+    }
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(1);
     
@@ -509,8 +515,8 @@ void Renderer::display() {
             drawObject(obj, 1);
         }
     } else {
-        for (auto& prm_it : Scene::prm_tessellation_start) {
-            drawPrimitive(prm_it.first);
+        for (Primitive* prm : Scene::tessellated_prms) {
+            drawPrimitive(prm);
         }
     }
 
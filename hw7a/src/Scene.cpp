@@ -3,12 +3,17 @@
 using namespace std;
 
 vector<Object*> Scene::root_objs;
-unordered_map<Primitive*, unsigned int> Scene::prm_tessellation_start;
+vector<unsigned int> Scene::prm_tessellation_start;
+vector<Primitive*> Scene::tessellated_prms;
 vector<Vector3f> Scene::vertices;
 vector<Vector3f> Scene::normals;
 vector<PointLight> Scene::lights;
 
 bool Scene::needs_update = false;
+bool Scene::buffers_dirty = true;
+unsigned int Scene::last_revision = (unsigned int) -1;
+vector<bool> Scene::obj_tessellated;
+unsigned int Scene::tessellation_size = 0;
 
 /* Constructs a light in our scene. */
 PointLight::PointLight(float *position, float *color, float k) {
@@ -42,21 +47,41 @@ void Scene::createLights() {
 }
 
 /*
- * Adds a vertex and normal to the respective buffers, calculated from a 
- * parametric (u, v) point on a superquadric's surface.
+ * Writes a vertex and normal to the given slot of the respective buffers,
+ * calculated from a parametric (u, v) point on a superquadric's surface.
  */
-void Scene::generateVertex(Primitive *prm, float u, float v) {
-    vertices.push_back(prm->getVertex(u, v));
-    normals.push_back(prm->getNormal(vertices.back()));
+void Scene::generateVertex(Primitive *prm, float u, float v, unsigned int &i) {
+    vertices[i] = prm->getVertex(u, v);
+    normals[i] = prm->getNormal(vertices[i]);
+    i++;
 }
 
-/* Tesselates a primitive, adding the vertices and normals to their buffers. */
-void Scene::tessellatePrimitive(Primitive *prm) {
-    if (prm_tessellation_start.find(prm) != prm_tessellation_start.end()) {
+/* Number of buffer entries tessellatePrimitive writes for a primitive. */
+unsigned int Scene::tessellationSize(const Primitive *prm) {
+    unsigned int ures = prm->getPatchX();
+    unsigned int vres = prm->getPatchY();
+    // vres - 2 strips plus the two polar fans
+    unsigned int strips = (vres > 2) ? (vres - 2) * (2 * ures + 2) : 0;
+    return strips + 2 * (ures + 2);
+}
+
+/*
+ * Reserves a range of the vertex buffers for a primitive. The vertices
+ * themselves are generated later by tessellatePrimitive.
+ */
+void Scene::addPrimitive(Primitive *prm) {
+    if (prm_tessellation_start[prm->getID()] != no_tessellation) {
         return;
     }
 
-    prm_tessellation_start.insert({prm, vertices.size()});
+    prm_tessellation_start[prm->getID()] = tessellation_size;
+    tessellation_size += tessellationSize(prm);
+    tessellated_prms.push_back(prm);
+}
+
+/* Tesselates a primitive, filling in its range of the buffers. */
+void Scene::tessellatePrimitive(Primitive *prm) {
+    unsigned int i = prm_tessellation_start[prm->getID()];
 
     // Less typing, computation at runtime
     int ures = prm->getPatchX();
@@ -73,14 +98,14 @@ void Scene::tessellatePrimitive(Primitive *prm) {
         // point down in order for the right-hand rule to make the normal
         // point out of the primitive
         u = -M_PI;
-        for (int i = 0; i < ures; i++) {
-            generateVertex(prm, u, v + dv);
-            generateVertex(prm, u, v);
+        for (int k = 0; k < ures; k++) {
+            generateVertex(prm, u, v + dv, i);
+            generateVertex(prm, u, v, i);
             u += du;
         }
         // Connect back to the beginning
-        generateVertex(prm, -M_PI, v + dv);
-        generateVertex(prm, -M_PI, v);
+        generateVertex(prm, -M_PI, v + dv, i);
+        generateVertex(prm, -M_PI, v, i);
 
         v += dv;
     }
@@ -89,60 +114,111 @@ void Scene::tessellatePrimitive(Primitive *prm) {
     // with a GL_TRIANGLE_FAN centered on the south pole
     u = M_PI;
     v = dv - half_pi;
-    generateVertex(prm, u, -half_pi);
-    for (int i = 0; i < ures; i++) {
+    generateVertex(prm, u, -half_pi, i);
+    for (int k = 0; k < ures; k++) {
         // U sweeps clockwise to make the normals point out
-        generateVertex(prm, u, v);
+        generateVertex(prm, u, v, i);
         u -= du;
     }
     // Connect back to the beginning
     u = -M_PI;
-    generateVertex(prm, u, v);
+    generateVertex(prm, u, v, i);
 
     // Now we tessellate its top by doing the same at the north pole
     v *= -1;
-    generateVertex(prm, u, half_pi);
-    for (int i = 0; i < ures; i++) {
+    generateVertex(prm, u, half_pi, i);
+    for (int k = 0; k < ures; k++) {
         // U sweeps counterclockwise to make the normals point out
-        generateVertex(prm, u, v);
+        generateVertex(prm, u, v, i);
         u += du;
     }
     // Connect back to the beginning
     u = M_PI;
-    generateVertex(prm, u, v);
+    generateVertex(prm, u, v, i);
+
+    assert(i == prm_tessellation_start[prm->getID()] + tessellationSize(prm));
 }
 
-void Scene::tessellateObject(Object *obj) {
-    for (auto& child_it : obj->getChildren()) {
-        Renderable* ren = Renderable::get(child_it.second.name);
+/*
+ * Gathers every Primitive below an Object. Objects that are instanced several
+ * times in the hierarchy are only walked once.
+ */
+void Scene::addObject(Object *obj) {
+    if (obj_tessellated[obj->getID()]) {
+        return;
+    }
+    obj_tessellated[obj->getID()] = true;
+
+    for (const Child& child : obj->getChildren()) {
+        Renderable* ren = Renderable::get(child.id);
         switch (ren->getType()) {
             case OBJ: {
                 Object* obj = dynamic_cast<Object*>(ren);
-                tessellateObject(obj);
+                addObject(obj);
                 break;
             }
             case PRM: {
                 Primitive* prm = dynamic_cast<Primitive*>(ren);
-                tessellatePrimitive(prm);
+                addPrimitive(prm);
                 break;
             }
             default:
-                fprintf(stderr, "Scene::tessellateObject ERROR invalid Renderable type %s\n",
+                fprintf(stderr, "Scene::addObject ERROR invalid Renderable type %s\n",
                     toCstr(ren->getType()));
                 exit(1);
         }
     }
 }
 
+/*
+ * Tessellates every gathered Primitive. Each one owns a disjoint range of the
+ * buffers so they are split across threads.
+ */
+void Scene::tessellatePrimitives() {
+    vertices.resize(tessellation_size);
+    normals.resize(tessellation_size);
+
+    unsigned int thread_count = thread::hardware_concurrency();
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+    thread_count = min(thread_count, (unsigned int)
+        (tessellated_prms.size() / min_prms_per_thread + 1));
+
+    // interleave the primitives so uneven patch counts even out
+    auto tessellate = [](unsigned int first, unsigned int stride) {
+        for (unsigned int i = first; i < tessellated_prms.size(); i += stride) {
+            tessellatePrimitive(tessellated_prms[i]);
+        }
+    };
+    vector<thread> workers;
+    for (unsigned int t = 1; t < thread_count; t++) {
+        workers.emplace_back(tessellate, t, thread_count);
+    }
+    tessellate(0, thread_count);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
 /*
  * Regenerates the scene's vertex and normal buffers based on currently selected
- * Renderable
+ * Renderable. Nothing is rebuilt unless a command has changed the scene since
+ * the last update or the rebuild is forced.
  */
-void Scene::update() {
+void Scene::update(bool force) {
+    if (!force && last_revision == CommandLine::getRevision()) {
+        return;
+    }
+    last_revision = CommandLine::getRevision();
+    buffers_dirty = true;
+
+    Timer timer;
     root_objs.clear();
-    prm_tessellation_start.clear();
-    vertices.clear();
-    normals.clear();
+    prm_tessellation_start.assign(Renderable::getCount(), no_tessellation);
+    tessellated_prms.clear();
+    tessellation_size = 0;
+    obj_tessellated.assign(Renderable::getCount(), false);
 
     // Add each of the objects, then each of the primitives
     // for (uint i = 0; i < objects.size(); i++)
@@ -155,7 +231,7 @@ void Scene::update() {
             case Commands::primitive_get_cmd_id: {
                 Renderable* ren = Renderable::get(cur_state->tokens[1]);
                 assert(ren->getType() == PRM);
-                tessellatePrimitive(dynamic_cast<Primitive*>(ren));
+                addPrimitive(dynamic_cast<Primitive*>(ren));
                 break;
             }
             case Commands::object_get_cmd_id: {
@@ -172,7 +248,15 @@ void Scene::update() {
     }
 
     for (Object* obj : root_objs) {
-        tessellateObject(obj);
+        addObject(obj);
+    }
+    tessellatePrimitives();
+
+    if (CommandLine::timingEnabled()) {
+        printf("[timing] tessellated %u Primitive(s) into %u vertices in %.3f ms\n",
+            (unsigned int) tessellated_prms.size(),
+            (unsigned int) vertices.size(),
+            timer.elapsedMs());
     }
 }
 
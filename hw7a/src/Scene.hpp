@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <vector>
+#include <thread>
 
 #include <Eigen/Eigen>
 
@@ -53,11 +54,19 @@ struct PointLight {
 //     Object();
 // };
 
+static const unsigned int no_tessellation = (unsigned int) -1;
+// tessellation is only split across threads in chunks at least this large
+static const unsigned int min_prms_per_thread = 64;
+
 class Scene {
     public:
         static vector<Object*> root_objs;
 
-        static unordered_map<Primitive*, unsigned int> prm_tessellation_start;
+        // vertex buffer offset of each tessellated Primitive indexed by
+        // RenderableID (no_tessellation if it isn't part of the scene), and
+        // the tessellated Primitives in buffer order
+        static vector<unsigned int> prm_tessellation_start;
+        static vector<Primitive*> tessellated_prms;
         // static vector<Object> objects;
         static vector<PointLight> lights;
 
@@ -68,14 +77,28 @@ class Scene {
         static void createLights();
         static int getLightCount();
 
-        static void update();
+        // set whenever the vertex and normal buffers are rebuilt so the
+        // renderer knows to upload them again
+        static bool buffers_dirty;
+
+        static void update(bool force = false);
 
     private:
         static bool needs_update;
-
-        static void generateVertex(Primitive *prm, float u, float v);
+        static unsigned int last_revision;
+        static vector<bool> obj_tessellated;
+        static unsigned int tessellation_size;
+
+        static void generateVertex(
+            Primitive *prm,
+            float u,
+            float v,
+            unsigned int &i);
+        static unsigned int tessellationSize(const Primitive *prm);
+        static void addPrimitive(Primitive *prm);
+        static void addObject(Object *obj);
         static void tessellatePrimitive(Primitive *prm);
-        static void tessellateObject(Object *obj);
+        static void tessellatePrimitives();
         // static void setupObject(Object *object);
 };
 
@@ -2,14 +2,22 @@
 
 /*********************************** Line *************************************/
 
-Line::Line(char* argv) : untokenized_argv(), argv(), tokens() {
-    assert(strlen(argv) <= cmd_line_buffer_len);
+Line::Line(const char* argv) : untokenized_argv(), argv(), tokens() {
+    this->reset(argv);
+}
+Line::~Line() {
+
+}
+
+void Line::reset(const char* argv) {
+    assert(strlen(argv) < cmd_line_buffer_len);
 
     // set argv
     strcpy(this->untokenized_argv, argv);
     strcpy(this->argv, argv);
     
     // set tokens
+    this->tokens.clear();
     char* tok = strtok(this->argv, " ");
     assert(tok != NULL);
     while (tok) {
@@ -17,9 +25,6 @@ Line::Line(char* argv) : untokenized_argv(), argv(), tokens() {
         tok = strtok(NULL, " ");
     }
 }
-Line::~Line() {
-
-}
 
 const int Line::toCommandID() const {
     // take first arg as the command name
@@ -74,11 +79,25 @@ const Command& Line::toCommand() const {
 
 CommandLine* CommandLine::cmd_line = NULL;
 
-CommandLine::CommandLine() : running(true), state(), history() {
+CommandLine::CommandLine() :
+    running(true),
+    timing(false),
+    state(),
+    history(),
+    scratch_lines(),
+    read_depth(0),
+    revision(0)
+{
 
 }
 CommandLine::~CommandLine() {
-
+    while (this->state.size() > 0) {
+        delete this->state.top();
+        this->state.pop();
+    }
+    for (Line* line : this->scratch_lines) {
+        delete line;
+    }
 }
 
 void CommandLine::init() {
@@ -134,11 +153,13 @@ const Line* CommandLine::getState() {
 
 void CommandLine::clearState() {
     if (cmd_line->state.size() > 0) {
+        delete cmd_line->state.top();
         cmd_line->state.pop();
+        cmd_line->revision++;
     }
 }
 
-const vector<const Line*>& CommandLine::getHistory() {
+const vector<char>& CommandLine::getHistory() {
     if (cmd_line) {
         return cmd_line->history;
     }
@@ -149,6 +170,24 @@ const vector<const Line*>& CommandLine::getHistory() {
 void CommandLine::clearHistory() {
     if (cmd_line) {
         cmd_line->history.clear();
+        cmd_line->revision++;
+    }
+}
+
+unsigned int CommandLine::getRevision() {
+    if (cmd_line) {
+        return cmd_line->revision;
+    }
+    fprintf(stderr, "ERROR CommandLine::instance CommandLine has not been initialized yet\n");
+    exit(1);
+}
+
+bool CommandLine::timingEnabled() {
+    return cmd_line && cmd_line->timing;
+}
+void CommandLine::setTiming(bool timing) {
+    if (cmd_line) {
+        cmd_line->timing = timing;
     }
 }
 
@@ -182,28 +221,50 @@ void CommandLine::readLine(istream& input) {
             new_line_buffer + line_begin,
             line_end - line_begin + 1);
 
-        // setup a new Line instance
-        Line* new_line = new Line(trimmed_new_line_buffer);
+        // reuse the scratch Line for this level of sourcing. only state
+        // impacting commands need a Line of their own since the state keeps it
+        if (cmd_line->scratch_lines.size() <= cmd_line->read_depth) {
+            cmd_line->scratch_lines.push_back(
+                new Line(trimmed_new_line_buffer));
+        } else {
+            cmd_line->scratch_lines[cmd_line->read_depth]->reset(
+                trimmed_new_line_buffer);
+        }
+        Line* new_line = cmd_line->scratch_lines[cmd_line->read_depth];
 
         // if valid execute (invalid commands will return invalid_cmd which has
         // a NULL pointer for action)
         const Command& cmd = new_line->toCommand();
         if (cmd.action) {
             // if cmd is a state impacting command, update state
+            Line* state_line = NULL;
             if (cmd.type == STATE) {
                 clearState();
-                cmd_line->state.push(new_line);
+                state_line = new Line(trimmed_new_line_buffer);
+                cmd_line->state.push(state_line);
+            }
+            Line* action_line = state_line ? state_line : new_line;
+
+            Timer timer;
+            cmd_line->read_depth++;
+            bool success = cmd.action(
+                action_line->tokens.size(), action_line->tokens.data());
+            cmd_line->read_depth--;
+            if (cmd_line->timing) {
+                printf("[timing] %s took %.3f ms\n",
+                    new_line->tokens[0], timer.elapsedMs());
             }
-
-            bool success =
-                cmd.action(new_line->tokens.size(), new_line->tokens.data());
 
             if (success) {
-                cmd_line->history.push_back(new_line);
-            } else {
-                delete new_line;
+                cmd_line->history.insert(cmd_line->history.end(),
+                    new_line->untokenized_argv,
+                    new_line->untokenized_argv +
+                        strlen(new_line->untokenized_argv));
+                cmd_line->history.push_back('\n');
+                cmd_line->revision++;
+            } else if (state_line && getState() == state_line) {
+                clearState();
             }
         }
     }
 }
-
@@ -1,5 +1,8 @@
 #include "commands.hpp"
 #include "command_line.hpp"
+#include "snapshot.hpp"
+#include "stress.hpp"
+#include "mesher.hpp"
 
 /******************************** CommandName *********************************/
 
@@ -221,6 +224,13 @@ bool Commands::source(int argc, char** argv) {
         Renderable::clear();
         CommandLine::clearState();
         CommandLine::clearHistory();
+        Snapshot::clearSceneFromSnapshot();
+
+        // binary snapshots are memory mapped instead of replayed
+        if (argc == 2 && Snapshot::isSnapshotFile(argv[1])) {
+            Snapshot::load(argv[1]);
+            return false;
+        }
 
         ifstream source_file;
 
@@ -246,6 +256,11 @@ bool Commands::source(int argc, char** argv) {
 bool Commands::save(int argc, char** argv) {
     assert(argc == 1 || argc == 2);
 
+    if (argc == 2 && Snapshot::isSnapshotFile(argv[1])) {
+        Snapshot::save(argv[1]);
+        return false;
+    }
+
     ofstream savefile;
 
     if (argc == 1) {
@@ -257,12 +272,101 @@ bool Commands::save(int argc, char** argv) {
         savefile.open(filename_buffer);
     }
 
-    for (const auto& line : CommandLine::getHistory()) {
-        savefile << line->untokenized_argv << endl;
+    // a scene loaded from a binary snapshot has no command history behind it
+    // so it is written out from the Renderables themselves
+    if (Snapshot::sceneFromSnapshot()) {
+        Snapshot::writeCommands(savefile);
+    } else {
+        const vector<char>& history = CommandLine::getHistory();
+        savefile.write(history.data(), history.size());
     }
     savefile.close();
     return false;
 }
+bool Commands::timing(int argc, char** argv) {
+    assert(argc == 1 || argc == 2);
+
+    if (argc == 1) {
+        CommandLine::setTiming(!CommandLine::timingEnabled());
+    } else if (strcmp(argv[1], "on") == 0) {
+        CommandLine::setTiming(true);
+    } else if (strcmp(argv[1], "off") == 0) {
+        CommandLine::setTiming(false);
+    } else {
+        fprintf(stderr, "ERROR %s expects 'on' or 'off'\n", argv[0]);
+        return false;
+    }
+    printf("timing %s\n", CommandLine::timingEnabled() ? "on" : "off");
+    return false;
+}
+// parses a strictly positive integer, returns 0 on failure
+static unsigned int parseCount(const char* arg) {
+    char* end;
+    long count = strtol(arg, &end, 10);
+    if (*end != '\0' || count <= 0 || count > (long) stress_max_primitives) {
+        return 0;
+    }
+    return (unsigned int) count;
+}
+bool Commands::stress(int argc, char** argv) {
+    assert(argc == 5 || argc == 6);
+
+    bool generated = false;
+    Timer timer;
+    if (strcmp(argv[1], "grid") == 0 && argc == 6) {
+        unsigned int nx = parseCount(argv[3]);
+        unsigned int ny = parseCount(argv[4]);
+        unsigned int nz = parseCount(argv[5]);
+        if (nx == 0 || ny == 0 || nz == 0) {
+            fprintf(stderr, "ERROR grid dimensions for %s must be positive integers\n",
+                argv[0]);
+            return false;
+        }
+        generated = Stress::generateGrid(argv[2], nx, ny, nz);
+    } else if (strcmp(argv[1], "fractal") == 0 && argc == 5) {
+        unsigned int depth = parseCount(argv[3]);
+        unsigned int branching = parseCount(argv[4]);
+        if (depth == 0 || branching == 0) {
+            fprintf(stderr, "ERROR depth and branching for %s must be positive integers\n",
+                argv[0]);
+            return false;
+        }
+        generated = Stress::generateFractal(argv[2], depth, branching);
+    } else {
+        fprintf(stderr, "ERROR expected '%s grid [name] [nx] [ny] [nz]' or '%s fractal [name] [depth] [branching]'\n",
+            argv[0], argv[0]);
+        return false;
+    }
+
+    if (generated) {
+        printf("generated %s in %.3f ms: ", argv[2], timer.elapsedMs());
+        Stress::printStats(dynamic_cast<Object*>(Renderable::get(argv[2])));
+    }
+    return generated;
+}
+bool Commands::mesh(int argc, char** argv) {
+    assert(argc >= 1 && argc <= 3);
+
+    const Line* cur_state = CommandLine::getState();
+    if (!cur_state) {
+        fprintf(stderr, "ERROR %s requires that you have a Renderable selected\n",
+            argv[0]);
+        return false;
+    }
+
+    unsigned int resolution = default_mesh_resolution;
+    if (argc == 3) {
+        resolution = parseCount(argv[2]);
+        if (resolution == 0) {
+            fprintf(stderr, "ERROR resolution for %s must be a positive integer\n",
+                argv[0]);
+            return false;
+        }
+    }
+    Mesher::meshToObj(cur_state->tokens[1],
+        (argc >= 2) ? argv[1] : default_mesh_dir, resolution);
+    return false;
+}
 // selection and modifications of Renderables
 bool Commands::deselect(int argc, char** argv) {
     assert(argc == 1);
@@ -0,0 +1,40 @@
+#ifndef MESHER_HPP
+#define MESHER_HPP
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "model.hpp"
+
+using namespace std;
+
+static const char default_mesh_dir[] = "data/mesh.obj";
+// cells along the longest side of the meshed scene's bounds
+static const unsigned int default_mesh_resolution = 128;
+static const unsigned int max_mesh_resolution = 4096;
+// cells along each side of the blocks the octree bottoms out at
+static const unsigned int mesh_block_size = 16;
+// blocks meshed in parallel before they are written out in order. together
+// with the block size this bounds how much of the grid is held in memory
+static const unsigned int mesh_block_window = 256;
+// Objects nested deeper than this are not meshed
+static const unsigned int mesh_max_depth = 64;
+
+/*
+ * Meshes the union of a hierarchy's superquadrics as one watertight triangle
+ * mesh. The inside-outside functions are only sampled in the blocks of a grid
+ * that an adaptive octree can't rule out as empty or solid, and the surface is
+ * extracted from them with dual contouring, one vertex per cell placed at the
+ * mass point of the cell's edge crossings.
+ */
+namespace Mesher {
+    // writes the mesh of every Primitive below the named Renderable to
+    // filename as an OBJ with per vertex normals. resolution is the number of
+    // cells along the longest side of the hierarchy's bounds
+    bool meshToObj(
+        const Name& name,
+        const char* filename,
+        unsigned int resolution);
+};
+
+#endif
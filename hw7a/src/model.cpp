@@ -51,8 +51,9 @@ const bool Name::operator!=(const Name& rhs) const {
 /******************************* Renderable Class *****************************/
 
 unordered_map<Name, Renderable*, NameHasher> Renderable::renderables;
+vector<Renderable*> Renderable::handles;
 
-Renderable::Renderable() {
+Renderable::Renderable() : id(invalid_renderable_id) {
     
 }
 Renderable::~Renderable() {
@@ -60,7 +61,11 @@ Renderable::~Renderable() {
 }
 
 // static instance controller functions
-Renderable* Renderable::create(RenderableType type, const Name& name) {
+Renderable* Renderable::create(
+    RenderableType type,
+    const Name& name,
+    bool verbose)
+{
     if (exists(name)) {
         fprintf(stderr, "Renderable::create ERROR name %s already exists with type %s\n",
             name.name, toCstr(type));
@@ -70,11 +75,15 @@ Renderable* Renderable::create(RenderableType type, const Name& name) {
     Renderable* new_renderable = NULL;
     switch (type) {
         case PRM:
-            printf("creating new Primitive with name %s\n", name.name);
+            if (verbose) {
+                printf("creating new Primitive with name %s\n", name.name);
+            }
             new_renderable = new Primitive();
             break;
         case OBJ:
-            printf("creating new Object with name %s\n", name.name);
+            if (verbose) {
+                printf("creating new Object with name %s\n", name.name);
+            }
             new_renderable = new Object();
             break;
         // case OBJ:
@@ -85,13 +94,19 @@ Renderable* Renderable::create(RenderableType type, const Name& name) {
             fprintf(stderr, "ERROR Renderable::create invalid RenderableType %d\n",
                 type);
     }
+    if (new_renderable) {
+        new_renderable->id = handles.size();
+        handles.push_back(new_renderable);
+    }
     renderables[name] = new_renderable;
 
     return new_renderable;
 }
 Renderable* Renderable::get(const Name& name) {
-    if (exists(name)) {
-        return renderables[name];
+    unordered_map<Name, Renderable*, NameHasher>::const_iterator ren_it =
+        renderables.find(name);
+    if (ren_it != renderables.end()) {
+        return ren_it->second;
     }
     return NULL;
 }
@@ -103,6 +118,14 @@ bool Renderable::exists(const Name& name) {
 }
 void Renderable::clear() {
     renderables.clear();
+    handles.clear();
+}
+void Renderable::reserve(size_t count) {
+    renderables.reserve(count);
+    handles.reserve(count);
+}
+unsigned int Renderable::getCount() {
+    return handles.size();
 }
 const unordered_map<Name, Renderable*, NameHasher>&
     Renderable::getActiveRenderables()
@@ -259,11 +282,21 @@ const Vector3f Primitive::getNormal(const Vector3f& vertex) {
 
 /********************************* Object Class *******************************/
 
-Child::Child() : name("default child"), transformations() {
+Child::Child() :
+    alias("default child"),
+    name("default child"),
+    id(invalid_renderable_id),
+    transformations()
+{
     fprintf(stderr, "Child ERROR Child default constructor called\n");
     exit(1);
 }
-Child::Child(const Name& name) : name(name), transformations() {
+Child::Child(const Name& alias, const Name& name, RenderableID id) :
+    alias(alias),
+    name(name),
+    id(id),
+    transformations()
+{
 
 }
 
@@ -272,6 +305,7 @@ Object::Object() :
     // display(false),
     transformations(),
     children(),
+    child_indices(),
     cursor(default_cursor)
 {
 
@@ -312,7 +346,7 @@ Object::~Object() {
 // }
 
 bool Object::aliasExists(const Name& name) {
-    return this->children.find(name) != this->children.end();
+    return this->child_indices.find(name) != this->child_indices.end();
 }
 
 // for overall transformation
@@ -334,14 +368,24 @@ void Object::overallRotate(
 void Object::overallScale(const float x, const float y, const float z) {
     this->transformations.push_back(Transformation(SCALE, x, y, z, 1));
 }
+void Object::overallTransform(const Transformation& trans) {
+    this->transformations.push_back(trans);
+}
 
 const vector<Transformation>& Object::getOverallTransformation() const {
     return this->transformations;
 }
 
 void Object::addChild(const Name& name, const Name& alias) {
-    if (Renderable::exists(name)) {
-        this->children.insert({alias, Child(name)});
+    Renderable* ren = Renderable::get(name);
+    if (ren) {
+        if (this->aliasExists(alias)) {
+            fprintf(stderr, "Object::addChild ERROR child alias %s already exists\n",
+                alias.name);
+            return;
+        }
+        this->child_indices.insert({alias, (unsigned int) this->children.size()});
+        this->children.push_back(Child(alias, name, ren->getID()));
         this->cursor = alias;
     } else {
         fprintf(stderr, "Object::addChild ERROR Renderable with name %s does not exist\n",
@@ -349,14 +393,22 @@ void Object::addChild(const Name& name, const Name& alias) {
     }
 }
 
-const unordered_map<Name, Child, NameHasher>& Object::getChildren() const
-{
+const vector<Child>& Object::getChildren() const {
     return this->children;
 }
 
+const Child* Object::getChild(const Name& alias) const {
+    unordered_map<Name, unsigned int, NameHasher>::const_iterator index_it =
+        this->child_indices.find(alias);
+    if (index_it == this->child_indices.end()) {
+        return NULL;
+    }
+    return &this->children[index_it->second];
+}
+
 // set cursor to given alias
 void Object::setCursor(const Name& alias) {
-    if (this->children.find(alias) == this->children.end()) {
+    if (!this->aliasExists(alias)) {
         fprintf(stderr, "Object::validateCursor ERROR child alias %s does not exist\n",
             alias.name);
     } else {
@@ -369,7 +421,7 @@ const Name& Object::getCursor() const {
 }
 
 bool Object::validateCursor() {
-    if (this->children.find(this->cursor) == this->children.end()) {
+    if (!this->aliasExists(this->cursor)) {
         fprintf(stderr, "Object::validateCursor ERROR child with alias %s does not exist\n",
             this->cursor.name);
         return false;
@@ -378,7 +430,7 @@ bool Object::validateCursor() {
 }
 void Object::cursorTranslate(const float x, const float y, const float z) {
     if (this->validateCursor()) {
-        this->children[this->cursor].transformations.push_back(
+        this->children[this->child_indices[this->cursor]].transformations.push_back(
             Transformation(TRANS, x, y, z, 1));
     }
 }
@@ -392,53 +444,68 @@ void Object::cursorRotate(
         Vector3f rotate;
         rotate << x, y, z;
         rotate.normalize();
-        this->children[this->cursor].transformations.push_back(
+        this->children[this->child_indices[this->cursor]].transformations.push_back(
             Transformation(ROTATE, rotate[0], rotate[1], rotate[2], theta));
     }
 }
 void Object::cursorScale(const float x, const float y, const float z) {
     if (this->validateCursor()) {
-        this->children[this->cursor].transformations.push_back(
+        this->children[this->child_indices[this->cursor]].transformations.push_back(
             Transformation(SCALE, x, y, z, 1));
     }
 }
+void Object::cursorTransform(const Transformation& trans) {
+    if (this->validateCursor()) {
+        this->children[this->child_indices[this->cursor]].transformations.push_back(trans);
+    }
+}
 
 /*************************** PrintInfo Helper Functions ***********************/
 
+void printInfoOverflow(unsigned int unlisted, int indent) {
+    if (unlisted > 0) {
+        printIndent(indent);
+        printf("... and %u more\n", unlisted);
+    }
+}
+
 void printSceneInfo(int indent) {
     printf("printing scene info\n");
 
-    // print primitives
-    unordered_map<Name, Renderable*, NameHasher>::const_iterator ren_it;
+    // count first so that large scenes can be summarized instead of listed
     const unordered_map<Name, Renderable*, NameHasher>& renderables =
         Renderable::getActiveRenderables();
-    if (renderables.size() > 0) {
-        printIndent(indent + 1);
-        printf("currently active Primitive(s):\n");
-        for (ren_it = renderables.begin();
-            ren_it != renderables.end();
-            ren_it++)
-        {
-            if (ren_it->second->getType() == PRM) {
-                printIndent(indent + 2);
-                printf("%s\n", ren_it->first.name);
-            }
+    unsigned int prm_count = 0;
+    unsigned int obj_count = 0;
+    for (const auto& ren_it : renderables) {
+        if (ren_it.second->getType() == PRM) {
+            prm_count++;
+        } else if (ren_it.second->getType() == OBJ) {
+            obj_count++;
         }
     }
 
-    // print objects
-    if (renderables.size() > 0) {
+    // print primitives then objects
+    for (RenderableType type : {PRM, OBJ}) {
+        unsigned int total = (type == PRM) ? prm_count : obj_count;
+        if (renderables.size() == 0) {
+            break;
+        }
         printIndent(indent + 1);
-        printf("currently active Object(s):\n");
-        for (ren_it = renderables.begin();
-            ren_it != renderables.end();
-            ren_it++)
-        {
-            if (ren_it->second->getType() == OBJ) {
+        printf("currently active %s(s): %u\n",
+            (type == PRM) ? "Primitive" : "Object", total);
+        unsigned int listed = 0;
+        for (const auto& ren_it : renderables) {
+            if (listed == info_list_limit) {
+                break;
+            }
+            if (ren_it.second->getType() == type) {
                 printIndent(indent + 2);
-                printf("%s\n", ren_it->first.name);
+                printf("%s\n", ren_it.first.name);
+                listed++;
             }
         }
+        printInfoOverflow(total - listed, indent + 2);
     }
 
     printf("DONE\n");
@@ -480,41 +547,30 @@ void printInfo(const Renderable* ren, int indent) {
             printf("overall transformation(s):\n");
             printInfo(obj->getOverallTransformation(), indent + 1);
 
-            // print children objects
-            printIndent(indent);
-            printf("child object(s):\n");
-            unordered_map<Name, Child, NameHasher>::const_iterator child_it;    // FIX HERE use const auto& for each loop
-            for (child_it = obj->getChildren().begin();
-                child_it != obj->getChildren().end();
-                child_it++)
-            {
-                assert(Renderable::get(child_it->second.name));
-                if (Renderable::get(child_it->second.name)->getType() == OBJ) {
-                    printIndent(indent + 1);
-                    printf("OBJ %s", child_it->second.name.name);
-                    if (child_it->second.name != child_it->first.name) {
-                        printf(" aliased as %s", child_it->first.name);
+            // print children objects then children primitives. huge Objects
+            // only list the first few of each
+            for (RenderableType type : {OBJ, PRM}) {
+                printIndent(indent);
+                printf("child %s(s):\n", (type == OBJ) ? "object" : "primitive");
+                unsigned int listed = 0;
+                unsigned int total = 0;
+                for (const Child& child : obj->getChildren()) {
+                    if (Renderable::get(child.id)->getType() != type) {
+                        continue;
                     }
-                    printf("\n");
-                }
-            }
-
-            // print children primitives
-            printIndent(indent);
-            printf("child primitive(s):\n");
-            for (child_it = obj->getChildren().begin();
-                child_it != obj->getChildren().end();
-                child_it++)
-            {
-                assert(Renderable::get(child_it->second.name));
-                if (Renderable::get(child_it->second.name)->getType() == PRM) {
+                    total++;
+                    if (listed == info_list_limit) {
+                        continue;
+                    }
+                    listed++;
                     printIndent(indent + 1);
-                    printf("PRM %s", child_it->second.name.name);
-                    if (child_it->second.name != child_it->first.name) {
-                        printf(" aliased as %s", child_it->first.name);
+                    printf("%s %s", toCstr(type), child.name.name);
+                    if (child.name != child.alias) {
+                        printf(" aliased as %s", child.alias.name);
                     }
                     printf("\n");
                 }
+                printInfoOverflow(total - listed, indent + 1);
             }
 
             // print cursor info
@@ -524,7 +580,7 @@ void printInfo(const Renderable* ren, int indent) {
                 printIndent(indent);
                 printf("transformation(s) on cursor renderable:\n");
                 printInfo(
-                    obj->getChildren().at(obj->getCursor()).transformations,
+                    obj->getChild(obj->getCursor())->transformations,
                     indent + 1);
             }
             break;
@@ -0,0 +1,517 @@
+#include "snapshot.hpp"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool scene_from_snapshot = false;
+
+/****************************** String Interning ******************************/
+
+// every name in the snapshot (Renderable names, aliases and cursors) is stored
+// exactly once in the string table and referenced by index everywhere else
+struct StringTable {
+    unordered_map<Name, uint32_t, NameHasher> ids;
+    vector<uint32_t> offsets;
+    vector<char> strings;
+
+    uint32_t intern(const Name& name) {
+        unordered_map<Name, uint32_t, NameHasher>::const_iterator it =
+            this->ids.find(name);
+        if (it != this->ids.end()) {
+            return it->second;
+        }
+
+        uint32_t id = this->offsets.size();
+        this->ids.insert({name, id});
+        this->offsets.push_back(this->strings.size());
+        this->strings.insert(this->strings.end(),
+            name.name, name.name + strlen(name.name) + 1);
+        return id;
+    }
+};
+
+static uint32_t alignOffset(uint32_t offset) {
+    return (offset + 3) & ~((uint32_t) 3);
+}
+
+static void appendTransformations(
+    const vector<Transformation>& trans,
+    vector<SnapshotTransformation>& table,
+    uint32_t& begin,
+    uint32_t& count)
+{
+    begin = table.size();
+    count = trans.size();
+    for (const auto& t : trans) {
+        SnapshotTransformation snap_trans;
+        snap_trans.type = t.type;
+        for (int i = 0; i < 4; i++) {
+            snap_trans.trans[i] = t.trans[i];
+        }
+        table.push_back(snap_trans);
+    }
+}
+
+/********************************* Binary I/O *********************************/
+
+bool Snapshot::save(const char* filename) {
+    const unordered_map<Name, Renderable*, NameHasher>& renderables =
+        Renderable::getActiveRenderables();
+
+    StringTable string_table;
+    vector<SnapshotPrimitive> primitives;
+    vector<SnapshotObject> objects;
+    vector<SnapshotChild> children;
+    vector<SnapshotTransformation> transformations;
+
+    for (const auto& ren_it : renderables) {
+        switch (ren_it.second->getType()) {
+            case PRM:
+            {
+                const Primitive* prm =
+                    dynamic_cast<const Primitive*>(ren_it.second);
+                SnapshotPrimitive snap_prm;
+                snap_prm.name = string_table.intern(ren_it.first);
+                for (int i = 0; i < 3; i++) {
+                    snap_prm.coeff[i] = prm->getCoeff()[i];
+                }
+                snap_prm.exp0 = prm->getExp0();
+                snap_prm.exp1 = prm->getExp1();
+                snap_prm.patch_x = prm->getPatchX();
+                snap_prm.patch_y = prm->getPatchY();
+                snap_prm.color[0] = prm->getColor().r;
+                snap_prm.color[1] = prm->getColor().g;
+                snap_prm.color[2] = prm->getColor().b;
+                snap_prm.ambient = prm->getAmbient();
+                snap_prm.reflected = prm->getReflected();
+                snap_prm.refracted = prm->getRefracted();
+                snap_prm.gloss = prm->getGloss();
+                snap_prm.diffuse = prm->getDiffuse();
+                snap_prm.specular = prm->getSpecular();
+                primitives.push_back(snap_prm);
+                break;
+            }
+            case OBJ:
+            {
+                const Object* obj = dynamic_cast<const Object*>(ren_it.second);
+                SnapshotObject snap_obj;
+                snap_obj.name = string_table.intern(ren_it.first);
+                snap_obj.cursor = (obj->getCursor() == default_cursor) ?
+                    snapshot_no_string : string_table.intern(obj->getCursor());
+                appendTransformations(obj->getOverallTransformation(),
+                    transformations,
+                    snap_obj.transformation_begin,
+                    snap_obj.transformation_count);
+
+                snap_obj.child_begin = children.size();
+                snap_obj.child_count = obj->getChildren().size();
+                for (const Child& child : obj->getChildren()) {
+                    SnapshotChild snap_child;
+                    snap_child.alias = string_table.intern(child.alias);
+                    snap_child.name = string_table.intern(child.name);
+                    appendTransformations(child.transformations,
+                        transformations,
+                        snap_child.transformation_begin,
+                        snap_child.transformation_count);
+                    children.push_back(snap_child);
+                }
+                objects.push_back(snap_obj);
+                break;
+            }
+            default:
+                fprintf(stderr, "Snapshot::save ERROR unsupported Renderable type %s\n",
+                    toCstr(ren_it.second->getType()));
+                return false;
+        }
+    }
+
+    // lay out the tables back to back after the header
+    SnapshotHeader header;
+    memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+    header.version = snapshot_version;
+    header.string_count = string_table.offsets.size();
+    header.string_bytes = string_table.strings.size();
+    header.primitive_count = primitives.size();
+    header.object_count = objects.size();
+    header.child_count = children.size();
+    header.transformation_count = transformations.size();
+
+    header.string_offsets_offset = sizeof(SnapshotHeader);
+    header.strings_offset = header.string_offsets_offset +
+        header.string_count * sizeof(uint32_t);
+    header.primitives_offset =
+        alignOffset(header.strings_offset + header.string_bytes);
+    header.objects_offset = header.primitives_offset +
+        header.primitive_count * sizeof(SnapshotPrimitive);
+    header.children_offset = header.objects_offset +
+        header.object_count * sizeof(SnapshotObject);
+    header.transformations_offset = header.children_offset +
+        header.child_count * sizeof(SnapshotChild);
+
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        fprintf(stderr, "Snapshot::save ERROR couldn't open file %s\n",
+            filename);
+        return false;
+    }
+
+    const char padding[4] = {0, 0, 0, 0};
+    fwrite(&header, sizeof(SnapshotHeader), 1, file);
+    fwrite(string_table.offsets.data(), sizeof(uint32_t),
+        string_table.offsets.size(), file);
+    fwrite(string_table.strings.data(), 1, string_table.strings.size(), file);
+    fwrite(padding, 1, header.primitives_offset -
+        (header.strings_offset + header.string_bytes), file);
+    fwrite(primitives.data(), sizeof(SnapshotPrimitive), primitives.size(),
+        file);
+    fwrite(objects.data(), sizeof(SnapshotObject), objects.size(), file);
+    fwrite(children.data(), sizeof(SnapshotChild), children.size(), file);
+    fwrite(transformations.data(), sizeof(SnapshotTransformation),
+        transformations.size(), file);
+
+    bool success = !ferror(file);
+    fclose(file);
+    if (!success) {
+        fprintf(stderr, "Snapshot::save ERROR couldn't write file %s\n",
+            filename);
+    }
+    return success;
+}
+
+/*
+ * Checks that every table named in the header lies inside the mapped file and
+ * that every index stored in the tables is in range, so the load below can
+ * use the records directly.
+ */
+static bool validateSnapshot(const char* data, size_t size) {
+    if (size < sizeof(SnapshotHeader)) {
+        return false;
+    }
+    const SnapshotHeader* header = (const SnapshotHeader*) data;
+    if (memcmp(header->magic, snapshot_magic, sizeof(snapshot_magic)) != 0 ||
+        header->version != snapshot_version)
+    {
+        return false;
+    }
+
+    const uint64_t tables[6][3] = {
+        {header->string_offsets_offset, header->string_count, sizeof(uint32_t)},
+        {header->strings_offset, header->string_bytes, 1},
+        {header->primitives_offset, header->primitive_count,
+            sizeof(SnapshotPrimitive)},
+        {header->objects_offset, header->object_count, sizeof(SnapshotObject)},
+        {header->children_offset, header->child_count, sizeof(SnapshotChild)},
+        {header->transformations_offset, header->transformation_count,
+            sizeof(SnapshotTransformation)}
+    };
+    for (int i = 0; i < 6; i++) {
+        if (tables[i][0] % 4 != 0 && tables[i][2] != 1) {
+            return false;
+        }
+        if (tables[i][0] + tables[i][1] * tables[i][2] > size) {
+            return false;
+        }
+    }
+
+    // every string must be null terminated inside the string table and fit
+    // in a Name
+    const uint32_t* string_offsets =
+        (const uint32_t*) (data + header->string_offsets_offset);
+    const char* strings = data + header->strings_offset;
+    for (uint32_t i = 0; i < header->string_count; i++) {
+        uint32_t offset = string_offsets[i];
+        if (offset >= header->string_bytes) {
+            return false;
+        }
+        const void* end = memchr(strings + offset, '\0',
+            header->string_bytes - offset);
+        if (!end || (const char*) end - (strings + offset) >=
+            (long) name_buffer_size)
+        {
+            return false;
+        }
+    }
+
+    const SnapshotPrimitive* primitives =
+        (const SnapshotPrimitive*) (data + header->primitives_offset);
+    for (uint32_t i = 0; i < header->primitive_count; i++) {
+        if (primitives[i].name >= header->string_count) {
+            return false;
+        }
+    }
+    const SnapshotObject* objects =
+        (const SnapshotObject*) (data + header->objects_offset);
+    for (uint32_t i = 0; i < header->object_count; i++) {
+        const SnapshotObject& obj = objects[i];
+        if (obj.name >= header->string_count ||
+            (obj.cursor != snapshot_no_string &&
+                obj.cursor >= header->string_count) ||
+            (uint64_t) obj.child_begin + obj.child_count >
+                header->child_count ||
+            (uint64_t) obj.transformation_begin + obj.transformation_count >
+                header->transformation_count)
+        {
+            return false;
+        }
+    }
+    const SnapshotChild* children =
+        (const SnapshotChild*) (data + header->children_offset);
+    for (uint32_t i = 0; i < header->child_count; i++) {
+        const SnapshotChild& child = children[i];
+        if (child.alias >= header->string_count ||
+            child.name >= header->string_count ||
+            (uint64_t) child.transformation_begin +
+                child.transformation_count > header->transformation_count)
+        {
+            return false;
+        }
+    }
+    const SnapshotTransformation* transformations =
+        (const SnapshotTransformation*) (data + header->transformations_offset);
+    for (uint32_t i = 0; i < header->transformation_count; i++) {
+        if (transformations[i].type > ROTATE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static Transformation toTransformation(const SnapshotTransformation& trans) {
+    return Transformation((TransformationType) trans.type,
+        trans.trans[0], trans.trans[1], trans.trans[2], trans.trans[3]);
+}
+
+bool Snapshot::load(const char* filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Snapshot::load ERROR couldn't open file %s\n",
+            filename);
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        fprintf(stderr, "Snapshot::load ERROR couldn't read file %s\n",
+            filename);
+        close(fd);
+        return false;
+    }
+    size_t size = file_stat.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Snapshot::load ERROR couldn't map file %s\n",
+            filename);
+        return false;
+    }
+
+    const char* data = (const char*) mapping;
+    if (!validateSnapshot(data, size)) {
+        fprintf(stderr, "Snapshot::load ERROR %s is not a valid snapshot\n",
+            filename);
+        munmap(mapping, size);
+        return false;
+    }
+
+    const SnapshotHeader* header = (const SnapshotHeader*) data;
+    const uint32_t* string_offsets =
+        (const uint32_t*) (data + header->string_offsets_offset);
+    const char* strings = data + header->strings_offset;
+    const SnapshotPrimitive* primitives =
+        (const SnapshotPrimitive*) (data + header->primitives_offset);
+    const SnapshotObject* objects =
+        (const SnapshotObject*) (data + header->objects_offset);
+    const SnapshotChild* children =
+        (const SnapshotChild*) (data + header->children_offset);
+    const SnapshotTransformation* transformations =
+        (const SnapshotTransformation*) (data + header->transformations_offset);
+
+    Renderable::reserve(header->primitive_count + header->object_count);
+
+    // primitives and objects first so every child can be resolved below
+    for (uint32_t i = 0; i < header->primitive_count; i++) {
+        const SnapshotPrimitive& snap_prm = primitives[i];
+        Primitive* prm = dynamic_cast<Primitive*>(Renderable::create(
+            PRM, strings + string_offsets[snap_prm.name], false));
+        if (!prm) {
+            continue;
+        }
+        prm->setCoeff(snap_prm.coeff[0], snap_prm.coeff[1], snap_prm.coeff[2]);
+        prm->setExponents(snap_prm.exp0, snap_prm.exp1);
+        prm->setPatch(snap_prm.patch_x, snap_prm.patch_y);
+        prm->setColor(snap_prm.color[0], snap_prm.color[1], snap_prm.color[2]);
+        prm->setAmbient(snap_prm.ambient);
+        prm->setReflected(snap_prm.reflected);
+        prm->setRefracted(snap_prm.refracted);
+        prm->setGloss(snap_prm.gloss);
+        prm->setDiffuse(snap_prm.diffuse);
+        prm->setSpecular(snap_prm.specular);
+    }
+    vector<Object*> created_objects(header->object_count);
+    for (uint32_t i = 0; i < header->object_count; i++) {
+        created_objects[i] = dynamic_cast<Object*>(Renderable::create(
+            OBJ, strings + string_offsets[objects[i].name], false));
+    }
+
+    for (uint32_t i = 0; i < header->object_count; i++) {
+        const SnapshotObject& snap_obj = objects[i];
+        Object* obj = created_objects[i];
+        if (!obj) {
+            continue;
+        }
+
+        for (uint32_t t = 0; t < snap_obj.transformation_count; t++) {
+            obj->overallTransform(toTransformation(
+                transformations[snap_obj.transformation_begin + t]));
+        }
+        for (uint32_t c = 0; c < snap_obj.child_count; c++) {
+            const SnapshotChild& snap_child = children[snap_obj.child_begin + c];
+            // addChild leaves the cursor on the new child
+            obj->addChild(strings + string_offsets[snap_child.name],
+                strings + string_offsets[snap_child.alias]);
+            for (uint32_t t = 0; t < snap_child.transformation_count; t++) {
+                obj->cursorTransform(toTransformation(
+                    transformations[snap_child.transformation_begin + t]));
+            }
+        }
+        if (snap_obj.cursor != snapshot_no_string) {
+            obj->setCursor(strings + string_offsets[snap_obj.cursor]);
+        }
+    }
+
+    printf("loaded %u Primitive(s) and %u Object(s) from %s\n",
+        header->primitive_count, header->object_count, filename);
+
+    munmap(mapping, size);
+    scene_from_snapshot = true;
+    return true;
+}
+
+/********************************* Text Output ********************************/
+
+/* Writes the shortest decimal form of a float that reads back exactly. */
+struct ExactFloat {
+    float value;
+    explicit ExactFloat(float value) : value(value) {}
+};
+static ostream& operator<<(ostream& output, const ExactFloat& exact) {
+    char float_buffer[32];
+    for (int precision = 6; precision <= 9; precision++) {
+        snprintf(float_buffer, sizeof(float_buffer), "%.*g", precision,
+            exact.value);
+        if (strtof(float_buffer, NULL) == exact.value) {
+            break;
+        }
+    }
+    return output << float_buffer;
+}
+
+static void writeTransformations(
+    ostream& output,
+    const vector<Transformation>& trans,
+    const char* translate_cmd,
+    const char* rotate_cmd,
+    const char* scale_cmd)
+{
+    for (const auto& t : trans) {
+        switch (t.type) {
+            case TRANS:
+                output << translate_cmd;
+                break;
+            case ROTATE:
+                output << rotate_cmd;
+                break;
+            case SCALE:
+                output << scale_cmd;
+                break;
+            default:
+                fprintf(stderr, "ERROR writeTransformations invalid TransformationType %d\n",
+                    t.type);
+                exit(1);
+        }
+        output << ' ' << ExactFloat(t.trans[0])
+            << ' ' << ExactFloat(t.trans[1])
+            << ' ' << ExactFloat(t.trans[2]);
+        if (t.type == ROTATE) {
+            output << ' ' << ExactFloat(t.trans[3] * 180.0 / M_PI);
+        }
+        output << '\n';
+    }
+}
+
+/*
+ * Primitives are written first, then every Object is created empty so that
+ * children can be added in any order, and finally each Object is filled in.
+ */
+void Snapshot::writeCommands(ostream& output) {
+    const unordered_map<Name, Renderable*, NameHasher>& renderables =
+        Renderable::getActiveRenderables();
+
+    for (const auto& ren_it : renderables) {
+        if (ren_it.second->getType() != PRM) {
+            continue;
+        }
+        const Primitive* prm = dynamic_cast<const Primitive*>(ren_it.second);
+        const Vector3f& coeff = prm->getCoeff();
+        const RGBf& color = prm->getColor();
+        output << "Primitive " << ren_it.first.name << '\n'
+            << "coeff " << ExactFloat(coeff[0]) << ' '
+                << ExactFloat(coeff[1]) << ' ' << ExactFloat(coeff[2]) << '\n'
+            << "exponent " << ExactFloat(prm->getExp0()) << ' '
+                << ExactFloat(prm->getExp1()) << '\n'
+            << "patch " << prm->getPatchX() << ' ' << prm->getPatchY() << '\n'
+            << "color " << ExactFloat(color.r) << ' '
+                << ExactFloat(color.g) << ' ' << ExactFloat(color.b) << '\n'
+            << "ambient " << ExactFloat(prm->getAmbient()) << '\n'
+            << "reflected " << ExactFloat(prm->getReflected()) << '\n'
+            << "refracted " << ExactFloat(prm->getRefracted()) << '\n'
+            << "gloss " << ExactFloat(prm->getGloss()) << '\n'
+            << "diffuse " << ExactFloat(prm->getDiffuse()) << '\n'
+            << "specular " << ExactFloat(prm->getSpecular()) << '\n';
+    }
+
+    for (const auto& ren_it : renderables) {
+        if (ren_it.second->getType() == OBJ) {
+            output << "Object " << ren_it.first.name << '\n';
+        }
+    }
+
+    for (const auto& ren_it : renderables) {
+        if (ren_it.second->getType() != OBJ) {
+            continue;
+        }
+        const Object* obj = dynamic_cast<const Object*>(ren_it.second);
+        output << "Object " << ren_it.first.name << '\n';
+        writeTransformations(output, obj->getOverallTransformation(),
+            "translateAll", "rotateAll", "scaleAll");
+        for (const Child& child : obj->getChildren()) {
+            Renderable* ren = Renderable::get(child.id);
+            output << ((ren->getType() == OBJ) ? "addObject " : "addPrimitive ")
+                << child.name.name << ' '
+                << child.alias.name << '\n';
+            writeTransformations(output, child.transformations,
+                "translate", "rotate", "scale");
+        }
+        if (obj->getCursor() != default_cursor) {
+            output << "setCursor " << obj->getCursor().name << '\n';
+        }
+    }
+    output << "deselect" << '\n';
+}
+
+/*********************************** Status ***********************************/
+
+bool Snapshot::sceneFromSnapshot() {
+    return scene_from_snapshot;
+}
+
+void Snapshot::clearSceneFromSnapshot() {
+    scene_from_snapshot = false;
+}
+
+bool Snapshot::isSnapshotFile(const char* filename) {
+    const char* extension = strrchr(filename, '.');
+    return extension && strcmp(extension, ".scnb") == 0;
+}
@@ -0,0 +1,107 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <iostream>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "model.hpp"
+
+using namespace std;
+
+/*
+ * Binary snapshot of the Renderable registry. Everything is stored in flat
+ * tables of fixed size records that reference each other by index, so a
+ * snapshot can be memory mapped and walked without any per-node parsing.
+ *
+ * file layout (all offsets are in bytes from the start of the file and are
+ * 4 byte aligned):
+ *
+ *     SnapshotHeader
+ *     uint32_t                string_offsets[string_count]
+ *     char                    strings[string_bytes]  (null terminated names)
+ *     SnapshotPrimitive       primitives[primitive_count]
+ *     SnapshotObject          objects[object_count]
+ *     SnapshotChild           children[child_count]
+ *     SnapshotTransformation  transformations[transformation_count]
+ */
+static const char snapshot_magic[4] = {'S', 'C', 'N', 'B'};
+static const uint32_t snapshot_version = 1;
+static const uint32_t snapshot_no_string = (uint32_t) -1;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+
+    uint32_t string_count;
+    uint32_t string_bytes;
+    uint32_t primitive_count;
+    uint32_t object_count;
+    uint32_t child_count;
+    uint32_t transformation_count;
+
+    uint32_t string_offsets_offset;
+    uint32_t strings_offset;
+    uint32_t primitives_offset;
+    uint32_t objects_offset;
+    uint32_t children_offset;
+    uint32_t transformations_offset;
+};
+
+struct SnapshotPrimitive {
+    uint32_t name;
+    float coeff[3];
+    float exp0;
+    float exp1;
+    uint32_t patch_x;
+    uint32_t patch_y;
+    float color[3];
+    float ambient;
+    float reflected;
+    float refracted;
+    float gloss;
+    float diffuse;
+    float specular;
+};
+
+struct SnapshotObject {
+    uint32_t name;
+    uint32_t cursor;    // snapshot_no_string if the cursor is not set
+    uint32_t transformation_begin;
+    uint32_t transformation_count;
+    uint32_t child_begin;
+    uint32_t child_count;
+};
+
+struct SnapshotChild {
+    uint32_t alias;
+    uint32_t name;
+    uint32_t transformation_begin;
+    uint32_t transformation_count;
+};
+
+struct SnapshotTransformation {
+    uint32_t type;
+    float trans[4];
+};
+
+namespace Snapshot {
+    // binary snapshot of every active Renderable
+    bool save(const char* filename);
+    bool load(const char* filename);
+
+    // writes the commands needed to rebuild every active Renderable in the
+    // text (.scn) format
+    void writeCommands(ostream& output);
+
+    // true if the current scene was loaded from a binary snapshot, meaning the
+    // command history alone no longer describes it
+    bool sceneFromSnapshot();
+    void clearSceneFromSnapshot();
+
+    // true if the filename ends with the binary snapshot extension
+    bool isSnapshotFile(const char* filename);
+};
+
+#endif
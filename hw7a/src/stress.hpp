@@ -0,0 +1,38 @@
+#ifndef STRESS_HPP
+#define STRESS_HPP
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "model.hpp"
+
+using namespace std;
+
+// generated scenes larger than this are refused
+static const unsigned long stress_max_primitives = 10000000;
+static const unsigned int stress_max_depth = 24;
+static const unsigned int stress_patch = 6;
+
+/*
+ * Procedural scene generators used to exercise the modeler at scale. Every
+ * generated Renderable is prefixed with the root Object's name.
+ */
+namespace Stress {
+    // an Object holding nx * ny * nz distinct Primitives laid out on a grid
+    bool generateGrid(
+        const char* name,
+        unsigned int nx,
+        unsigned int ny,
+        unsigned int nz);
+    // a depth level hierarchy where every level instances the level below it
+    // branching times
+    bool generateFractal(
+        const char* name,
+        unsigned int depth,
+        unsigned int branching);
+
+    // prints the unique and instanced Renderable counts below an Object
+    void printStats(const Object* root);
+};
+
+#endif
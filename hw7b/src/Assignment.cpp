@@ -106,10 +106,8 @@ void Assignment::traverseObj(Object* obj, int depth) {
         return;
 
     // Iterate thru children
-    const unordered_map<Name, Child, NameHasher>& child_map = obj->getChildren();
-    for (auto it = child_map.begin(); it != child_map.end(); ++it) {
-        Child child = it->second;
-        Renderable *ren = Renderable::get(child.name);
+    for (const Child& child : obj->getChildren()) {
+        Renderable *ren = Renderable::get(child.id);
         traverseRen(ren, child.transformations, depth);
     }
 }
@@ -173,8 +171,7 @@ Vector3f Assignment::getNormal(Vector3f u_point, Primitive* prm,
     Vector3f norm = prm->getNormal(u_point);
 
     // Transform norm
-    MatrixXf transform = get_matrix_prod(transformations);
-    norm = transform_vector(norm, transform);
+    norm = get_transform_chain(transformations).product.transform_point(norm);
 
     return norm;
 }
@@ -184,8 +181,7 @@ Vector3f Assignment::getNormal(Vector3f u_point, Primitive* prm,
  */
 Vector3f Assignment::transformIntersection(Vector3f u_point,
         vector<Transformation> transformations) {
-    MatrixXf transform = get_matrix_prod(transformations);
-    return transform_vector(u_point, transform);
+    return get_transform_chain(transformations).product.transform_point(u_point);
 }
 
 /*
@@ -194,21 +190,19 @@ Vector3f Assignment::transformIntersection(Vector3f u_point,
  */
 Vector3f* Assignment::intersectPrm(Camera* camera, Primitive* prm,
         vector<Transformation> transformations) {
-    MatrixXf transform = get_inverse_prod(transformations);
+    affine_transform<float> inverse = get_transform_chain(transformations).inverse;
 
     /* Apply inverse transforms to cam position and direction */
-    Vector3f cam_pos_transformed = transform_vector(camera->getPosition(),
-            transform);
+    Vector3f cam_pos_transformed = inverse.transform_point(camera->getPosition());
 
     Vector3f cam_dir(0.0, 0.0, -1.0);
     Vector3f rotation_axis = camera->getAxis();
     float rotation_angle = camera->getAngle();
-    MatrixXf cam_rotation = get_rotation_matrix(rotation_axis(0), rotation_axis(1),
-            rotation_axis(2), rotation_angle);
-    Vector3f cam_dir_transformed = transform_vector(cam_dir, cam_rotation);
+    Vector3f cam_dir_transformed = rotation_transform(rotation_axis(0),
+            rotation_axis(1), rotation_axis(2), rotation_angle)
+        .transform_direction(cam_dir);
     // Don't apply translations to cam_dir
-    MatrixXf transform_cam = get_inverse_prod(transformations, true);
-    cam_dir_transformed = transform_vector(cam_dir_transformed, transform_cam);
+    cam_dir_transformed = inverse.transform_direction(cam_dir_transformed);
 
     float e = prm->getExp0();
     float n = prm->getExp1();
@@ -332,8 +326,8 @@ int Assignment::closestPointIndex(vector<Vector3f> points,
     for (int i = 0; i < (int) points.size(); i++) {
         // Untransform point because it has had the inverse superquadric transformations
         // applied
-        MatrixXf transform = get_matrix_prod(pairs[i].second);
-        Vector3f point = transform_vector(points[i], transform);
+        Vector3f point = get_transform_chain(pairs[i].second).product
+            .transform_point(points[i]);
         Vector3f diffs = camera->getPosition() - point;
         float dist = diffs.norm();
         if (dist < min_dist) {
@@ -349,125 +343,49 @@ int Assignment::closestPointIndex(vector<Vector3f> points,
 
 
 /*
- * Transforms a vector.
+ * Keeps the top three rows of the inverse transformation and precomputes the
+ * exponents of the inside-outside function.
  */
-Vector3f transform_vector(Vector3f v, MatrixXf transform) {
-    Vector4f v1(v(0), v(1), v(2), 1);
-    Vector4f v_t = transform * v1;
-    Vector3f v_f;
-    v_f(0) = v_t(0) / v_t(3);
-    v_f(1) = v_t(1) / v_t(3);
-    v_f(2) = v_t(2) / v_t(3);
-    return v_f;
-}
-
-/*
- * Get product of passed-in transformations. Compute product in reverse order;
- * that is, if vector is ABC, compute product CBA.
- */
-MatrixXf get_matrix_prod(vector<Transformation> transformations,
-        bool exclude_translation) {
-    MatrixXf prod = MatrixXf::Identity(4, 4);
-    MatrixXf curr_mat;
-    for (int i = (int) transformations.size() - 1; i >= 0; i--) {
-        if (exclude_translation && transformations[i].type == TRANS)
-            continue;
-        curr_mat = get_matrix(transformations[i]);
-        prod = prod * curr_mat;
-    }
-
-    return prod;
-}
-
-/*
- * Get inverse product of passed-in transformations.
- */
-MatrixXf get_inverse_prod(vector<Transformation> transformations,
-        bool exclude_translation) {
-    MatrixXf prod = MatrixXf::Identity(4, 4);
-    MatrixXf curr_mat;
-    for (int i = 0; i < (int) transformations.size(); i++) {
-        if (exclude_translation && transformations[i].type == TRANS)
-            continue;
-        curr_mat = get_matrix(transformations[i]);
-        curr_mat = curr_mat.inverse();
-        prod = prod * curr_mat;
+IOPrimitive makeIOPrimitive(const Primitive* prm,
+        const affine_transform<float>& inverse) {
+    IOPrimitive io_prm;
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 4; col++) {
+            io_prm.inv[4 * row + col] = inverse.m[row][col];
+        }
     }
-
-    return prod;
+    float e = prm->getExp0();
+    float n = prm->getExp1();
+    io_prm.inv_e = 1.0 / e;
+    io_prm.e_over_n = e / n;
+    io_prm.inv_n = 1.0 / n;
+    return io_prm;
 }
 
 /*
- * From character determ, determines which matrix (of translation/scaling/rotation)
- * to get, and returns it.
+ * Composes the passed-in transformations, the first one applied first, along
+ * with the inverse of their product.
  */
-MatrixXf get_matrix(Transformation transf) {
-    TransformationType type = transf.type;
-    float x = transf.trans(0);
-    float y = transf.trans(1);
-    float z = transf.trans(2);
-    float angle = transf.trans(3);
-    if (type == TRANS) {
-        // Translation matrix
-        return get_translation_matrix(x, y, z);
-    } else if (type == SCALE) {
-        // Scaling matrix
-        return get_scaling_matrix(x, y, z);
-    } else if (type == ROTATE) {
-        // Rotation matrix
-        return get_rotation_matrix(x, y, z, angle);
-    } else {
-        cout << "Invalid argument, exiting" << endl;
-        exit(EXIT_FAILURE);
+transform_chain<float> get_transform_chain(
+        const vector<Transformation>& transformations) {
+    transform_chain<float> chain;
+    for (const Transformation& transf : transformations) {
+        float x = transf.trans(0);
+        float y = transf.trans(1);
+        float z = transf.trans(2);
+        float angle = transf.trans(3);
+        if (transf.type == TRANS) {
+            chain.translate(x, y, z);
+        } else if (transf.type == SCALE) {
+            chain.scale(x, y, z);
+        } else if (transf.type == ROTATE) {
+            chain.rotate(x, y, z, angle);
+        } else {
+            cout << "Invalid argument, exiting" << endl;
+            exit(EXIT_FAILURE);
+        }
     }
-}
-
-/*
- * Creates the translation matrix corresponding to the (x, y, z) vector and
- * returns it.
- */
-MatrixXf get_translation_matrix(float x, float y, float z) {
-    MatrixXf m(4,4);
-    m << 1, 0, 0, x,
-      0, 1, 0, y,
-      0, 0, 1, z,
-      0, 0, 0, 1;
-    return m;
-}
-
-/*
- * Creates the scaling matrix corresponding to the (x, y, z) vector and
- * returns it.
- */
-MatrixXf get_scaling_matrix(float x, float y, float z) {
-    MatrixXf m(4,4);
-    m << x, 0, 0, 0,
-      0, y, 0, 0,
-      0, 0, z, 0,
-      0, 0, 0, 1;
-    return m;
-}
-
-/*
- * Creates the rotation matrix corresponding to the (x, y, z) vector and the
- * passed-in angle and returns it.
- */
-MatrixXf get_rotation_matrix(float x, float y, float z, float angle) {
-    MatrixXf m(4,4);
-    // Make input vector a unit vector
-    float magnitude = sqrt(x * x + y * y + z * z);
-    x /= magnitude;
-    y /= magnitude;
-    z /= magnitude;
-
-    m << (x * x) + (1 - (x * x)) * cos(angle), (x * y) * (1 - cos(angle)) - z * sin(angle),
-              (x * z) * (1 - cos(angle)) + y * sin(angle), 0,
-      (y * x) * (1 - cos(angle)) + z * sin(angle), (y * y) + (1 - y * y) * cos(angle),
-              (y * z) * (1 - cos(angle)) - x * sin(angle), 0,
-      (z * x) * (1 - cos(angle)) - y * sin(angle), (z * y) * (1 - cos(angle)) + x * sin(angle),
-              (z * z) + (1 - (z * z)) * cos(angle), 0,
-      0, 0, 0, 1;
-    return m;
+    return chain;
 }
 
 /*
@@ -1,16 +1,44 @@
 #ifndef ASSIGNMENT_HPP
 #define ASSIGNMENT_HPP
 
+#include <math.h>
 #include <vector>
 
 #include "PNGMaker.hpp"
 #include "model.hpp"
+#include "transform.h"
 
 class Camera;
 class Scene;
 
 using namespace std;
 
+/*
+ * A primitive prepared for inside-outside tests. The inverse of its
+ * transformations is affine so only its top three rows are kept, and the
+ * exponents of the inside-outside function are precomputed.
+ */
+struct IOPrimitive {
+    float inv[12];
+    float inv_e;
+    float e_over_n;
+    float inv_n;
+};
+
+// prepares prm for inside-outside tests, with inverse taking points from the
+// space they are given in to the primitive's own space
+IOPrimitive makeIOPrimitive(const Primitive* prm,
+        const affine_transform<float>& inverse);
+
+/*
+ * The inside-outside function of prm at the point (x, y, z) of its own space,
+ * plus one. It is below 1 exactly at the points inside the superquadric.
+ */
+inline float insideOutside(const IOPrimitive& prm, float x, float y, float z) {
+    return powf(powf(x * x, prm.inv_e) + powf(y * y, prm.inv_e),
+            prm.e_over_n) + powf(z * z, prm.inv_n);
+}
+
 class Assignment {
     public:
         Assignment() = default;
@@ -36,15 +64,8 @@ class Assignment {
                 vector<pair<Primitive*, vector<Transformation>>> pairs, Camera* camera);
 };
 
-Vector3f transform_vector(Vector3f v, MatrixXf transform);
-MatrixXf get_matrix_prod(vector<Transformation> transformations,
-        bool exclude_translation = false);
-MatrixXf get_inverse_prod(vector<Transformation> transformations,
-        bool exclude_translation = false);
-MatrixXf get_matrix(Transformation transf);
-MatrixXf get_translation_matrix(float x, float y, float z);
-MatrixXf get_scaling_matrix(float x, float y, float z);
-MatrixXf get_rotation_matrix(float x, float y, float z, float angle);
+transform_chain<float> get_transform_chain(
+        const vector<Transformation>& transformations);
 float deg2rad(float angle);
 
 #endif
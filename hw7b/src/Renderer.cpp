@@ -147,7 +147,7 @@ void Renderer::checkUIState() {
     // If we need to rebuild the vertex buffers, do so
     if (this->ui->rebuild_scene) {
         this->ui->rebuild_scene = false;
-        this->scene->update();
+        this->scene->update(true);
     }
     // If we need to raytrace the scene, do so
     if (this->ui->raytrace_scene) {
@@ -179,8 +179,8 @@ void Renderer::draw(Renderable* ren, int depth) {
  * normals start at the given offset in the respective vertex buffers.
  */
 void Renderer::drawPrimitive(Primitive *prm) {
-    assert(this->scene->prm_tessellation_start.find(prm) !=
-        this->scene->prm_tessellation_start.end());
+    assert(this->scene->prm_tessellation_start[prm->getID()] !=
+        no_tessellation);
 
     const RGBf& color = prm->getColor();
     const float ambient = prm->getAmbient();
@@ -202,7 +202,7 @@ void Renderer::drawPrimitive(Primitive *prm) {
     glMaterialfv(GL_FRONT, GL_SPECULAR, specularColor);
     glMaterialf(GL_FRONT, GL_SHININESS, prm->getReflected());
 
-    uint start = this->scene->prm_tessellation_start[prm];
+    uint start = this->scene->prm_tessellation_start[prm->getID()];
 
     int ures = prm->getPatchX();
     int vres = prm->getPatchY();
@@ -356,15 +356,14 @@ void Renderer::drawObject(Object* obj, int depth) {
         transform(overall_trans.at(i));
     }
 
-    for (auto& child_it : obj->getChildren()) {
+    for (const Child& child : obj->getChildren()) {
         glPushMatrix();
 
-        const vector<Transformation>& child_trans = 
-            child_it.second.transformations;
+        const vector<Transformation>& child_trans = child.transformations;
         for (int i = child_trans.size() - 1; i >= 0; i--) {
             transform(child_trans.at(i));
         }
-        draw(Renderable::get(child_it.second.name), depth + 1);
+        draw(Renderable::get(child.id), depth + 1);
 
         glPopMatrix();
     }
@@ -526,19 +525,27 @@ void Renderer::display() {
     glPushMatrix();
     glMultMatrixf(ui->arcball_object_mat.data());
 
+    // Only copy the buffers over when the scene has been re-tessellated
+    bool upload = scene->buffers_dirty;
+    scene->buffers_dirty = false;
+
     // Bind the first vertex buffer as the active one
     glBindBuffer(GL_ARRAY_BUFFER, renderer->vb_objects[0]);
     // Copy the array of vertex values to the buffer
-    glBufferData(GL_ARRAY_BUFFER, scene->vertices.size() * sizeof(Vec3f),
-        scene->vertices.data(), GL_STATIC_DRAW);
+    if (upload) {
+        glBufferData(GL_ARRAY_BUFFER, scene->vertices.size() * sizeof(Vec3f),
+            scene->vertices.data(), GL_STATIC_DRAW);
+    }
     // Set the buffer as a list of groups of 3 floats, and enable it
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(0);
 
     // Do the same for the second buffer, filling it with the normal vectors
     glBindBuffer(GL_ARRAY_BUFFER, renderer->vb_objects[1]);
-    glBufferData(GL_ARRAY_BUFFER, scene->normals.size() * sizeof(Vec3f),
-        scene->normals.data(), GL_STATIC_DRAW);
+    if (upload) {
+        glBufferData(GL_ARRAY_BUFFER, scene->normals.size() * sizeof(Vec3f),
+            scene->normals.data(), GL_STATIC_DRAW);
+    }
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
     glEnableVertexAttribArray(1);
     
@@ -551,8 +558,8 @@ void Renderer::display() {
             renderer->drawObject(obj, 1);
         }
     } else {
-        for (auto& prm_it : scene->prm_tessellation_start) {
-            renderer->drawPrimitive(prm_it.first);
+        for (Primitive* prm : scene->tessellated_prms) {
+            renderer->drawPrimitive(prm);
         }
     }
 
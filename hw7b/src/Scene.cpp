@@ -15,8 +15,14 @@ PointLight::PointLight(float *position, float *color, float k) {
 }
 
 /* Initializes the scene's data structures. */
-Scene::Scene() : needs_update(default_needs_update) {
-    this->prm_tessellation_start = unordered_map<Primitive*, unsigned int>();
+Scene::Scene() :
+    buffers_dirty(true),
+    needs_update(default_needs_update),
+    last_revision((unsigned int) -1),
+    tessellation_size(0)
+{
+    this->prm_tessellation_start = vector<unsigned int>();
+    this->tessellated_prms = vector<Primitive*>();
     // Scene::objects = vector<Object>();
     this->vertices = vector<Vector3f>();
     this->normals = vector<Vector3f>();
@@ -46,21 +52,41 @@ void Scene::createLights() {
 }
 
 /*
- * Adds a vertex and normal to the respective buffers, calculated from a 
- * parametric (u, v) point on a superquadric's surface.
+ * Writes a vertex and normal to the given slot of the respective buffers,
+ * calculated from a parametric (u, v) point on a superquadric's surface.
  */
-void Scene::generateVertex(Primitive *prm, float u, float v) {
-    this->vertices.push_back(prm->getVertex(u, v));
-    this->normals.push_back(prm->getNormal(this->vertices.back()));
+void Scene::generateVertex(Primitive *prm, float u, float v, unsigned int &i) {
+    this->vertices[i] = prm->getVertex(u, v);
+    this->normals[i] = prm->getNormal(this->vertices[i]);
+    i++;
 }
 
-/* Tesselates a primitive, adding the vertices and normals to their buffers. */
-void Scene::tessellatePrimitive(Primitive *prm) {
-    if (this->prm_tessellation_start.find(prm) != this->prm_tessellation_start.end()) {
+/* Number of buffer entries tessellatePrimitive writes for a primitive. */
+unsigned int Scene::tessellationSize(const Primitive *prm) {
+    unsigned int ures = prm->getPatchX();
+    unsigned int vres = prm->getPatchY();
+    // vres - 2 strips plus the two polar fans
+    unsigned int strips = (vres > 2) ? (vres - 2) * (2 * ures + 2) : 0;
+    return strips + 2 * (ures + 2);
+}
+
+/*
+ * Reserves a range of the vertex buffers for a primitive. The vertices
+ * themselves are generated later by tessellatePrimitive.
+ */
+void Scene::addPrimitive(Primitive *prm) {
+    if (this->prm_tessellation_start[prm->getID()] != no_tessellation) {
         return;
     }
 
-    this->prm_tessellation_start.insert({prm, vertices.size()});
+    this->prm_tessellation_start[prm->getID()] = this->tessellation_size;
+    this->tessellation_size += tessellationSize(prm);
+    this->tessellated_prms.push_back(prm);
+}
+
+/* Tesselates a primitive, filling in its range of the buffers. */
+void Scene::tessellatePrimitive(Primitive *prm) {
+    unsigned int i = this->prm_tessellation_start[prm->getID()];
 
     // Less typing, computation at runtime
     int ures = prm->getPatchX();
@@ -77,14 +103,14 @@ void Scene::tessellatePrimitive(Primitive *prm) {
         // point down in order for the right-hand rule to make the normal
         // point out of the primitive
         u = -M_PI;
-        for (int i = 0; i < ures; i++) {
-            this->generateVertex(prm, u, v + dv);
-            this->generateVertex(prm, u, v);
+        for (int k = 0; k < ures; k++) {
+            this->generateVertex(prm, u, v + dv, i);
+            this->generateVertex(prm, u, v, i);
             u += du;
         }
         // Connect back to the beginning
-        this->generateVertex(prm, -M_PI, v + dv);
-        this->generateVertex(prm, -M_PI, v);
+        this->generateVertex(prm, -M_PI, v + dv, i);
+        this->generateVertex(prm, -M_PI, v, i);
 
         v += dv;
     }
@@ -93,60 +119,111 @@ void Scene::tessellatePrimitive(Primitive *prm) {
     // with a GL_TRIANGLE_FAN centered on the south pole
     u = M_PI;
     v = dv - half_pi;
-    this->generateVertex(prm, u, -half_pi);
-    for (int i = 0; i < ures; i++) {
+    this->generateVertex(prm, u, -half_pi, i);
+    for (int k = 0; k < ures; k++) {
         // U sweeps clockwise to make the normals point out
-        this->generateVertex(prm, u, v);
+        this->generateVertex(prm, u, v, i);
         u -= du;
     }
     // Connect back to the beginning
     u = -M_PI;
-    this->generateVertex(prm, u, v);
+    this->generateVertex(prm, u, v, i);
 
     // Now we tessellate its top by doing the same at the north pole
     v *= -1;
-    this->generateVertex(prm, u, half_pi);
-    for (int i = 0; i < ures; i++) {
+    this->generateVertex(prm, u, half_pi, i);
+    for (int k = 0; k < ures; k++) {
         // U sweeps counterclockwise to make the normals point out
-        this->generateVertex(prm, u, v);
+        this->generateVertex(prm, u, v, i);
         u += du;
     }
     // Connect back to the beginning
     u = M_PI;
-    this->generateVertex(prm, u, v);
+    this->generateVertex(prm, u, v, i);
+
+    assert(i == this->prm_tessellation_start[prm->getID()] + tessellationSize(prm));
 }
 
-void Scene::tessellateObject(Object *obj) {
-    for (auto& child_it : obj->getChildren()) {
-        Renderable* ren = Renderable::get(child_it.second.name);
+/*
+ * Gathers every Primitive below an Object. Objects that are instanced several
+ * times in the hierarchy are only walked once.
+ */
+void Scene::addObject(Object *obj) {
+    if (this->obj_tessellated[obj->getID()]) {
+        return;
+    }
+    this->obj_tessellated[obj->getID()] = true;
+
+    for (const Child& child : obj->getChildren()) {
+        Renderable* ren = Renderable::get(child.id);
         switch (ren->getType()) {
             case OBJ: {
                 Object* obj = dynamic_cast<Object*>(ren);
-                this->tessellateObject(obj);
+                this->addObject(obj);
                 break;
             }
             case PRM: {
                 Primitive* prm = dynamic_cast<Primitive*>(ren);
-                this->tessellatePrimitive(prm);
+                this->addPrimitive(prm);
                 break;
             }
             default:
-                fprintf(stderr, "Scene::tessellateObject ERROR invalid Renderable type %s\n",
+                fprintf(stderr, "Scene::addObject ERROR invalid Renderable type %s\n",
                     toCstr(ren->getType()));
                 exit(1);
         }
     }
 }
 
+/*
+ * Tessellates every gathered Primitive. Each one owns a disjoint range of the
+ * buffers so they are split across threads.
+ */
+void Scene::tessellatePrimitives() {
+    this->vertices.resize(this->tessellation_size);
+    this->normals.resize(this->tessellation_size);
+
+    unsigned int thread_count = thread::hardware_concurrency();
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+    thread_count = min(thread_count, (unsigned int)
+        (this->tessellated_prms.size() / min_prms_per_thread + 1));
+
+    // interleave the primitives so uneven patch counts even out
+    auto tessellate = [this](unsigned int first, unsigned int stride) {
+        for (unsigned int i = first; i < this->tessellated_prms.size(); i += stride) {
+            this->tessellatePrimitive(this->tessellated_prms[i]);
+        }
+    };
+    vector<thread> workers;
+    for (unsigned int t = 1; t < thread_count; t++) {
+        workers.emplace_back(tessellate, t, thread_count);
+    }
+    tessellate(0, thread_count);
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
 /*
  * Regenerates the scene's vertex and normal buffers based on currently selected
- * Renderable
+ * Renderable. Nothing is rebuilt unless a command has changed the scene since
+ * the last update or the rebuild is forced.
  */
-void Scene::update() {
+void Scene::update(bool force) {
+    if (!force && this->last_revision == CommandLine::getRevision()) {
+        return;
+    }
+    this->last_revision = CommandLine::getRevision();
+    this->buffers_dirty = true;
+
+    Timer timer;
     this->root_objs.clear();
-    this->prm_tessellation_start.clear();
-    this->vertices.clear();
-    this->normals.clear();
+    this->prm_tessellation_start.assign(Renderable::getCount(), no_tessellation);
+    this->tessellated_prms.clear();
+    this->tessellation_size = 0;
+    this->obj_tessellated.assign(Renderable::getCount(), false);
 
     // Add each of the objects, then each of the primitives
     // for (uint i = 0; i < objects.size(); i++)
@@ -159,7 +236,7 @@ void Scene::update() {
             case Commands::primitive_get_cmd_id: {
                 Renderable* ren = Renderable::get(cur_state->tokens[1]);
                 assert(ren->getType() == PRM);
-                this->tessellatePrimitive(dynamic_cast<Primitive*>(ren));
+                this->addPrimitive(dynamic_cast<Primitive*>(ren));
                 break;
             }
             case Commands::object_get_cmd_id: {
@@ -175,8 +252,16 @@ void Scene::update() {
         }
     }
 
-    for (Object* obj : root_objs) {
-        this->tessellateObject(obj);
+    for (Object* obj : this->root_objs) {
+        this->addObject(obj);
+    }
+    this->tessellatePrimitives();
+
+    if (CommandLine::timingEnabled()) {
+        printf("[timing] tessellated %u Primitive(s) into %u vertices in %.3f ms\n",
+            (unsigned int) this->tessellated_prms.size(),
+            (unsigned int) this->vertices.size(),
+            timer.elapsedMs());
     }
 }
 
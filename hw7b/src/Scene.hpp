@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <vector>
+#include <thread>
 
 #include <Eigen/Eigen>
 
@@ -54,6 +55,9 @@ struct PointLight {
 // };
 
 static const bool default_needs_update = false;
+static const unsigned int no_tessellation = (unsigned int) -1;
+// tessellation is only split across threads in chunks at least this large
+static const unsigned int min_prms_per_thread = 64;
 
 class Scene {
     public:
@@ -62,7 +66,11 @@ class Scene {
 
         vector<Object *> root_objs;
 
-        unordered_map<Primitive*, unsigned int> prm_tessellation_start;
+        // vertex buffer offset of each tessellated Primitive indexed by
+        // RenderableID (no_tessellation if it isn't part of the scene), and
+        // the tessellated Primitives in buffer order
+        vector<unsigned int> prm_tessellation_start;
+        vector<Primitive*> tessellated_prms;
         // static vector<Object> objects;
         vector<PointLight> lights;
 
@@ -74,14 +82,28 @@ class Scene {
         void createLights();
         int getLightCount();
 
-        void update();
+        // set whenever the vertex and normal buffers are rebuilt so the
+        // renderer knows to upload them again
+        bool buffers_dirty;
+
+        void update(bool force = false);
 
     private:
         bool needs_update;
-
-        void generateVertex(Primitive *prm, float u, float v);
+        unsigned int last_revision;
+        vector<bool> obj_tessellated;
+        unsigned int tessellation_size;
+
+        void generateVertex(
+            Primitive *prm,
+            float u,
+            float v,
+            unsigned int &i);
+        static unsigned int tessellationSize(const Primitive *prm);
+        void addPrimitive(Primitive *prm);
+        void addObject(Object *obj);
         void tessellatePrimitive(Primitive *prm);
-        void tessellateObject(Object *obj);
+        void tessellatePrimitives();
         // static void setupObject(Object *object);
 };
 
@@ -11,6 +11,7 @@
 #include <stack>
 #include <queue>
 #include <algorithm>
+#include <chrono>
 
 #include "commands.hpp"
 
@@ -29,22 +30,48 @@ public:
     char argv[cmd_line_buffer_len];
     vector<char*> tokens;
 
-    Line(char* argv);
+    Line(const char* argv);
     ~Line();
 
+    // re-tokenizes the Line in place so one Line can be reused for every
+    // command read
+    void reset(const char* argv);
+
     const int toCommandID() const;
     const Command& toCommand() const;
 };
 
+// wall clock timer for the timing reports
+struct Timer {
+    chrono::steady_clock::time_point start;
+
+    Timer() : start(chrono::steady_clock::now()) {}
+
+    double elapsedMs() const {
+        return chrono::duration<double, milli>(
+            chrono::steady_clock::now() - start).count();
+    }
+};
+
 class CommandLine {
 private:
 
     static CommandLine* cmd_line;
 
     bool running;
+    bool timing;
     stack<Line*> state;
 
-    vector<const Line*> history;
+    // successful commands stored back to back, one per line
+    vector<char> history;
+
+    // scratch Lines reused for commands that don't change the state, one per
+    // level of nested sourcing
+    vector<Line*> scratch_lines;
+    unsigned int read_depth;
+
+    // bumped whenever a command may have changed the scene
+    unsigned int revision;
 
     explicit CommandLine();
     ~CommandLine();
@@ -59,9 +86,14 @@ public:
     static const Line* getState();
     static void clearState();
 
-    static const vector<const Line*>& getHistory();
+    static const vector<char>& getHistory();
     static void clearHistory();
 
+    static unsigned int getRevision();
+
+    static bool timingEnabled();
+    static void setTiming(bool timing);
+
     static void readLine(istream& input);
 };
 
@@ -79,6 +79,9 @@ namespace Commands {
     static const int interact_cmd_id                = 3;
     static const int source_cmd_id                  = 4;
     static const int save_cmd_id                    = 5;
+    static const int timing_cmd_id                  = 6;
+    static const int stress_cmd_id                  = 7;
+    static const int mesh_cmd_id                    = 8;
     // selection and modifications of Renderables
     static const int deselect_cmd_id                = 99;
     // primitive
@@ -117,6 +120,13 @@ namespace Commands {
             {CommandName("source"),         source_cmd_id},
             {CommandName("load"),           source_cmd_id},
             {CommandName("save"),           save_cmd_id},
+            {CommandName("timing"),         timing_cmd_id},
+            {CommandName("time"),           timing_cmd_id},
+            {CommandName("stress"),         stress_cmd_id},
+            {CommandName("generate"),       stress_cmd_id},
+            {CommandName("gen"),            stress_cmd_id},
+            {CommandName("mesh"),           mesh_cmd_id},
+            {CommandName("export"),         mesh_cmd_id},
             // selection and modifications of Renderables
             {CommandName("deselect"),       deselect_cmd_id},
             // primitive
@@ -184,6 +194,9 @@ namespace Commands {
     bool interact(int argc, char** argv);
     bool source(int argc, char** argv);
     bool save(int argc, char** argv);
+    bool timing(int argc, char** argv);
+    bool stress(int argc, char** argv);
+    bool mesh(int argc, char** argv);
     // selection and modifications of Renderables
     bool deselect(int argc, char** argv);
     // primitive
@@ -220,6 +233,9 @@ namespace Commands {
         {interact_cmd_id,                Command(DEFAULT, 1, 1, &interact)},
         {source_cmd_id,                  Command(DEFAULT, 1, 2, &source)},
         {save_cmd_id,                    Command(DEFAULT, 1, 2, &save)},
+        {timing_cmd_id,                  Command(DEFAULT, 1, 2, &timing)},
+        {stress_cmd_id,                  Command(DEFAULT, 5, 6, &stress)},
+        {mesh_cmd_id,                    Command(DEFAULT, 1, 3, &mesh)},
         // selection and modifications of Renderables
         {deselect_cmd_id,                Command(DEFAULT, 1, 1, &deselect)},
         // primitive
@@ -274,14 +290,40 @@ behavior:           loads a scene stored in a .scn file. if no file is\n\
                     file can be found and loaded, no action is taken.\n\
 expected arguments: [filename]\n\n\
 NOTE: loading a file will clear all current scene information. make sure to save\n\
-any progress before loading a scene\n")},
+any progress before loading a scene. files ending in .scnb are loaded as binary\n\
+snapshots (see save)\n")},
 
         {save_cmd_id, new HelpInfo(CommandName("save"), "\
 behavior:           saves the current scene into a .scn file in the data\n\
                     directory. if no filename is specified, the current scene is\n\
                     saved into data/quicksave.scn\n\
 expected arguments: [filename]\n\n\
-NOTE: saving to a pre-existing file will overwrite the data\n")},
+NOTE: saving to a pre-existing file will overwrite the data. if the filename ends\n\
+in .scnb the Renderables are saved as a binary snapshot which loads without\n\
+replaying any commands\n")},
+
+        {timing_cmd_id, new HelpInfo(CommandName("timing"), "\
+behavior:           toggles printing how long every command and every scene\n\
+                    rebuild takes. 'on' or 'off' sets it explicitly\n\
+expected arguments: [on/off]\n")},
+
+        {stress_cmd_id, new HelpInfo(CommandName("stress"), "\
+behavior:           generates a large scene for stress testing. 'grid' creates\n\
+                    an Object with nx * ny * nz distinct Primitives. 'fractal'\n\
+                    creates depth nested Objects that each instance the level\n\
+                    below branching times\n\
+expected arguments: grid [name] [nx] [ny] [nz]\n\
+                    fractal [name] [depth] [branching] (all counts must be\n\
+                    positive integral values)\n\n\
+NOTE: every generated Renderable name starts with [name]\n")},
+
+        {mesh_cmd_id, new HelpInfo(CommandName("mesh"), "\
+behavior:           writes the currently selected Renderable as one watertight\n\
+                    triangle mesh into a .obj file. if no filename is specified\n\
+                    the mesh is written into data/mesh.obj. resolution is the\n\
+                    number of cells along the longest side of the Renderable\n\
+                    (128 by default). must have a Renderable selected\n\
+expected arguments: [filename] [resolution]\n")},
 
         // selection and modifications of Renderables
         {deselect_cmd_id, new HelpInfo(CommandName("deselect"), "\
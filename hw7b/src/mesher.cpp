@@ -0,0 +1,609 @@
+#include "mesher.hpp"
+#include "Assignment.hpp"
+#include "command_line.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <float.h>
+#include <map>
+#include <stdint.h>
+#include <thread>
+#include <unordered_map>
+
+/********************************* Primitives *********************************/
+
+/*
+ * A Primitive instance flattened out of the hierarchy. io takes points from
+ * world space into the space where the instance is the unit superquadric
+ * (coefficients included).
+ */
+struct MeshPrimitive {
+    IOPrimitive io;
+    // exp1 / 2, raising the inside-outside function to this power makes it
+    // grow linearly with the distance from the center
+    float radial;
+    // superquadrics with both exponents at most 2 are convex
+    bool convex;
+    AlignedBox3f bounds;
+};
+
+/*
+ * Flattens the Primitives below ren. to_world and from_world are the
+ * transformation from ren's space into world space and its inverse, both
+ * composed step by step so nothing is ever inverted numerically.
+ */
+static void gatherPrimitives(
+    const Renderable* ren,
+    const affine_transform<float>& to_world,
+    const affine_transform<float>& from_world,
+    unsigned int depth,
+    vector<MeshPrimitive>& prms)
+{
+    if (depth > mesh_max_depth) {
+        return;
+    }
+
+    if (ren->getType() == OBJ) {
+        const Object* obj = dynamic_cast<const Object*>(ren);
+        transform_chain<float> overall =
+            get_transform_chain(obj->getOverallTransformation());
+        affine_transform<float> obj_to_world = to_world * overall.product;
+        affine_transform<float> world_to_obj = overall.inverse * from_world;
+        for (const Child& child : obj->getChildren()) {
+            transform_chain<float> chain =
+                get_transform_chain(child.transformations);
+            gatherPrimitives(
+                Renderable::get(child.id),
+                obj_to_world * chain.product,
+                chain.inverse * world_to_obj,
+                depth + 1,
+                prms);
+        }
+        return;
+    }
+
+    const Primitive* prm = dynamic_cast<const Primitive*>(ren);
+    const Vector3f& coeff = prm->getCoeff();
+    float e = prm->getExp0();
+    float n = prm->getExp1();
+    // degenerate superquadrics have no inside
+    if (coeff.minCoeff() <= 0.0 || e <= 0.0 || n <= 0.0) {
+        return;
+    }
+
+    MeshPrimitive mesh_prm;
+    mesh_prm.io = makeIOPrimitive(prm,
+        prescaled(from_world, 1 / coeff[0], 1 / coeff[1], 1 / coeff[2]));
+    mesh_prm.radial = n / 2.0;
+    mesh_prm.convex = e <= 2.0 && n <= 2.0;
+
+    // every superquadric fits in the box spanned by its coefficients
+    mesh_prm.bounds.setEmpty();
+    for (int corner = 0; corner < 8; corner++) {
+        Vector3f p(
+            (corner & 1) ? coeff[0] : -coeff[0],
+            (corner & 2) ? coeff[1] : -coeff[1],
+            (corner & 4) ? coeff[2] : -coeff[2]);
+        mesh_prm.bounds.extend(to_world.transform_point(p));
+    }
+    prms.push_back(mesh_prm);
+}
+
+/*
+ * Signed field of a single superquadric at a point in its unit space, negative
+ * inside. Outside of the unit cube the largest coordinate is used instead,
+ * which has the same sign and never overflows for sharp exponents.
+ */
+static inline float fieldValue(
+    const MeshPrimitive& prm,
+    float x,
+    float y,
+    float z)
+{
+    float bound = max(fabsf(x), max(fabsf(y), fabsf(z)));
+    if (bound >= 1.0) {
+        return bound - 1.0;
+    }
+    return powf(insideOutside(prm.io, x, y, z), prm.radial) - 1.0;
+}
+
+static inline float fieldValue(const MeshPrimitive& prm, const Vector3f& p) {
+    const float* m = prm.io.inv;
+    return fieldValue(prm,
+        m[0] * p[0] + m[1] * p[1] + m[2] * p[2] + m[3],
+        m[4] * p[0] + m[5] * p[1] + m[6] * p[2] + m[7],
+        m[8] * p[0] + m[9] * p[1] + m[10] * p[2] + m[11]);
+}
+
+/*********************************** Octree ***********************************/
+
+/*
+ * The sampling grid. Grid point (0, 0, 0) sits at origin and the cell counts
+ * are multiples of the block size.
+ */
+struct MeshGrid {
+    Vector3f origin;
+    float cell;
+    int cells[3];
+    int blocks[3];
+};
+
+// the cells [origin, origin + mesh_block_size) along each axis
+struct MeshBlock {
+    int origin[3];
+    vector<unsigned int> prms;
+};
+
+/*
+ * Descends an octree of blocks, keeping only the Primitives whose bounds
+ * touch each node. Nodes no Primitive touches and nodes entirely inside a
+ * convex Primitive hold no surface and are dropped with all their blocks.
+ * The node bounds are padded by one cell since blocks also sample the layer
+ * of grid points before their first cells.
+ */
+static void buildOctree(
+    const vector<MeshPrimitive>& prms,
+    const MeshGrid& grid,
+    const int node[3],
+    int size,
+    const vector<unsigned int>& candidates,
+    vector<MeshBlock>& blocks)
+{
+    for (int axis = 0; axis < 3; axis++) {
+        if (node[axis] >= grid.blocks[axis]) {
+            return;
+        }
+    }
+
+    AlignedBox3f box;
+    for (int axis = 0; axis < 3; axis++) {
+        int first = node[axis] * mesh_block_size - 1;
+        int last = min(node[axis] + size, grid.blocks[axis]) *
+            mesh_block_size;
+        box.min()[axis] = grid.origin[axis] + first * grid.cell;
+        box.max()[axis] = grid.origin[axis] + last * grid.cell;
+    }
+
+    vector<unsigned int> touching;
+    for (unsigned int p : candidates) {
+        if (prms[p].bounds.intersects(box)) {
+            touching.push_back(p);
+        }
+    }
+    if (touching.empty()) {
+        return;
+    }
+    for (unsigned int p : touching) {
+        if (!prms[p].convex) {
+            continue;
+        }
+        bool inside = true;
+        for (int corner = 0; corner < 8 && inside; corner++) {
+            inside = fieldValue(prms[p], box.corner(
+                (AlignedBox3f::CornerType) corner)) < 0.0;
+        }
+        if (inside) {
+            return;
+        }
+    }
+
+    if (size == 1) {
+        MeshBlock block;
+        for (int axis = 0; axis < 3; axis++) {
+            block.origin[axis] = node[axis] * mesh_block_size;
+        }
+        block.prms.swap(touching);
+        blocks.push_back(block);
+        return;
+    }
+
+    int half = size / 2;
+    for (int octant = 0; octant < 8; octant++) {
+        int child[3] = {
+            node[0] + ((octant & 1) ? half : 0),
+            node[1] + ((octant & 2) ? half : 0),
+            node[2] + ((octant & 4) ? half : 0)
+        };
+        buildOctree(prms, grid, child, half, touching, blocks);
+    }
+}
+
+/****************************** Dual Contouring *******************************/
+
+// grid points sampled along each side of a block, starting one before the
+// block's first cell
+static const int block_points = mesh_block_size + 2;
+// cells a block can place vertices in, its own and the layer before them
+static const int block_cells = mesh_block_size + 1;
+// returned for a cell whose vertex hasn't been placed yet
+static const int no_vertex = -1;
+
+static const int cell_edges[12][2] = {
+    {0, 1}, {2, 3}, {4, 5}, {6, 7},
+    {0, 2}, {1, 3}, {4, 6}, {5, 7},
+    {0, 4}, {1, 5}, {2, 6}, {3, 7}
+};
+
+/*
+ * The surface within one block. Every vertex belongs to a grid cell. A block
+ * reaches its own cells and the layer of cells just before them, so the cells
+ * on either side of a block's lower faces are reached by two or more blocks.
+ * Those carry the z block index of the block owning the cell and are merged
+ * when written. Cells only this block reaches have a shared layer of -1.
+ */
+struct BlockMesh {
+    vector<uint64_t> cells;
+    vector<int> shared_layers;
+    vector<Vector3f> positions;
+    vector<Vector3f> normals;
+    vector<unsigned int> triangles;
+};
+
+static inline int pointIndex(int i, int j, int k) {
+    return (k * block_points + j) * block_points + i;
+}
+
+static inline int cellIndex(int i, int j, int k) {
+    return (k * block_cells + j) * block_cells + i;
+}
+
+static void sampleBlock(
+    const vector<MeshPrimitive>& prms,
+    const MeshGrid& grid,
+    const MeshBlock& block,
+    vector<float>& samples)
+{
+    samples.assign(block_points * block_points * block_points, FLT_MAX);
+    float xs[block_points];
+    for (int i = 0; i < block_points; i++) {
+        xs[i] = grid.origin[0] +
+            (block.origin[0] - 1 + i) * grid.cell;
+    }
+
+    for (unsigned int p : block.prms) {
+        const MeshPrimitive& prm = prms[p];
+        const float* m = prm.io.inv;
+        for (int k = 0; k < block_points; k++) {
+            float z = grid.origin[2] + (block.origin[2] - 1 + k) * grid.cell;
+            for (int j = 0; j < block_points; j++) {
+                float y = grid.origin[1] +
+                    (block.origin[1] - 1 + j) * grid.cell;
+                float* row = &samples[pointIndex(0, j, k)];
+                for (int i = 0; i < block_points; i++) {
+                    float value = fieldValue(prm,
+                        m[0] * xs[i] + m[1] * y + m[2] * z + m[3],
+                        m[4] * xs[i] + m[5] * y + m[6] * z + m[7],
+                        m[8] * xs[i] + m[9] * y + m[10] * z + m[11]);
+                    row[i] = min(row[i], value);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Places the vertex of a cell at the mass point of the surface crossings on
+ * its edges, with the normal taken from the trilinear gradient of the samples.
+ */
+static int placeVertex(
+    const MeshGrid& grid,
+    const MeshBlock& block,
+    const vector<float>& samples,
+    int i,
+    int j,
+    int k,
+    vector<int>& cell_vertices,
+    BlockMesh& mesh)
+{
+    int& vertex = cell_vertices[cellIndex(i, j, k)];
+    if (vertex != no_vertex) {
+        return vertex;
+    }
+
+    float s[8];
+    for (int corner = 0; corner < 8; corner++) {
+        s[corner] = samples[pointIndex(
+            i + (corner & 1), j + ((corner >> 1) & 1), k + ((corner >> 2) & 1))];
+    }
+
+    Vector3f mass_point(0.0, 0.0, 0.0);
+    int crossings = 0;
+    for (int e = 0; e < 12; e++) {
+        int c0 = cell_edges[e][0];
+        int c1 = cell_edges[e][1];
+        if ((s[c0] < 0.0) == (s[c1] < 0.0)) {
+            continue;
+        }
+        float t = s[c0] / (s[c0] - s[c1]);
+        Vector3f p0(c0 & 1, (c0 >> 1) & 1, (c0 >> 2) & 1);
+        Vector3f p1(c1 & 1, (c1 >> 1) & 1, (c1 >> 2) & 1);
+        mass_point += p0 + t * (p1 - p0);
+        crossings++;
+    }
+    mass_point /= crossings;
+
+    float u = mass_point[0];
+    float v = mass_point[1];
+    float w = mass_point[2];
+    Vector3f normal(
+        (1 - v) * (1 - w) * (s[1] - s[0]) + v * (1 - w) * (s[3] - s[2]) +
+            (1 - v) * w * (s[5] - s[4]) + v * w * (s[7] - s[6]),
+        (1 - u) * (1 - w) * (s[2] - s[0]) + u * (1 - w) * (s[3] - s[1]) +
+            (1 - u) * w * (s[6] - s[4]) + u * w * (s[7] - s[5]),
+        (1 - u) * (1 - v) * (s[4] - s[0]) + u * (1 - v) * (s[5] - s[1]) +
+            (1 - u) * v * (s[6] - s[2]) + u * v * (s[7] - s[3]));
+    if (normal.squaredNorm() > 0.0) {
+        normal.normalize();
+    } else {
+        normal = Vector3f(0.0, 0.0, 1.0);
+    }
+
+    int global[3] = {
+        block.origin[0] - 1 + i,
+        block.origin[1] - 1 + j,
+        block.origin[2] - 1 + k
+    };
+    Vector3f position;
+    for (int axis = 0; axis < 3; axis++) {
+        position[axis] = grid.origin[axis] +
+            (global[axis] + mass_point[axis]) * grid.cell;
+    }
+
+    // cells are offset by one so the layer before the grid has a key too
+    uint64_t key = ((uint64_t) (global[2] + 1) * (grid.cells[1] + 2) +
+        (global[1] + 1)) * (grid.cells[0] + 2) + (global[0] + 1);
+    bool interior = true;
+    for (int local : {i, j, k}) {
+        interior = interior && local >= 1 && local < block_cells - 1;
+    }
+
+    vertex = mesh.cells.size();
+    mesh.cells.push_back(key);
+    mesh.shared_layers.push_back(interior ? -1 :
+        (global[2] + (int) mesh_block_size) / (int) mesh_block_size - 1);
+    mesh.positions.push_back(position);
+    mesh.normals.push_back(normal);
+    return vertex;
+}
+
+/*
+ * Emits a quad for every grid edge owned by the block that the surface
+ * crosses, joining the vertices of the four cells around the edge. An edge is
+ * owned by the block holding its lower end point.
+ */
+static void meshBlock(
+    const vector<MeshPrimitive>& prms,
+    const MeshGrid& grid,
+    const MeshBlock& block,
+    vector<float>& samples,
+    vector<int>& cell_vertices,
+    BlockMesh& mesh)
+{
+    mesh.cells.clear();
+    mesh.shared_layers.clear();
+    mesh.positions.clear();
+    mesh.normals.clear();
+    mesh.triangles.clear();
+
+    sampleBlock(prms, grid, block, samples);
+    cell_vertices.assign(block_cells * block_cells * block_cells, no_vertex);
+
+    const int last = mesh_block_size;
+    for (int axis = 0; axis < 3; axis++) {
+        // the other two axes in right handed order
+        int b = (axis + 1) % 3;
+        int c = (axis + 2) % 3;
+        int step[3] = {0, 0, 0};
+        step[axis] = 1;
+
+        int p[3];
+        for (p[2] = 1; p[2] <= last; p[2]++) {
+            for (p[1] = 1; p[1] <= last; p[1]++) {
+                for (p[0] = 1; p[0] <= last; p[0]++) {
+                    float s0 = samples[pointIndex(p[0], p[1], p[2])];
+                    float s1 = samples[pointIndex(
+                        p[0] + step[0], p[1] + step[1], p[2] + step[2])];
+                    if ((s0 < 0.0) == (s1 < 0.0)) {
+                        continue;
+                    }
+
+                    // the four cells around the edge, counterclockwise when
+                    // seen from the positive end of the axis
+                    int quad[4];
+                    for (int corner = 0; corner < 4; corner++) {
+                        int cell[3] = {p[0], p[1], p[2]};
+                        cell[b] -= (corner == 0 || corner == 3);
+                        cell[c] -= (corner == 0 || corner == 1);
+                        quad[corner] = placeVertex(grid, block, samples,
+                            cell[0], cell[1], cell[2], cell_vertices, mesh);
+                    }
+                    // face away from the inside
+                    if (s0 >= 0.0) {
+                        swap(quad[1], quad[3]);
+                    }
+                    unsigned int triangles[6] = {
+                        (unsigned int) quad[0],
+                        (unsigned int) quad[1],
+                        (unsigned int) quad[2],
+                        (unsigned int) quad[0],
+                        (unsigned int) quad[2],
+                        (unsigned int) quad[3]
+                    };
+                    mesh.triangles.insert(
+                        mesh.triangles.end(), triangles, triangles + 6);
+                }
+            }
+        }
+    }
+}
+
+/********************************* OBJ Output *********************************/
+
+/*
+ * Streams block meshes out in order, merging the vertices of cells that more
+ * than one block reached. Blocks are written in z, y, x order so a shared cell
+ * can only be reached again from the next z layer of blocks, and the merge
+ * maps of older layers are dropped.
+ */
+struct ObjWriter {
+    FILE* file;
+    unsigned int vertex_count;
+    unsigned int triangle_count;
+    map<int, unordered_map<uint64_t, unsigned int>> shared;
+    vector<unsigned int> indices;
+
+    unsigned int writeVertex(const BlockMesh& mesh, unsigned int v) {
+        const Vector3f& p = mesh.positions[v];
+        const Vector3f& n = mesh.normals[v];
+        fprintf(this->file, "v %g %g %g\nvn %g %g %g\n",
+            p[0], p[1], p[2], n[0], n[1], n[2]);
+        return ++this->vertex_count;
+    }
+
+    void write(const BlockMesh& mesh, int layer) {
+        while (!this->shared.empty() && this->shared.begin()->first < layer - 1) {
+            this->shared.erase(this->shared.begin());
+        }
+
+        this->indices.resize(mesh.cells.size());
+        for (unsigned int v = 0; v < mesh.cells.size(); v++) {
+            if (mesh.shared_layers[v] < 0) {
+                this->indices[v] = this->writeVertex(mesh, v);
+                continue;
+            }
+            unordered_map<uint64_t, unsigned int>& merged =
+                this->shared[mesh.shared_layers[v]];
+            unordered_map<uint64_t, unsigned int>::iterator merged_it =
+                merged.find(mesh.cells[v]);
+            if (merged_it != merged.end()) {
+                this->indices[v] = merged_it->second;
+            } else {
+                this->indices[v] = this->writeVertex(mesh, v);
+                merged.insert({mesh.cells[v], this->indices[v]});
+            }
+        }
+
+        for (unsigned int t = 0; t < mesh.triangles.size(); t += 3) {
+            unsigned int a = this->indices[mesh.triangles[t]];
+            unsigned int b = this->indices[mesh.triangles[t + 1]];
+            unsigned int c = this->indices[mesh.triangles[t + 2]];
+            fprintf(this->file, "f %u//%u %u//%u %u//%u\n", a, a, b, b, c, c);
+        }
+        this->triangle_count += mesh.triangles.size() / 3;
+    }
+};
+
+bool Mesher::meshToObj(
+    const Name& name,
+    const char* filename,
+    unsigned int resolution)
+{
+    const Renderable* ren = Renderable::get(name);
+    if (!ren) {
+        fprintf(stderr, "Mesher::meshToObj ERROR Renderable with name %s does not exist\n",
+            name.name);
+        return false;
+    }
+    if (resolution == 0 || resolution > max_mesh_resolution) {
+        fprintf(stderr, "Mesher::meshToObj ERROR resolution must be between 1 and %u\n",
+            max_mesh_resolution);
+        return false;
+    }
+
+    Timer timer;
+    vector<MeshPrimitive> prms;
+    gatherPrimitives(ren, affine_transform<float>(),
+        affine_transform<float>(), 0, prms);
+    if (prms.empty()) {
+        fprintf(stderr, "Mesher::meshToObj ERROR %s holds no Primitives to mesh\n",
+            name.name);
+        return false;
+    }
+
+    // leave two empty cells around the bounds so the surface never touches
+    // the edge of the grid
+    AlignedBox3f bounds;
+    bounds.setEmpty();
+    for (const MeshPrimitive& prm : prms) {
+        bounds.extend(prm.bounds);
+    }
+    MeshGrid grid;
+    grid.cell = bounds.sizes().maxCoeff() / resolution;
+    grid.origin = bounds.min() - Vector3f::Constant(2.0 * grid.cell);
+    int octree_size = 1;
+    for (int axis = 0; axis < 3; axis++) {
+        int cells = (int) ceil(bounds.sizes()[axis] / grid.cell) + 4;
+        grid.blocks[axis] = (cells + mesh_block_size - 1) / mesh_block_size;
+        grid.cells[axis] = grid.blocks[axis] * mesh_block_size;
+        while (octree_size < grid.blocks[axis]) {
+            octree_size *= 2;
+        }
+    }
+
+    vector<unsigned int> all_prms(prms.size());
+    for (unsigned int p = 0; p < prms.size(); p++) {
+        all_prms[p] = p;
+    }
+    vector<MeshBlock> blocks;
+    int root[3] = {0, 0, 0};
+    buildOctree(prms, grid, root, octree_size, all_prms, blocks);
+    sort(blocks.begin(), blocks.end(),
+        [](const MeshBlock& lhs, const MeshBlock& rhs) {
+            for (int axis = 2; axis >= 0; axis--) {
+                if (lhs.origin[axis] != rhs.origin[axis]) {
+                    return lhs.origin[axis] < rhs.origin[axis];
+                }
+            }
+            return false;
+        });
+
+    ObjWriter writer;
+    writer.file = fopen(filename, "w");
+    if (!writer.file) {
+        fprintf(stderr, "Mesher::meshToObj ERROR couldn't open file %s\n",
+            filename);
+        return false;
+    }
+    setvbuf(writer.file, NULL, _IOFBF, 1 << 20);
+    writer.vertex_count = 0;
+    writer.triangle_count = 0;
+    fprintf(writer.file, "# %s meshed at %d x %d x %d cells\n",
+        name.name, grid.cells[0], grid.cells[1], grid.cells[2]);
+
+    unsigned int thread_count = max(1u, thread::hardware_concurrency());
+    vector<BlockMesh> meshes(mesh_block_window);
+    for (size_t first = 0; first < blocks.size(); first += mesh_block_window) {
+        size_t count = min((size_t) mesh_block_window, blocks.size() - first);
+
+        atomic<size_t> next_block(0);
+        auto mesh = [&]() {
+            vector<float> samples;
+            vector<int> cell_vertices;
+            size_t b;
+            while ((b = next_block++) < count) {
+                meshBlock(prms, grid, blocks[first + b], samples,
+                    cell_vertices, meshes[b]);
+            }
+        };
+        vector<thread> workers;
+        for (unsigned int t = 1; t < min((size_t) thread_count, count); t++) {
+            workers.emplace_back(mesh);
+        }
+        mesh();
+        for (thread& worker : workers) {
+            worker.join();
+        }
+
+        for (size_t b = 0; b < count; b++) {
+            writer.write(meshes[b], blocks[first + b].origin[2] / mesh_block_size);
+        }
+    }
+    fclose(writer.file);
+
+    printf("meshed %s into %u vertices and %u triangles from %u of %u blocks in %.3f ms\n",
+        name.name, writer.vertex_count, writer.triangle_count,
+        (unsigned int) blocks.size(),
+        (unsigned int) (grid.blocks[0] * grid.blocks[1] * grid.blocks[2]),
+        timer.elapsedMs());
+    return true;
+}
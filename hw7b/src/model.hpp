@@ -99,9 +99,18 @@ inline const char* toCstr(RenderableType type) {
     }
 }
 
+// dense handle assigned to every Renderable when it is created. names are only
+// resolved to handles at the command line boundary so scene traversals never
+// have to hash a Name
+typedef unsigned int RenderableID;
+static const RenderableID invalid_renderable_id = (RenderableID) -1;
+
 class Renderable {
 private:
     static unordered_map<Name, Renderable*, NameHasher> renderables;
+    static vector<Renderable*> handles;
+
+    RenderableID id;
 
 protected:
     explicit Renderable();
@@ -109,16 +118,30 @@ protected:
 
 public:
     // static instance controller functions
-    static Renderable* create(RenderableType type, const Name& name);
+    static Renderable* create(
+        RenderableType type,
+        const Name& name,
+        bool verbose = true);
     static Renderable* get(const Name& name);
+    static Renderable* get(RenderableID id);
     static bool exists(const Name& name);
     static void clear();
+    static void reserve(size_t count);
+    static unsigned int getCount();
     static const unordered_map<Name, Renderable*, NameHasher>&
         getActiveRenderables();
 
     virtual const RenderableType getType() const = 0;
+    const RenderableID getID() const;
 };
 
+inline Renderable* Renderable::get(RenderableID id) {
+    return handles[id];
+}
+inline const RenderableID Renderable::getID() const {
+    return this->id;
+}
+
 // class for Primitive information from <modeling language>
 // default values
 static const float default_coeff_x = 1.0;
@@ -194,11 +217,13 @@ public:
 };
 
 struct Child {
+    Name alias;
     Name name;
+    RenderableID id;
     vector<Transformation> transformations;
 
     Child();
-    Child(const Name& name);
+    Child(const Name& alias, const Name& name, RenderableID id);
 };
 
 static const Name default_cursor("[NONE]");
@@ -210,8 +235,10 @@ private:
     // overall transformation
     vector<Transformation> transformations;
 
-    // all child objects and primitives
-    unordered_map<Name, Child, NameHasher> children;    // FIX HERE typedef this stuff
+    // all child objects and primitives in the order they were added, indexed
+    // by alias for the cursor commands
+    vector<Child> children;
+    unordered_map<Name, unsigned int, NameHasher> child_indices;
 
     // vector< pair<Name, vector<Transformation> > > children_obj;
     // vector< pair<Name, vector<Transformation> > > children_prm;
@@ -245,11 +272,13 @@ public:
         const float z,
         const float theta);
     void overallScale(const float x, const float y, const float z);
+    void overallTransform(const Transformation& trans);
     const vector<Transformation>& getOverallTransformation() const;
 
     // children objects and primitives
     void addChild(const Name& name, const Name& alias);
-    const unordered_map<Name, Child, NameHasher>& getChildren() const;
+    const vector<Child>& getChildren() const;
+    const Child* getChild(const Name& alias) const;
 
     // cursor for modifying children
     void setCursor(const Name& alias);
@@ -263,6 +292,7 @@ public:
         const float z,
         const float theta);
     void cursorScale(const float x, const float y, const float z);
+    void cursorTransform(const Transformation& trans);
 };
 
 inline void printIndent(int indent) {
@@ -271,6 +301,10 @@ inline void printIndent(int indent) {
     }
 }
 
+// lists longer than this are cut short by the print functions
+static const unsigned int info_list_limit = 64;
+
+void printInfoOverflow(unsigned int unlisted, int indent);
 void printSceneInfo(int indent);
 void printInfo(const Renderable* ren, int indent);
 void printInfo(const RGBf& color, int indent);
@@ -0,0 +1,250 @@
+#include "stress.hpp"
+
+#include <string.h>
+
+/*
+ * Checks that a generated name is free. The generators check every name they
+ * will use before creating anything, so a collision never leaves a partial
+ * scene behind.
+ */
+static bool validateName(const char* name) {
+    if (Renderable::exists(name)) {
+        fprintf(stderr, "Stress ERROR Renderable with name %s already exists\n",
+            name);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Makes sure none of the generated names overflow a Name and that the root
+ * doesn't already exist.
+ */
+static bool validateRootName(const char* name) {
+    // leave room for the longest generated suffix ("_p" + 10 digits)
+    if (strlen(name) + 13 > name_buffer_size) {
+        fprintf(stderr, "Stress ERROR name %s is too long\n", name);
+        return false;
+    }
+    return validateName(name);
+}
+
+static Primitive* createPrimitive(const char* name) {
+    Primitive* prm = dynamic_cast<Primitive*>(
+        Renderable::create(PRM, name, false));
+    if (prm) {
+        prm->setPatch(stress_patch, stress_patch);
+    }
+    return prm;
+}
+
+bool Stress::generateGrid(
+    const char* name,
+    unsigned int nx,
+    unsigned int ny,
+    unsigned int nz)
+{
+    unsigned long count = (unsigned long) nx * ny * nz;
+    if (count == 0 || count > stress_max_primitives) {
+        fprintf(stderr, "Stress::generateGrid ERROR grid must hold between 1 and %lu Primitives\n",
+            stress_max_primitives);
+        return false;
+    }
+    if (!validateRootName(name)) {
+        return false;
+    }
+    char prm_name[name_buffer_size];
+    for (unsigned long i = 0; i < count; i++) {
+        snprintf(prm_name, name_buffer_size, "%s_p%lu", name, i);
+        if (!validateName(prm_name)) {
+            return false;
+        }
+    }
+
+    Renderable::reserve(Renderable::getCount() + count + 1);
+    Object* root = dynamic_cast<Object*>(Renderable::create(OBJ, name, false));
+
+    unsigned int i = 0;
+    for (unsigned int x = 0; x < nx; x++) {
+        for (unsigned int y = 0; y < ny; y++) {
+            for (unsigned int z = 0; z < nz; z++, i++) {
+                snprintf(prm_name, name_buffer_size, "%s_p%u", name, i);
+                Primitive* prm = createPrimitive(prm_name);
+                if (!prm) {
+                    return false;
+                }
+
+                // sweep the shapes and colors across the grid so neighbouring
+                // primitives differ
+                float fx = (nx > 1) ? (float) x / (nx - 1) : 0.5;
+                float fy = (ny > 1) ? (float) y / (ny - 1) : 0.5;
+                float fz = (nz > 1) ? (float) z / (nz - 1) : 0.5;
+                prm->setCoeff(0.4, 0.4, 0.4);
+                prm->setExponents(0.2 + 1.8 * fx, 0.2 + 1.8 * fy);
+                prm->setColor(fx, fy, fz);
+
+                root->addChild(prm_name, prm_name);
+                root->cursorTranslate(
+                    x - 0.5 * (nx - 1),
+                    y - 0.5 * (ny - 1),
+                    z - 0.5 * (nz - 1));
+            }
+        }
+    }
+
+    // fit the grid into the default view
+    unsigned int longest = max(nx, max(ny, nz));
+    root->overallScale(2.0 / longest, 2.0 / longest, 2.0 / longest);
+    return true;
+}
+
+bool Stress::generateFractal(
+    const char* name,
+    unsigned int depth,
+    unsigned int branching)
+{
+    if (depth == 0 || depth > stress_max_depth) {
+        fprintf(stderr, "Stress::generateFractal ERROR depth must be between 1 and %u\n",
+            stress_max_depth);
+        return false;
+    }
+    if (branching == 0) {
+        fprintf(stderr, "Stress::generateFractal ERROR branching must be positive\n");
+        return false;
+    }
+    if (!validateRootName(name)) {
+        return false;
+    }
+    char leaf_name[name_buffer_size];
+    char node_name[name_buffer_size];
+    char level_name[name_buffer_size];
+    snprintf(leaf_name, name_buffer_size, "%s_leaf", name);
+    snprintf(node_name, name_buffer_size, "%s_node", name);
+    if (!validateName(leaf_name) || !validateName(node_name)) {
+        return false;
+    }
+    for (unsigned int level = 1; level < depth; level++) {
+        snprintf(level_name, name_buffer_size, "%s_l%u", name, level);
+        if (!validateName(level_name)) {
+            return false;
+        }
+    }
+
+    Renderable::reserve(Renderable::getCount() + depth + 3);
+
+    Primitive* leaf = createPrimitive(leaf_name);
+    Primitive* node = createPrimitive(node_name);
+    if (!leaf || !node) {
+        return false;
+    }
+    leaf->setColor(0.9, 0.4, 0.2);
+    node->setCoeff(0.3, 0.3, 0.3);
+    node->setExponents(0.3, 0.3);
+    node->setColor(0.3, 0.5, 0.9);
+
+    // level 0 is the leaf, every level above holds a node primitive and
+    // branching shrunken copies of the level below. the top level is the root
+    char below_name[name_buffer_size];
+    char alias[name_buffer_size];
+    strcpy(below_name, leaf_name);
+    for (unsigned int level = 1; level <= depth; level++) {
+        if (level == depth) {
+            strcpy(level_name, name);
+        } else {
+            snprintf(level_name, name_buffer_size, "%s_l%u", name, level);
+        }
+        Object* obj = dynamic_cast<Object*>(
+            Renderable::create(OBJ, level_name, false));
+        if (!obj) {
+            return false;
+        }
+
+        obj->addChild(node_name, node_name);
+        for (unsigned int b = 0; b < branching; b++) {
+            snprintf(alias, name_buffer_size, "c%u", b);
+            obj->addChild(below_name, alias);
+            obj->cursorScale(0.5, 0.5, 0.5);
+            obj->cursorTranslate(1.0, 0.0, 0.0);
+            // alternate the branching plane between levels
+            if (level % 2 == 0) {
+                obj->cursorRotate(0.0, 0.0, 1.0, 2.0 * M_PI * b / branching);
+            } else {
+                obj->cursorRotate(0.0, 1.0, 0.0, 2.0 * M_PI * b / branching);
+            }
+        }
+        strcpy(below_name, level_name);
+    }
+    return true;
+}
+
+/*
+ * Counts every Primitive instance the renderer will draw below a Renderable.
+ * Each Object is visited once no matter how often it is instanced.
+ */
+static double countInstances(
+    const Renderable* ren,
+    vector<double>& instances,
+    vector<unsigned int>& depths,
+    vector<bool>& visiting)
+{
+    if (ren->getType() == PRM) {
+        return 1.0;
+    }
+
+    RenderableID id = ren->getID();
+    if (instances[id] >= 0.0) {
+        return instances[id];
+    }
+    // cycles contribute nothing
+    if (visiting[id]) {
+        return 0.0;
+    }
+    visiting[id] = true;
+
+    double count = 0.0;
+    unsigned int depth = 0;
+    const Object* obj = dynamic_cast<const Object*>(ren);
+    for (const Child& child : obj->getChildren()) {
+        const Renderable* child_ren = Renderable::get(child.id);
+        count += countInstances(child_ren, instances, depths, visiting);
+        if (child_ren->getType() == OBJ) {
+            depth = max(depth, depths[child.id]);
+        }
+    }
+
+    visiting[id] = false;
+    instances[id] = count;
+    depths[id] = depth + 1;
+    return count;
+}
+
+void Stress::printStats(const Object* root) {
+    vector<double> instances(Renderable::getCount(), -1.0);
+    vector<unsigned int> depths(Renderable::getCount(), 0);
+    vector<bool> visiting(Renderable::getCount(), false);
+    double count = countInstances(root, instances, depths, visiting);
+
+    unsigned int unique_prms = 0;
+    unsigned int unique_objs = 0;
+    vector<bool> seen(Renderable::getCount(), false);
+    vector<RenderableID> stack(1, root->getID());
+    seen[root->getID()] = true;
+    while (!stack.empty()) {
+        const Renderable* ren = Renderable::get(stack.back());
+        stack.pop_back();
+        if (ren->getType() == PRM) {
+            unique_prms++;
+            continue;
+        }
+        unique_objs++;
+        for (const Child& child : dynamic_cast<const Object*>(ren)->getChildren()) {
+            if (!seen[child.id]) {
+                seen[child.id] = true;
+                stack.push_back(child.id);
+            }
+        }
+    }
+
+    printf("%u unique Primitive(s) and %u Object(s), %.0f Primitive instance(s) drawn, hierarchy depth %u\n",
+        unique_prms, unique_objs, count, depths[root->getID()]);
+}